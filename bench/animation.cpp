@@ -0,0 +1,156 @@
+#include <kame/kame.hpp>
+#include <kame/squirtle/squirtle.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace kame::math;
+using namespace kame::squirtle;
+
+// the per channel switch animate() used before the track kernels, every sampler treated as LINEAR
+static void animateReference(AnimationClip& clip, std::vector<uint32_t>& cursors, std::vector<Node>& nodes, float time)
+{
+    for (size_t k = 0; k < clip.channels.size(); ++k)
+    {
+        auto& c = clip.channels[k];
+        if (c.targetID < 0)
+        {
+            continue;
+        }
+
+        Node& node = nodes[c.targetID];
+
+        auto& s = clip.samplers[c.samplerID];
+        if (s.inputs.empty() || s.inputs.size() > s.outputsVec4.size())
+        {
+            continue;
+        }
+
+        uint32_t i = s.findKey(time, cursors[k]);
+        uint32_t next = std::min(i + 1, uint32_t(s.inputs.size() - 1));
+        float u = 0.0f;
+        if (next != i)
+        {
+            u = std::clamp((time - s.inputs[i]) / (s.inputs[next] - s.inputs[i]), 0.0f, 1.0f);
+        }
+        switch (c.path)
+        {
+            case AnimationClip::Channel::PathType::kTRANSLATION: {
+                auto trans = Vector4::lerp(s.outputsVec4[i], s.outputsVec4[next], u);
+                node.position = Vector3(trans.x, trans.y, trans.z);
+                break;
+            }
+            case AnimationClip::Channel::PathType::kSCALE: {
+                auto scale = Vector4::lerp(s.outputsVec4[i], s.outputsVec4[next], u);
+                node.scale = Vector3(scale.x, scale.y, scale.z);
+                break;
+            }
+            case AnimationClip::Channel::PathType::kROTATION: {
+                auto rot = Quaternion::slerp(s.outputsVec4[i], s.outputsVec4[next], u);
+                node.rotation = Quaternion::normalize(rot);
+                break;
+            }
+        }
+    }
+}
+
+// one translation, rotation and scale channel per node, keys at 30 Hz on sine waves like smooth mocap
+static AnimationClip makeClip(int numNodes, int numKeys, AnimationClip::Sampler::InterpolationType interpolation)
+{
+    uint32_t seed = 1;
+    auto random = [&] {
+        seed = seed * 1664525u + 1013904223u;
+        return float(seed >> 8) / float(1 << 24) * 2.0f - 1.0f;
+    };
+
+    AnimationClip clip;
+    clip.startTime = 0.0f;
+    clip.endTime = float(numKeys - 1) / 30.0f;
+    for (int n = 0; n < numNodes; ++n)
+    {
+        for (auto path : {AnimationClip::Channel::kTRANSLATION, AnimationClip::Channel::kROTATION, AnimationClip::Channel::kSCALE})
+        {
+            float freq[4], phase[4];
+            for (int c = 0; c < 4; ++c)
+            {
+                freq[c] = 0.5f + std::abs(random()) * 2.0f;
+                phase[c] = random() * 3.0f;
+            }
+            auto wave = [&](float t) {
+                return Vector4(std::sin(freq[0] * t + phase[0]), std::sin(freq[1] * t + phase[1]), std::sin(freq[2] * t + phase[2]), 2.0f + std::sin(freq[3] * t + phase[3]));
+            };
+            auto tangent = [&](float t) {
+                return Vector4(freq[0] * std::cos(freq[0] * t + phase[0]), freq[1] * std::cos(freq[1] * t + phase[1]), freq[2] * std::cos(freq[2] * t + phase[2]), freq[3] * std::cos(freq[3] * t + phase[3]));
+            };
+
+            AnimationClip::Sampler s;
+            s.interpolation = interpolation;
+            for (int k = 0; k < numKeys; ++k)
+            {
+                float t = float(k) / 30.0f;
+                s.inputs.emplace_back(t);
+                if (interpolation == AnimationClip::Sampler::kCUBICSPLINE)
+                {
+                    s.outputsVec4.emplace_back(tangent(t));
+                    s.outputsVec4.emplace_back(wave(t));
+                    s.outputsVec4.emplace_back(tangent(t));
+                }
+                else
+                {
+                    s.outputsVec4.emplace_back(path == AnimationClip::Channel::kROTATION ? Vector4::normalize(wave(t)) : wave(t));
+                }
+            }
+            s.analyzeInputs();
+            clip.channels.push_back({n, path, uint32_t(clip.samplers.size())});
+            clip.samplers.emplace_back(std::move(s));
+        }
+    }
+    clip.compile();
+    return clip;
+}
+
+template <typename F>
+static double measure(const char* name, size_t numChannels, int frames, F fn)
+{
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i)
+    {
+        fn(float(i) / 60.0f);
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() / frames;
+    printf("%-22s %10.3f us %10.1f ns/channel\n", name, sec * 1e6, sec * 1e9 / numChannels);
+    return sec;
+}
+
+int main(int argc, char** argv)
+{
+    int numNodes = argc > 1 ? std::stoi(argv[1]) : 1000;
+    const int numKeys = 300;
+    const int frames = 600;
+
+    std::vector<Node> nodes(numNodes);
+    const char* names[] = {"linear", "step", "cubic spline"};
+
+    AnimationClip linear = makeClip(numNodes, numKeys, AnimationClip::Sampler::kLINEAR);
+    std::vector<uint32_t> cursors(linear.channels.size(), 0);
+    double ref = measure("reference linear", linear.channels.size(), frames, [&](float t) { animateReference(linear, cursors, nodes, t); });
+
+    for (auto interpolation : {AnimationClip::Sampler::kLINEAR, AnimationClip::Sampler::kSTEP, AnimationClip::Sampler::kCUBICSPLINE})
+    {
+        AnimationClip clip = makeClip(numNodes, numKeys, interpolation);
+        double sec = measure(names[interpolation], clip.channels.size(), frames, [&](float t) { animate(clip, nodes, t); });
+        printf("%-22s %10.2fx\n", "  vs reference", ref / sec);
+
+        AnimationCompressionStats stats;
+        CompressedAnimationClip compressed = compressAnimation(clip, {}, &stats);
+        std::string name = std::string(names[interpolation]) + " compressed";
+        sec = measure(name.c_str(), clip.channels.size(), frames, [&](float t) { animate(compressed, nodes, t); });
+        printf("%-22s %10.2fx %zu -> %zu bytes, %zu -> %zu keys, max error %g / %g rad / %g\n", "  ratio", stats.ratio,
+               stats.originalBytes, stats.compressedBytes, stats.originalKeys, stats.compressedKeys,
+               stats.maxTranslationError, stats.maxRotationError, stats.maxScaleError);
+    }
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include <kame/kame.hpp>
+
+#include <pystring.h>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// the decoder kame shipped before the table driven one, kept as a baseline
+namespace reference {
+
+int b64ToInt(std::string c)
+{
+    if (pystring::isalpha(c))
+    {
+        if (pystring::isupper(c))
+        {
+            return c[0] - 'A';
+        }
+        else
+        {
+            return c[0] - 'a' + 26;
+        }
+    }
+    else if (pystring::isdigit(c))
+    {
+        return c[0] - '0' + 52;
+    }
+    else if (c == "+")
+    {
+        return 62;
+    }
+    else if (c == "/")
+    {
+        return 63;
+    }
+    else if (c == "=")
+    {
+        return 64;
+    }
+    else
+    {
+        return -1;
+    }
+}
+
+std::vector<uint8_t> decodeBase64(const std::string& str, size_t start)
+{
+    std::vector<uint8_t> data;
+
+    for (size_t i = start; i < str.size(); i += 4)
+    {
+        int decode[4];
+        unsigned int bytes;
+
+        decode[0] = b64ToInt(std::string{str[i + 0]});
+        decode[1] = b64ToInt(std::string{str[i + 1]});
+        decode[2] = b64ToInt(std::string{str[i + 2]});
+        decode[3] = b64ToInt(std::string{str[i + 3]});
+
+        if (decode[2] == 64 && decode[3] == 64)
+        {
+            bytes = (decode[0] << 6 | (decode[1] & 0b11110000)) << 12;
+            data.emplace_back(bytes >> 16);
+        }
+        else if (decode[3] == 64)
+        {
+            bytes = ((decode[0] << 6 | decode[1]) << 6 | (decode[2] & 0b11111100)) << 6;
+            data.emplace_back(bytes >> 16);
+            data.emplace_back(bytes >> 8);
+        }
+        else
+        {
+            bytes = (decode[0] << 6 | decode[1]) << 6 | decode[2];
+            bytes = bytes << 6 | decode[3];
+            data.emplace_back(bytes >> 16);
+            data.emplace_back(bytes >> 8);
+            data.emplace_back(bytes);
+        }
+    }
+
+    return data;
+}
+
+} // namespace reference
+
+static std::string encode(const std::vector<uint8_t>& bytes)
+{
+    const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string str;
+    str.reserve((bytes.size() + 2) / 3 * 4);
+    for (size_t i = 0; i < bytes.size(); i += 3)
+    {
+        size_t n = bytes.size() - i;
+        uint32_t v = bytes[i] << 16 | (n > 1 ? bytes[i + 1] << 8 : 0) | (n > 2 ? bytes[i + 2] : 0);
+        str += alphabet[(v >> 18) & 63];
+        str += alphabet[(v >> 12) & 63];
+        str += n > 1 ? alphabet[(v >> 6) & 63] : '=';
+        str += n > 2 ? alphabet[v & 63] : '=';
+    }
+    return str;
+}
+
+template <typename F>
+static double measure(const char* name, size_t numBytes, int iterations, F fn)
+{
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        fn();
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() / iterations;
+    printf("%-12s %10.3f ms %10.1f MB/s\n", name, sec * 1000.0, numBytes / sec / (1024.0 * 1024.0));
+    return sec;
+}
+
+int main(int argc, char** argv)
+{
+    size_t numBytes = argc > 1 ? std::stoul(argv[1]) : 16 * 1024 * 1024;
+
+    std::vector<uint8_t> bytes(numBytes);
+    uint32_t seed = 1;
+    for (auto& b : bytes)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        b = uint8_t(seed >> 24);
+    }
+    std::string str = encode(bytes);
+
+    std::vector<uint8_t> out;
+    double ref = measure("reference", numBytes, 1, [&] { out = reference::decodeBase64(str, 0); });
+    if (out != bytes)
+    {
+        printf("reference decoder mismatch\n");
+        return 1;
+    }
+
+    double fast = measure("kame", numBytes, 20, [&] { kame::gltf::decodeBase64(str.data(), str.size(), out); });
+    if (out != bytes)
+    {
+        printf("kame decoder mismatch\n");
+        return 1;
+    }
+
+    printf("speedup      %10.1fx\n", ref / fast);
+    return 0;
+}
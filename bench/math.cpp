@@ -0,0 +1,264 @@
+#include <kame/kame.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace kame::math;
+
+// the scalar operators the math types had before simd.hpp, kept as a baseline
+static Matrix multiplyReference(const Matrix& a, const Matrix& b)
+{
+    Matrix m = Matrix::zero();
+    const float* A = (const float*)&a;
+    const float* B = (const float*)&b;
+    float* M = (float*)&m;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            for (int k = 0; k < 4; ++k)
+            {
+                M[4 * i + j] += A[4 * i + k] * B[4 * k + j];
+            }
+        }
+    }
+    return m;
+}
+
+// out of line like Vector3::transform() and Vector4::transform() in src/math
+#if defined(_MSC_VER)
+#define KAME_NOINLINE __declspec(noinline)
+#else
+#define KAME_NOINLINE __attribute__((noinline))
+#endif
+
+KAME_NOINLINE static Vector3 transformReference(Vector3 v, const Matrix& m)
+{
+    float x = (v.x * m.m11) + (v.y * m.m21) + (v.z * m.m31) + m.m41;
+    float y = (v.x * m.m12) + (v.y * m.m22) + (v.z * m.m32) + m.m42;
+    float z = (v.x * m.m13) + (v.y * m.m23) + (v.z * m.m33) + m.m43;
+    return {x, y, z};
+}
+
+KAME_NOINLINE static Vector4 transformReference(Vector4 v, const Matrix& m)
+{
+    float x = (v.x * m.m11) + (v.y * m.m21) + (v.z * m.m31) + (v.w * m.m41);
+    float y = (v.x * m.m12) + (v.y * m.m22) + (v.z * m.m32) + (v.w * m.m42);
+    float z = (v.x * m.m13) + (v.y * m.m23) + (v.z * m.m33) + (v.w * m.m43);
+    float w = (v.x * m.m14) + (v.y * m.m24) + (v.z * m.m34) + (v.w * m.m44);
+    return {x, y, z, w};
+}
+
+static Quaternion multiplyReference(Quaternion a, Quaternion b)
+{
+    // clang-format off
+    return Quaternion(
+        ( b.x * a.w) + (b.y * a.z) - (b.z * a.y) + (b.w * a.x),
+        (-b.x * a.z) + (b.y * a.w) + (b.z * a.x) + (b.w * a.y),
+        ( b.x * a.y) - (b.y * a.x) + (b.z * a.w) + (b.w * a.z),
+        (-b.x * a.x) - (b.y * a.y) - (b.z * a.z) + (b.w * a.w));
+    // clang-format on
+}
+
+template <typename F>
+static double measure(const char* name, size_t count, int iterations, F fn)
+{
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        fn();
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() / iterations;
+    printf("%-26s %10.3f ms %8.2f ns/op\n", name, sec * 1000.0, sec * 1e9 / count);
+    return sec;
+}
+
+int main(int argc, char** argv)
+{
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 4096;
+    const int iterations = 500;
+
+#if defined(KAME_MATH_AVX)
+    printf("math: AVX\n");
+#elif defined(KAME_MATH_SSE2)
+    printf("math: SSE2\n");
+#elif defined(KAME_MATH_NEON)
+    printf("math: NEON\n");
+#else
+    printf("math: scalar\n");
+#endif
+
+    uint32_t seed = 1;
+    auto random = [&] {
+        seed = seed * 1664525u + 1013904223u;
+        return float(seed >> 8) / float(1 << 24) * 2.0f - 1.0f;
+    };
+
+    std::vector<Matrix> a(count), b(count), out(count);
+    std::vector<Vector3> points(count), points2(count);
+    std::vector<Vector4> vectors(count), vectors2(count);
+    std::vector<Quaternion> qa(count), qb(count), qout(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        float* A = (float*)&a[i];
+        float* B = (float*)&b[i];
+        for (int j = 0; j < 16; ++j)
+        {
+            A[j] = random();
+            B[j] = random();
+        }
+        points[i] = Vector3(random(), random(), random());
+        vectors[i] = Vector4(random(), random(), random(), random());
+        qa[i] = Quaternion::normalize(Quaternion(random(), random(), random(), random()));
+        qb[i] = Quaternion::normalize(Quaternion(random(), random(), random(), random()));
+    }
+
+    auto compare = [](const char* name, const float* x, const float* y, size_t n) {
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (x[i] != y[i])
+            {
+                printf("%s mismatch at %zu: %f != %f\n", name, i, x[i], y[i]);
+                return;
+            }
+        }
+    };
+
+    double ref = measure("matrix multiply reference", count, iterations, [&] {
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] = multiplyReference(a[i], b[i]);
+        }
+    });
+    std::vector<Matrix> expected = out;
+    double cur = measure("matrix multiply", count, iterations, [&] {
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] = a[i] * b[i];
+        }
+    });
+    compare("matrix multiply", (const float*)expected.data(), (const float*)out.data(), count * 16);
+    printf("%-26s %10.2fx\n", "speedup", ref / cur);
+
+    ref = measure("transpose reference", count, iterations, [&] {
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Matrix& m = a[i];
+            out[i] = Matrix(m.m11, m.m21, m.m31, m.m41, m.m12, m.m22, m.m32, m.m42, m.m13, m.m23, m.m33, m.m43, m.m14, m.m24, m.m34, m.m44);
+        }
+    });
+    cur = measure("transpose", count, iterations, [&] {
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] = Matrix::transpose(a[i]);
+        }
+    });
+    printf("%-26s %10.2fx\n", "speedup", ref / cur);
+
+    ref = measure("vector3 transform reference", count, iterations, [&] {
+        for (size_t i = 0; i < count; ++i)
+        {
+            points2[i] = transformReference(points[i], a[i]);
+        }
+    });
+    std::vector<Vector3> expectedPoints = points2;
+    cur = measure("vector3 transform", count, iterations, [&] {
+        for (size_t i = 0; i < count; ++i)
+        {
+            points2[i] = Vector3::transform(points[i], a[i]);
+        }
+    });
+    compare("vector3 transform", (const float*)expectedPoints.data(), (const float*)points2.data(), count * 3);
+    printf("%-26s %10.2fx\n", "speedup", ref / cur);
+
+    ref = measure("vector4 transform reference", count, iterations, [&] {
+        for (size_t i = 0; i < count; ++i)
+        {
+            vectors2[i] = transformReference(vectors[i], a[i]);
+        }
+    });
+    std::vector<Vector4> expectedVectors = vectors2;
+    cur = measure("vector4 transform", count, iterations, [&] {
+        for (size_t i = 0; i < count; ++i)
+        {
+            vectors2[i] = Vector4::transform(vectors[i], a[i]);
+        }
+    });
+    compare("vector4 transform", (const float*)expectedVectors.data(), (const float*)vectors2.data(), count * 4);
+    printf("%-26s %10.2fx\n", "speedup", ref / cur);
+
+    ref = measure("quaternion multiply ref", count, iterations, [&] {
+        for (size_t i = 0; i < count; ++i)
+        {
+            qout[i] = multiplyReference(qa[i], qb[i]);
+        }
+    });
+    std::vector<Quaternion> expectedQuaternions = qout;
+    cur = measure("quaternion multiply", count, iterations, [&] {
+        for (size_t i = 0; i < count; ++i)
+        {
+            qout[i] = qa[i] * qb[i];
+        }
+    });
+    compare("quaternion multiply", (const float*)expectedQuaternions.data(), (const float*)qout.data(), count * 4);
+    printf("%-26s %10.2fx\n", "speedup", ref / cur);
+
+    measure("quaternion slerp", count, iterations, [&] {
+        for (size_t i = 0; i < count; ++i)
+        {
+            qout[i] = Quaternion::slerp(qa[i], qb[i], 0.3f);
+        }
+    });
+
+    // batch functions against per element loops over the same operators
+    printf("\n");
+    ref = measure("transform points loop", count, iterations, [&] {
+        for (size_t i = 0; i < count; ++i)
+        {
+            points2[i] = Vector3::transform(points[i], a[0]);
+        }
+    });
+    cur = measure("transformPoints", count, iterations, [&] {
+        transformPoints(points, a[0], points2);
+    });
+    printf("%-26s %10.2fx\n", "speedup", ref / cur);
+
+    ref = measure("compose TRS loop", count, iterations, [&] {
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] = Matrix::createScale(points[i]) * Matrix::createFromQuaternion(qa[i]) * Matrix::createTranslation(points2[i]);
+        }
+    });
+    cur = measure("composeTRS", count, iterations, [&] {
+        composeTRS(points2, qa, points, out);
+    });
+    printf("%-26s %10.2fx\n", "speedup", ref / cur);
+
+    ref = measure("multiply matrices loop", count, iterations, [&] {
+        for (size_t i = 0; i < count; ++i)
+        {
+            out[i] = a[i] * b[0];
+        }
+    });
+    cur = measure("multiplyMatrices", count, iterations, [&] {
+        multiplyMatrices(a, b[0], out);
+    });
+    printf("%-26s %10.2fx\n", "speedup", ref / cur);
+
+    // large enough to stream from memory
+    const size_t numVertices = 1 << 22;
+    std::vector<Vector3> vertices(numVertices, Vector3(0.5f, 0.25f, 0.125f)), transformed(numVertices);
+    double sec = measure("transformPoints 4M", numVertices, 20, [&] {
+        transformPoints(vertices, a[0], transformed);
+    });
+    printf("%-26s %10.2f GB/s\n", "read + write", 2.0 * numVertices * sizeof(Vector3) / sec / 1e9);
+    sec = measure("copy 4M", numVertices, 20, [&] {
+        std::copy(vertices.begin(), vertices.end(), transformed.begin());
+    });
+    printf("%-26s %10.2f GB/s\n", "read + write", 2.0 * numVertices * sizeof(Vector3) / sec / 1e9);
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <kame/kame.hpp>
+#include <kame/squirtle/squirtle.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace kame::math;
+using namespace kame::squirtle;
+
+// the per index matrix blend updateSkinnedMesh used before Skinner, kept as a baseline
+static void skinReference(const SkinnedVertices& v, const std::vector<Matrix>& jointMatrices, Vector3* out)
+{
+    for (size_t i = 0; i < v.numVertices; ++i)
+    {
+        // clang-format off
+        auto skinMtx =
+            jointMatrices[v.joints[i][0]] * v.weights[i].x
+          + jointMatrices[v.joints[i][1]] * v.weights[i].y
+          + jointMatrices[v.joints[i][2]] * v.weights[i].z
+          + jointMatrices[v.joints[i][3]] * v.weights[i].w;
+        // clang-format on
+        out[i] = Vector3::transform(v.positions[i], skinMtx);
+    }
+}
+
+template <typename F>
+static double measure(const char* name, size_t numVertices, int iterations, F fn)
+{
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        fn();
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() / iterations;
+    printf("%-22s %10.3f ms %10.1f Mverts/s\n", name, sec * 1000.0, numVertices / sec / 1e6);
+    return sec;
+}
+
+int main(int argc, char** argv)
+{
+    size_t numVertices = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    const int numJoints = 64;
+    const int iterations = 20;
+
+    uint32_t seed = 1;
+    auto random = [&] {
+        seed = seed * 1664525u + 1013904223u;
+        return float(seed >> 8) / float(1 << 24) * 2.0f - 1.0f;
+    };
+
+    std::vector<Matrix> jointMatrices;
+    for (int j = 0; j < numJoints; ++j)
+    {
+        auto q = Quaternion::normalize(Quaternion(random(), random(), random(), random()));
+        jointMatrices.emplace_back(Matrix::createFromQuaternion(q) * Matrix::createTranslation(random(), random(), random()));
+    }
+
+    std::vector<Vector3> positions(numVertices);
+    std::vector<u16Array4> joints(numVertices);
+    std::vector<Vector4> weights(numVertices);
+    for (size_t i = 0; i < numVertices; ++i)
+    {
+        positions[i] = Vector3(random(), random(), random());
+        for (auto& j : joints[i])
+        {
+            j = uint16_t((random() * 0.5f + 0.5f) * (numJoints - 1));
+        }
+        Vector4 w(std::abs(random()), std::abs(random()), std::abs(random()), std::abs(random()));
+        float sum = w.x + w.y + w.z + w.w;
+        weights[i] = Vector4(w.x / sum, w.y / sum, w.z / sum, w.w / sum);
+    }
+    SkinnedVertices vertices{positions.data(), joints.data(), weights.data(), numVertices};
+    std::vector<Vector3> out(numVertices);
+
+    double ref = measure("reference", numVertices, iterations, [&] { skinReference(vertices, jointMatrices, out.data()); });
+
+    int hardwareThreads = std::max(1, int(std::thread::hardware_concurrency()));
+    std::vector<int> threadCounts = {1};
+    if (hardwareThreads > 1)
+    {
+        threadCounts.emplace_back(hardwareThreads);
+    }
+    for (auto method : {kSKINNING_METHOD_LINEAR_BLEND, kSKINNING_METHOD_DUAL_QUATERNION})
+    {
+        for (int numThreads : threadCounts)
+        {
+            Skinner skinner;
+            skinner.method = method;
+            skinner.numThreads = numThreads;
+            skinner.setJoints(jointMatrices);
+            std::string name = std::string(method == kSKINNING_METHOD_LINEAR_BLEND ? "linear" : "dual quaternion") + " x" + std::to_string(numThreads);
+            double sec = measure(name.c_str(), numVertices, iterations, [&] { skinner.skin(vertices, out.data()); });
+            printf("%-22s %10.1fx\n", "  speedup", ref / sec);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,95 @@
+#include <kame/kame.hpp>
+#include <kame/squirtle/squirtle.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace kame::math;
+using namespace kame::squirtle;
+
+// the recursive full matrix update Model::update used before TransformHierarchy, kept as a baseline
+static void updateReference(std::vector<Node>& nodes, int id, const Matrix& parentGlobal)
+{
+    Node& node = nodes[id];
+    node.globalXForm = node.updateLocalXForm() * parentGlobal;
+    for (int c : node.children)
+    {
+        updateReference(nodes, c, node.globalXForm);
+    }
+}
+
+template <typename F>
+static double measure(const char* name, size_t numNodes, int iterations, F fn)
+{
+    auto begin = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+    {
+        fn();
+    }
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count() / iterations;
+    printf("%-22s %10.3f ms %10.1f ns/node\n", name, sec * 1000.0, sec * 1e9 / numNodes);
+    return sec;
+}
+
+int main(int argc, char** argv)
+{
+    size_t numNodes = argc > 1 ? std::stoul(argv[1]) : 100000;
+    const int iterations = 50;
+
+    uint32_t seed = 1;
+    auto random = [&] {
+        seed = seed * 1664525u + 1013904223u;
+        return float(seed >> 8) / float(1 << 24) * 2.0f - 1.0f;
+    };
+
+    // a scene graph of small subtrees under 100 roots, like props grouped in rooms
+    std::vector<Node> nodes(numNodes);
+    for (size_t i = 0; i < numNodes; ++i)
+    {
+        Node& n = nodes[i];
+        n.position = Vector3(random(), random(), random());
+        n.rotation = Quaternion::normalize(Quaternion(random(), random(), random(), random()));
+        if (i >= 100)
+        {
+            n.parent = int(i / 4);
+            nodes[n.parent].children.emplace_back(int(i));
+        }
+    }
+
+    double ref = measure("reference", numNodes, iterations, [&] {
+        for (size_t i = 0; i < 100; ++i)
+        {
+            updateReference(nodes, int(i), Matrix::identity());
+        }
+    });
+
+    TransformHierarchy h;
+    h.build(nodes);
+    double sec = measure("hierarchy all dirty", numNodes, iterations, [&] {
+        for (uint32_t i = 0; i < h.size(); ++i)
+        {
+            h.markDirty(i);
+        }
+        h.update();
+    });
+    printf("%-22s %10.1fx\n", "  speedup", ref / sec);
+
+    for (size_t stride : {100, 10000})
+    {
+        std::string name = "hierarchy 1/" + std::to_string(stride) + " moved";
+        sec = measure(name.c_str(), numNodes, iterations, [&] {
+            for (size_t i = numNodes - 1; i >= 100 && i < numNodes; i -= stride)
+            {
+                h.markDirty(h.indices[i]);
+            }
+            h.update();
+        });
+        printf("%-22s %10.1fx\n", "  speedup", ref / sec);
+    }
+
+    sec = measure("hierarchy static", numNodes, iterations, [&] { h.update(); });
+    printf("%-22s %10.1fx\n", "  speedup", ref / sec);
+    return 0;
+}
@@ -5,6 +5,8 @@
 #include <vector>
 #include <string>
 #include <utility>
+#include <span>
+#include <memory>
 
 #include "gltf_ext.hpp"
 #include "gltf_material.hpp"
@@ -13,13 +15,39 @@ namespace kame::gltf {
 
 using integer = uint64_t;
 
+// read-only memory mapping of a whole file, unmapped on destruction
+struct MappedFile {
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    void* handle = nullptr; // platform specific
+
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    void operator=(const MappedFile&) = delete;
+    ~MappedFile();
+};
+
+std::shared_ptr<MappedFile> mapFile(const char* path);
+
+struct LoadOptions {
+    // map external .bin files (and .glb files in loadGLTF()) instead of reading them,
+    // pages are faulted in lazily and shared between processes loading the same asset.
+    bool useMemoryMapping = false;
+};
+
 struct Buffer {
     std::string name;
     std::string uri;
     integer byteLength;
     std::vector<uint8_t> binaryData;
+    std::shared_ptr<MappedFile> mapping;
+    std::span<const uint8_t> binaryView; // points into the BIN chunk of a GLB or into mapping
     const unsigned char* data() const
     {
+        if (!binaryView.empty())
+        {
+            return binaryView.data();
+        }
         return binaryData.data();
     }
 };
@@ -44,7 +72,7 @@ struct Accessor {
     bool normalized = false;
     integer count;
     std::string type;
-    std::vector<integer> max, min;
+    std::vector<double> max, min;
     bool hasBufferView = false;
     bool hasByteOffset = false;
     bool hasNormalized = false;
@@ -145,12 +173,22 @@ struct Gltf {
     std::vector<Material> materials;
     std::string path;
     std::string basePath;
+    LoadOptions options;
+    bool isGLB = false;
+    std::span<const uint8_t> glbBinChunk;
+    char* fileData = nullptr;                // owned by loadGLTF() when the BIN chunk is referenced in place
+    std::shared_ptr<MappedFile> fileMapping; // same as fileData when options.useMemoryMapping
 };
 
-Gltf* loadGLTF(const char* path);
-Gltf* loadGLTFFromMemory(const unsigned char* src, unsigned int len, const char* path = "");
+Gltf* loadGLTF(const char* path, const LoadOptions& options = {});
+// accepts both JSON(.gltf) and binary(.glb) containers.
+// for GLB, buffers refer to the BIN chunk of src in place, so src must outlive the returned Gltf.
+Gltf* loadGLTFFromMemory(const unsigned char* src, unsigned int len, const char* path = "", const LoadOptions& options = {});
+bool isGLB(const unsigned char* src, unsigned int len);
 void deleteGLTF(Gltf* gltf);
 
+// decodes padded base64, returns false and leaves out empty on malformed input
+bool decodeBase64(const char* str, size_t len, std::vector<uint8_t>& out);
 std::vector<uint8_t> decodeBase64(const std::string& str, integer start);
 
 } // namespace kame::gltf
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "gltf.hpp"
+
+namespace kame::gltf {
+
+enum ComponentType : integer {
+    kCOMPONENT_TYPE_BYTE = 5120,
+    kCOMPONENT_TYPE_UNSIGNED_BYTE = 5121,
+    kCOMPONENT_TYPE_SHORT = 5122,
+    kCOMPONENT_TYPE_UNSIGNED_SHORT = 5123,
+    kCOMPONENT_TYPE_UNSIGNED_INT = 5125,
+    kCOMPONENT_TYPE_FLOAT = 5126
+};
+
+integer getComponentSize(integer componentType);
+integer getNumComponents(const std::string& type);
+
+namespace detail {
+
+// contiguous widening kernels, SIMD when available
+void widen(const uint8_t* src, uint16_t* dst, size_t n);
+void widen(const uint8_t* src, uint32_t* dst, size_t n);
+void widen(const uint16_t* src, uint32_t* dst, size_t n);
+// dst = src / divisor, divided like convertComponent() so both paths agree to the bit
+void toFloat(const uint8_t* src, float* dst, size_t n, float divisor);
+void toFloat(const uint16_t* src, float* dst, size_t n, float divisor);
+
+template <typename Dst, typename Src>
+inline Dst convertComponent(Src v, bool normalized)
+{
+    if constexpr (std::is_floating_point_v<Dst> && std::is_integral_v<Src>)
+    {
+        if (normalized)
+        {
+            if constexpr (std::is_signed_v<Src>)
+            {
+                return std::max(Dst(v) / Dst(std::numeric_limits<Src>::max()), Dst(-1));
+            }
+            else
+            {
+                return Dst(v) / Dst(std::numeric_limits<Src>::max());
+            }
+        }
+    }
+    return Dst(v);
+}
+
+} // namespace detail
+
+// scalar type and number of components of an element, e.g. Vector3 -> (float, 3)
+template <typename T, bool = std::is_arithmetic_v<T>>
+struct AccessorElement {
+    using Scalar = float;
+    static constexpr size_t N = sizeof(T) / sizeof(float);
+};
+
+template <typename T>
+struct AccessorElement<T, true> {
+    using Scalar = T;
+    static constexpr size_t N = 1;
+};
+
+template <typename U, size_t M>
+struct AccessorElement<std::array<U, M>, false> {
+    using Scalar = U;
+    static constexpr size_t N = M;
+};
+
+// typed view of an accessor which honours byteStride, componentType and normalized.
+// e.g. AccessorView<kame::math::Vector3>(gltf, acc).toVector()
+template <typename T>
+struct AccessorView {
+    using Scalar = typename AccessorElement<T>::Scalar;
+    static constexpr size_t kNumComponents = AccessorElement<T>::N;
+
+    const uint8_t* data = nullptr; // nullptr if the accessor has no bufferView, reads as zeros
+    integer count = 0;
+    integer componentType = 0;
+    integer stride = 0;
+    bool normalized = false;
+
+    AccessorView(const Gltf* gltf, integer accessor)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        static_assert(sizeof(T) == sizeof(Scalar) * kNumComponents);
+
+        const Accessor& acc = gltf->accessors[accessor];
+        assert(getNumComponents(acc.type) == kNumComponents);
+        count = acc.count;
+        componentType = acc.componentType;
+        normalized = acc.normalized;
+
+        integer elementSize = getComponentSize(componentType) * kNumComponents;
+        stride = elementSize;
+        if (acc.hasBufferView)
+        {
+            const BufferView& bv = gltf->bufferViews[acc.bufferView];
+            const Buffer& b = gltf->buffers[bv.buffer];
+            if (bv.hasByteStride)
+            {
+                stride = bv.byteStride;
+            }
+            assert(count == 0 || acc.byteOffset + (count - 1) * stride + elementSize <= bv.byteLength);
+            assert(bv.byteOffset + bv.byteLength <= b.byteLength);
+            data = b.data() + bv.byteOffset + acc.byteOffset;
+        }
+    }
+
+    size_t size() const
+    {
+        return count;
+    }
+
+    bool isSameComponentType() const
+    {
+        return getComponentSize(componentType) == sizeof(Scalar) && (componentType == kCOMPONENT_TYPE_FLOAT) == std::is_floating_point_v<Scalar>;
+    }
+
+    bool isTightlyPacked() const
+    {
+        return isSameComponentType() && stride == sizeof(T);
+    }
+
+    T operator[](size_t i) const
+    {
+        assert(i < count);
+        T v;
+        convertRange(&v, i, 1);
+        return v;
+    }
+
+    // raw copy, the component type must match T
+    void copyTo(T* dst) const
+    {
+        assert(isSameComponentType());
+        if (!data)
+        {
+            std::memset((void*)dst, 0, sizeof(T) * count);
+        }
+        else if (stride == sizeof(T))
+        {
+            std::memcpy((void*)dst, data, sizeof(T) * count);
+        }
+        else
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                std::memcpy((void*)(dst + i), data + i * stride, sizeof(T));
+            }
+        }
+    }
+
+    // converts any component type to T
+    void convertTo(T* dst) const
+    {
+        convertRange(dst, 0, count);
+    }
+
+    std::vector<T> toVector() const
+    {
+        std::vector<T> v(count);
+        convertTo(v.data());
+        return v;
+    }
+
+private:
+    void convertRange(T* dst, size_t first, size_t n) const
+    {
+        if (!data)
+        {
+            std::memset((void*)dst, 0, sizeof(T) * n);
+            return;
+        }
+        switch (componentType)
+        {
+            case kCOMPONENT_TYPE_BYTE:
+                convertFrom<int8_t>(dst, first, n);
+                break;
+            case kCOMPONENT_TYPE_UNSIGNED_BYTE:
+                convertFrom<uint8_t>(dst, first, n);
+                break;
+            case kCOMPONENT_TYPE_SHORT:
+                convertFrom<int16_t>(dst, first, n);
+                break;
+            case kCOMPONENT_TYPE_UNSIGNED_SHORT:
+                convertFrom<uint16_t>(dst, first, n);
+                break;
+            case kCOMPONENT_TYPE_UNSIGNED_INT:
+                convertFrom<uint32_t>(dst, first, n);
+                break;
+            case kCOMPONENT_TYPE_FLOAT:
+                convertFrom<float>(dst, first, n);
+                break;
+            default:
+                assert(false && "unknown componentType");
+                break;
+        }
+    }
+
+    template <typename Src>
+    void convertFrom(T* dst, size_t first, size_t n) const
+    {
+        const uint8_t* src = data + first * stride;
+        Scalar* out = (Scalar*)dst;
+
+        if (stride == sizeof(Src) * kNumComponents)
+        {
+            const size_t numScalars = n * kNumComponents;
+            if constexpr (std::is_same_v<Src, Scalar>)
+            {
+                std::memcpy(out, src, sizeof(T) * n);
+                return;
+            }
+            else if constexpr ((std::is_same_v<Src, uint8_t> || std::is_same_v<Src, uint16_t>) && std::is_same_v<Scalar, float>)
+            {
+                detail::toFloat((const Src*)src, out, numScalars, normalized ? float(std::numeric_limits<Src>::max()) : 1.0f);
+                return;
+            }
+            else if constexpr ((std::is_same_v<Src, uint8_t> && (std::is_same_v<Scalar, uint16_t> || std::is_same_v<Scalar, uint32_t>)) || (std::is_same_v<Src, uint16_t> && std::is_same_v<Scalar, uint32_t>))
+            {
+                detail::widen((const Src*)src, out, numScalars);
+                return;
+            }
+        }
+
+        for (size_t i = 0; i < n; ++i)
+        {
+            const uint8_t* p = src + i * stride;
+            for (size_t c = 0; c < kNumComponents; ++c)
+            {
+                Src v;
+                std::memcpy(&v, p + c * sizeof(Src), sizeof(Src));
+                out[i * kNumComponents + c] = detail::convertComponent<Scalar>(v, normalized);
+            }
+        }
+    }
+};
+
+} // namespace kame::gltf
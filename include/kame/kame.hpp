@@ -13,4 +13,5 @@ bool kameIsInit();
 #include "vk/vk.hpp"
 #include "math/math.hpp"
 #include "gltf/gltf.hpp"
+#include "gltf/gltf_accessor.hpp"
 #include "squirtle/squirtle.hpp"
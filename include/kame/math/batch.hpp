@@ -0,0 +1,26 @@
+#pragma once
+
+#include "vector3.hpp"
+#include "quaternion.hpp"
+#include "matrix.hpp"
+
+#include <cstdint>
+#include <span>
+
+namespace kame::math {
+
+// array versions of the per element operators, vectorized across elements.
+// results compare equal to the per element operators, out may alias the input of the same type.
+
+// out[i] = Vector3::transform(points[i], m)
+void transformPoints(std::span<const Vector3> points, const Matrix& m, std::span<Vector3> out);
+// same for the listed points only, e.g. the vertices an index buffer references
+void transformPoints(std::span<const Vector3> points, std::span<const uint32_t> indices, const Matrix& m, std::span<Vector3> out);
+// out[i] = Matrix::createScale(scales[i]) * Matrix::createFromQuaternion(rotations[i]) * Matrix::createTranslation(translations[i])
+void composeTRS(std::span<const Vector3> translations, std::span<const Quaternion> rotations, std::span<const Vector3> scales, std::span<Matrix> out);
+// out[i] = a[i] * b[i]
+void multiplyMatrices(std::span<const Matrix> a, std::span<const Matrix> b, std::span<Matrix> out);
+// out[i] = a[i] * b
+void multiplyMatrices(std::span<const Matrix> a, const Matrix& b, std::span<Matrix> out);
+
+} // namespace kame::math
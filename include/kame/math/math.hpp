@@ -6,3 +6,4 @@
 #include "vector4.hpp"
 #include "quaternion.hpp"
 #include "matrix.hpp"
+#include "batch.hpp"
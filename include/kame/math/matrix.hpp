@@ -3,6 +3,7 @@
 #include "vector3.hpp"
 #include "vector4.hpp"
 #include "quaternion.hpp"
+#include "simd.hpp"
 
 #include <cmath>
 
@@ -81,21 +82,8 @@ struct Matrix {
 
     static Matrix multiply(Matrix& a, Matrix& b)
     {
-        Matrix m = Matrix::zero();
-        const float* A = (const float*)&a;
-        const float* B = (const float*)&b;
-        float* M = (float*)&m;
-
-        for (int i = 0; i < 4; ++i)
-        {
-            for (int j = 0; j < 4; ++j)
-            {
-                for (int k = 0; k < 4; ++k)
-                {
-                    M[4 * i + j] += A[4 * i + k] * B[4 * k + j];
-                }
-            }
-        }
+        Matrix m;
+        simd::multiply4x4((const float*)&a, (const float*)&b, (float*)&m);
         return m;
     }
 
@@ -221,25 +209,7 @@ struct Matrix {
     static Matrix transpose(const Matrix& m)
     {
         Matrix ret;
-        ret.m11 = m.m11;
-        ret.m12 = m.m21;
-        ret.m13 = m.m31;
-        ret.m14 = m.m41;
-
-        ret.m21 = m.m12;
-        ret.m22 = m.m22;
-        ret.m23 = m.m32;
-        ret.m24 = m.m42;
-
-        ret.m31 = m.m13;
-        ret.m32 = m.m23;
-        ret.m33 = m.m33;
-        ret.m34 = m.m43;
-
-        ret.m41 = m.m14;
-        ret.m42 = m.m24;
-        ret.m43 = m.m34;
-        ret.m44 = m.m44;
+        simd::transpose4x4((const float*)&m, (float*)&ret);
         return ret;
     }
 
@@ -248,48 +218,48 @@ struct Matrix {
 
 static inline Matrix operator+(const Matrix& a, const Matrix& b)
 {
-    Matrix m = Matrix::zero();
+    Matrix m;
     const float* A = (const float*)&a;
     const float* B = (const float*)&b;
     float* M = (float*)&m;
-
+#if defined(KAME_MATH_SSE2)
+    for (int i = 0; i < 16; i += 4)
+    {
+        _mm_storeu_ps(M + i, _mm_add_ps(_mm_loadu_ps(A + i), _mm_loadu_ps(B + i)));
+    }
+#else
     for (int i = 0; i < 16; ++i)
     {
         M[i] = A[i] + B[i];
     }
+#endif
     return m;
 }
 
 static inline Matrix operator*(const Matrix& a, const Matrix& b)
 {
-    Matrix m = Matrix::zero();
-    const float* A = (const float*)&a;
-    const float* B = (const float*)&b;
-    float* M = (float*)&m;
-
-    for (int i = 0; i < 4; ++i)
-    {
-        for (int j = 0; j < 4; ++j)
-        {
-            for (int k = 0; k < 4; ++k)
-            {
-                M[4 * i + j] += A[4 * i + k] * B[4 * k + j];
-            }
-        }
-    }
+    Matrix m;
+    simd::multiply4x4((const float*)&a, (const float*)&b, (float*)&m);
     return m;
 }
 
 static inline Matrix operator*(const Matrix& a, float scaleFactor)
 {
-    Matrix m = Matrix::zero();
+    Matrix m;
     const float* A = (const float*)&a;
     float* M = (float*)&m;
-
+#if defined(KAME_MATH_SSE2)
+    const __m128 s = _mm_set1_ps(scaleFactor);
+    for (int i = 0; i < 16; i += 4)
+    {
+        _mm_storeu_ps(M + i, _mm_mul_ps(_mm_loadu_ps(A + i), s));
+    }
+#else
     for (int i = 0; i < 16; ++i)
     {
         M[i] = A[i] * scaleFactor;
     }
+#endif
     return m;
 }
 
@@ -2,6 +2,7 @@
 
 #include "vector3.hpp"
 #include "vector4.hpp"
+#include "simd.hpp"
 
 namespace kame::math {
 
@@ -75,13 +76,9 @@ static inline Quaternion operator-(Quaternion a, Quaternion b)
 
 static inline Quaternion operator*(Quaternion a, Quaternion b)
 {
-    // clang-format off
-    return Quaternion(
-        ( b.x * a.w) + (b.y * a.z) - (b.z * a.y) + (b.w * a.x),
-        (-b.x * a.z) + (b.y * a.w) + (b.z * a.x) + (b.w * a.y),
-        ( b.x * a.y) - (b.y * a.x) + (b.z * a.w) + (b.w * a.z),
-        (-b.x * a.x) - (b.y * a.y) - (b.z * a.z) + (b.w * a.w));
-    // clang-format on
+    Quaternion q;
+    simd::multiplyQuaternion(&a.x, &b.x, &q.x);
+    return q;
 }
 
 static inline Quaternion operator*(Quaternion a, float scalar)
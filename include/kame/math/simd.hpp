@@ -0,0 +1,183 @@
+#pragma once
+
+// SIMD paths of the math types, picked at compile time so the small operators stay inline.
+// SSE2 is the x86-64 baseline, AVX is used when the compiler targets it (-mavx2, -march=native, /arch:AVX2),
+// NEON on ARM. define KAME_MATH_NO_SIMD to build the scalar code everywhere.
+// the SIMD paths add and multiply in the same order as the scalar code and never fuse, results are bit identical.
+#if !defined(KAME_MATH_NO_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KAME_MATH_SSE2 1
+#include <emmintrin.h>
+#if defined(__AVX__)
+#define KAME_MATH_AVX 1
+#include <immintrin.h>
+#endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define KAME_MATH_NEON 1
+#include <arm_neon.h>
+#endif
+#endif
+
+namespace kame::math::simd {
+
+// out = a * b for row major 4x4 matrices, out may not alias a or b
+static inline void multiply4x4(const float* a, const float* b, float* out)
+{
+#if defined(KAME_MATH_AVX)
+    // two rows per iteration, each 128 bit lane broadcasts the elements of its own row
+    const __m256 b0 = _mm256_broadcast_ps((const __m128*)(b + 0));
+    const __m256 b1 = _mm256_broadcast_ps((const __m128*)(b + 4));
+    const __m256 b2 = _mm256_broadcast_ps((const __m128*)(b + 8));
+    const __m256 b3 = _mm256_broadcast_ps((const __m128*)(b + 12));
+    for (int i = 0; i < 16; i += 8)
+    {
+        const __m256 rows = _mm256_loadu_ps(a + i);
+        __m256 r = _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0x00), b0);
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0x55), b1));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0xaa), b2));
+        r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(rows, rows, 0xff), b3));
+        _mm256_storeu_ps(out + i, r);
+    }
+#elif defined(KAME_MATH_SSE2)
+    const __m128 b0 = _mm_loadu_ps(b + 0);
+    const __m128 b1 = _mm_loadu_ps(b + 4);
+    const __m128 b2 = _mm_loadu_ps(b + 8);
+    const __m128 b3 = _mm_loadu_ps(b + 12);
+    for (int i = 0; i < 16; i += 4)
+    {
+        const __m128 row = _mm_loadu_ps(a + i);
+        __m128 r = _mm_mul_ps(_mm_shuffle_ps(row, row, 0x00), b0);
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(row, row, 0x55), b1));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(row, row, 0xaa), b2));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(row, row, 0xff), b3));
+        _mm_storeu_ps(out + i, r);
+    }
+#elif defined(KAME_MATH_NEON)
+    const float32x4_t b0 = vld1q_f32(b + 0);
+    const float32x4_t b1 = vld1q_f32(b + 4);
+    const float32x4_t b2 = vld1q_f32(b + 8);
+    const float32x4_t b3 = vld1q_f32(b + 12);
+    for (int i = 0; i < 16; i += 4)
+    {
+        float32x4_t r = vmulq_n_f32(b0, a[i + 0]);
+        r = vaddq_f32(r, vmulq_n_f32(b1, a[i + 1]));
+        r = vaddq_f32(r, vmulq_n_f32(b2, a[i + 2]));
+        r = vaddq_f32(r, vmulq_n_f32(b3, a[i + 3]));
+        vst1q_f32(out + i, r);
+    }
+#else
+    for (int i = 0; i < 16; i += 4)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            out[i + j] = a[i] * b[j] + a[i + 1] * b[4 + j] + a[i + 2] * b[8 + j] + a[i + 3] * b[12 + j];
+        }
+    }
+#endif
+}
+
+// out = (x, y, z, w) * m for a row major 4x4 matrix
+static inline void transform4(float x, float y, float z, float w, const float* m, float* out)
+{
+#if defined(KAME_MATH_SSE2)
+    __m128 r = _mm_mul_ps(_mm_set1_ps(x), _mm_loadu_ps(m + 0));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(y), _mm_loadu_ps(m + 4)));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(z), _mm_loadu_ps(m + 8)));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(w), _mm_loadu_ps(m + 12)));
+    _mm_storeu_ps(out, r);
+#elif defined(KAME_MATH_NEON)
+    float32x4_t r = vmulq_n_f32(vld1q_f32(m + 0), x);
+    r = vaddq_f32(r, vmulq_n_f32(vld1q_f32(m + 4), y));
+    r = vaddq_f32(r, vmulq_n_f32(vld1q_f32(m + 8), z));
+    r = vaddq_f32(r, vmulq_n_f32(vld1q_f32(m + 12), w));
+    vst1q_f32(out, r);
+#else
+    for (int j = 0; j < 4; ++j)
+    {
+        out[j] = x * m[j] + y * m[4 + j] + z * m[8 + j] + w * m[12 + j];
+    }
+#endif
+}
+
+// same for a point, the translation row is added instead of multiplied by w = 1
+static inline void transformPoint(float x, float y, float z, const float* m, float* out)
+{
+#if defined(KAME_MATH_SSE2)
+    __m128 r = _mm_mul_ps(_mm_set1_ps(x), _mm_loadu_ps(m + 0));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(y), _mm_loadu_ps(m + 4)));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(z), _mm_loadu_ps(m + 8)));
+    r = _mm_add_ps(r, _mm_loadu_ps(m + 12));
+    _mm_storeu_ps(out, r);
+#elif defined(KAME_MATH_NEON)
+    float32x4_t r = vmulq_n_f32(vld1q_f32(m + 0), x);
+    r = vaddq_f32(r, vmulq_n_f32(vld1q_f32(m + 4), y));
+    r = vaddq_f32(r, vmulq_n_f32(vld1q_f32(m + 8), z));
+    r = vaddq_f32(r, vld1q_f32(m + 12));
+    vst1q_f32(out, r);
+#else
+    for (int j = 0; j < 4; ++j)
+    {
+        out[j] = x * m[j] + y * m[4 + j] + z * m[8 + j] + m[12 + j];
+    }
+#endif
+}
+
+// out = transpose(m), out may not alias m
+static inline void transpose4x4(const float* m, float* out)
+{
+#if defined(KAME_MATH_SSE2)
+    __m128 r0 = _mm_loadu_ps(m + 0);
+    __m128 r1 = _mm_loadu_ps(m + 4);
+    __m128 r2 = _mm_loadu_ps(m + 8);
+    __m128 r3 = _mm_loadu_ps(m + 12);
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+    _mm_storeu_ps(out + 0, r0);
+    _mm_storeu_ps(out + 4, r1);
+    _mm_storeu_ps(out + 8, r2);
+    _mm_storeu_ps(out + 12, r3);
+#elif defined(KAME_MATH_NEON)
+    float32x4x4_t rows = vld4q_f32(m);
+    vst1q_f32(out + 0, rows.val[0]);
+    vst1q_f32(out + 4, rows.val[1]);
+    vst1q_f32(out + 8, rows.val[2]);
+    vst1q_f32(out + 12, rows.val[3]);
+#else
+    for (int i = 0; i < 4; ++i)
+    {
+        for (int j = 0; j < 4; ++j)
+        {
+            out[4 * j + i] = m[4 * i + j];
+        }
+    }
+#endif
+}
+
+// Hamilton product b * a of quaternions stored (x, y, z, w), the operand order of Quaternion's operator*(a, b)
+static inline void multiplyQuaternion(const float* a, const float* b, float* out)
+{
+#if defined(KAME_MATH_SSE2)
+    // out = b.x * (aw, -az, ay, -ax) + b.y * (az, aw, -ax, -ay) + b.z * (-ay, ax, aw, -az) + b.w * a
+    const __m128 q = _mm_loadu_ps(a);
+    const __m128 p = _mm_loadu_ps(b);
+    const __m128 sx = _mm_castsi128_ps(_mm_setr_epi32(0, (int)0x80000000, 0, (int)0x80000000));
+    const __m128 sy = _mm_castsi128_ps(_mm_setr_epi32(0, 0, (int)0x80000000, (int)0x80000000));
+    const __m128 sz = _mm_castsi128_ps(_mm_setr_epi32((int)0x80000000, 0, 0, (int)0x80000000));
+    const __m128 qx = _mm_xor_ps(_mm_shuffle_ps(q, q, _MM_SHUFFLE(0, 1, 2, 3)), sx);
+    const __m128 qy = _mm_xor_ps(_mm_shuffle_ps(q, q, _MM_SHUFFLE(1, 0, 3, 2)), sy);
+    const __m128 qz = _mm_xor_ps(_mm_shuffle_ps(q, q, _MM_SHUFFLE(2, 3, 0, 1)), sz);
+    __m128 r = _mm_mul_ps(_mm_shuffle_ps(p, p, 0x00), qx);
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(p, p, 0x55), qy));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(p, p, 0xaa), qz));
+    r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(p, p, 0xff), q));
+    _mm_storeu_ps(out, r);
+#else
+    // clang-format off
+    out[0] = ( b[0] * a[3]) + (b[1] * a[2]) - (b[2] * a[1]) + (b[3] * a[0]);
+    out[1] = (-b[0] * a[2]) + (b[1] * a[3]) + (b[2] * a[0]) + (b[3] * a[1]);
+    out[2] = ( b[0] * a[1]) - (b[1] * a[0]) + (b[2] * a[3]) + (b[3] * a[2]);
+    out[3] = (-b[0] * a[0]) - (b[1] * a[1]) - (b[2] * a[2]) + (b[3] * a[3]);
+    // clang-format on
+#endif
+}
+
+} // namespace kame::math::simd
@@ -4,6 +4,8 @@
 
 #include <kame/math/math.hpp>
 
+#include <array>
+#include <cstdint>
 #include <vector>
 #include <unordered_map>
 #include <string>
@@ -15,6 +17,57 @@ struct Context {
         bool ext_framebuffer_object = false;
         bool arb_texture_float = false;
         bool arb_draw_instanced = false;
+        bool arb_vertex_array_object = false;
+        bool arb_vertex_attrib_binding = false;        // GL 4.3
+        bool arb_buffer_storage = false;               // GL 4.4
+        bool arb_sync = false;                         // GL 3.2
+        bool arb_draw_elements_base_vertex = false;    // GL 3.2
+        bool arb_multi_draw_indirect = false;          // GL 4.3
+        bool arb_shader_storage_buffer_object = false; // GL 4.3
+    };
+
+    // the value a set*() function last sent to GL, unknown until the first call
+    template <typename T>
+    struct Cached {
+        T value{};
+        bool isValid = false;
+
+        // false when v is already current and the GL call can be skipped
+        bool set(const T& v)
+        {
+            if (isValid && value == v)
+            {
+                return false;
+            }
+            value = v;
+            isValid = true;
+            return true;
+        }
+    };
+
+    // shadow copy of the GL state kame::ogl sets, so unchanged state is not sent again.
+    // call invalidateState() when other code changed it behind our back.
+    struct State {
+        static constexpr int kMAX_TEXTURE_UNITS = 32;
+
+        Cached<GLuint> program;
+        Cached<GLuint> activeTexture; // unit index, not GL_TEXTURE0 + unit
+        std::array<Cached<GLuint>, kMAX_TEXTURE_UNITS> textures;
+        Cached<GLuint> framebuffer;
+        Cached<GLuint> vertexArray;
+        Cached<bool> blend;
+        Cached<std::array<GLenum, 4>> blendFunction;
+        Cached<std::array<GLenum, 2>> blendEquation;
+        Cached<bool> depthTest;
+        Cached<GLenum> depthFunc;
+        Cached<bool> cullFace;
+        Cached<GLenum> cullMode;
+    };
+
+    // GL calls the cached state functions made and skipped, e.g. reset per frame with stateStats = {}
+    struct StateStats {
+        uint64_t issued = 0;
+        uint64_t skipped = 0;
     };
 
     int versionMajor = 0;
@@ -22,6 +75,8 @@ struct Context {
     bool isCoreProfile = false;
     bool isAvaliable = false;
     Capability capability;
+    State state;
+    StateStats stateStats;
 
 private:
     Context() {}
@@ -58,6 +113,53 @@ struct IndexBuffer {
     void setBuffer(const std::vector<unsigned int>& vertices);
 };
 
+// the layout glMultiDrawElementsIndirect reads
+struct DrawElementsIndirectCommand {
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex; // in indices, not bytes
+    GLint baseVertex;
+    GLuint baseInstance;
+};
+
+// draw commands for VertexArrayObject::multiDrawElementsIndirect(). the GL buffer exists with
+// GL 4.3 or ARB_multi_draw_indirect, the copy in commands feeds the per draw fallback.
+struct IndirectBuffer {
+    GLuint id;
+    GLenum usage;
+    std::vector<DrawElementsIndirectCommand> commands;
+
+    void setBuffer(const std::vector<DrawElementsIndirectCommand>& commands);
+};
+
+// a ring of numFrames regions for geometry rewritten every frame, e.g. CPU skinned positions.
+// persistently mapped when ARB_buffer_storage is available so an upload is a memcpy, otherwise written through
+// glMapBufferRange(GL_MAP_UNSYNCHRONIZED_BIT). nextFrame() fences the region just written and waits until the
+// GPU is done with the next one, or orphans the buffer when the ring wraps on contexts without sync objects.
+struct StreamingBuffer {
+    static constexpr int kMAX_FRAMES = 4;
+
+    struct Allocation {
+        GLintptr offset = 0;
+        GLsizeiptr numBytes = 0;
+    };
+
+    GLuint id;
+    GLsizeiptr numBytes; // of one frame's region
+    int numFrames;
+    bool isPersistent = false;
+    unsigned char* mapped = nullptr; // the whole ring when persistent
+    int frame = 0;
+    GLsizeiptr head = 0; // next free byte in the current region
+    GLsync fences[kMAX_FRAMES] = {};
+
+    // copies data into the current region, alignment must be a power of two.
+    // returns an empty Allocation, numBytes 0, when the region has no room left for it
+    Allocation upload(const void* data, GLsizeiptr size, GLsizeiptr alignment = 16);
+    // call once per frame after the last draw reading this frame's uploads
+    void nextFrame();
+};
+
 struct VertexArrayObject {
     struct Attribute {
         GLuint vbo_id;
@@ -68,19 +170,33 @@ struct VertexArrayObject {
         GLsizei stride;
         uintptr_t offset;
         GLuint divisor;
+        bool isStreaming; // the offset changes every frame, it is set at draw time instead of baked
+        bool isInteger;   // read as int/uint by the shader, glVertexAttribIPointer
+
+        bool operator==(const Attribute&) const;
     };
     std::vector<VertexArrayObject::Attribute> attributes;
     GLuint ibo_id = 0;
+    GLintptr iboOffset = 0;
+    GLuint id = 0; // GL vertex array end() baked the layout into, 0 without vertex array object support
+    bool hasStreaming = false;
     bool inSetAttributes = false;
 
     VertexArrayObject& begin();
     VertexArrayObject& bindAttribute(const VertexBuffer* vbo, GLuint location, GLuint componentSize, GLenum type, GLboolean normalized, GLsizei stride, uintptr_t offset, GLuint divisor = 0);
+    VertexArrayObject& bindAttribute(const StreamingBuffer* buffer, GLuint location, GLuint componentSize, GLenum type, GLboolean normalized, GLsizei stride, StreamingBuffer::Allocation allocation, GLuint divisor = 0);
+    // integer type kept as is for ivec/uvec inputs, e.g. joint indices
+    VertexArrayObject& bindIntegerAttribute(const VertexBuffer* vbo, GLuint location, GLuint componentSize, GLenum type, GLsizei stride, uintptr_t offset, GLuint divisor = 0);
     VertexArrayObject& bindIndexBuffer(const IndexBuffer* ibo);
+    VertexArrayObject& bindIndexBuffer(const StreamingBuffer* buffer, StreamingBuffer::Allocation allocation);
     void end();
 
     void drawArrays(GLenum mode, GLint first, GLsizei count);
     void drawElements(GLenum mode, GLsizei count, GLenum type);
     void drawElementsInstanced(GLenum mode, GLsizei count, GLenum type, GLsizei primCount);
+    // commands [first, first + drawCount) in one glMultiDrawElementsIndirect, else a glDrawElementsBaseVertex
+    // loop that offsets the attributes with a divisor by baseInstance itself
+    void multiDrawElementsIndirect(GLenum mode, GLenum type, const IndirectBuffer* indirect, GLsizei first, GLsizei drawCount);
 };
 
 struct UniformBuffer {
@@ -89,6 +205,16 @@ struct UniformBuffer {
     GLenum usage;
 
     void setBuffer(const float* vertices);
+    void setBufferSubData(GLintptr offset, GLsizeiptr size, const void* data); // glBufferSubData
+};
+
+// needs GL 4.3 or ARB_shader_storage_buffer_object
+struct ShaderStorageBuffer {
+    GLuint id;
+    GLsizeiptr numBytes;
+    GLenum usage;
+
+    void setBuffer(const void* data);
 };
 
 struct Shader {
@@ -103,6 +229,7 @@ struct Shader {
     void setVector3(const char* name, kame::math::Vector3 v);
     void setFloat(const char* name, float x);
     void setInt(const char* name, int x);
+    void setUniformBlockBinding(const char* name, GLuint binding);
 };
 
 struct Texture2D {
@@ -203,8 +330,17 @@ void setDepthStencilState(DepthStencilState state);
 void setRasterizerState(RasterizerState state);
 void setShader(Shader* shader);
 void setTexture2D(GLuint slot, Texture2D* tex);
+void setUniformBuffer(GLuint binding, UniformBuffer* ubo);
+void setShaderStorageBuffer(GLuint binding, ShaderStorageBuffer* ssbo);
 void setRenderTarget(GBuffer* gbuffer);
 void setRenderTargetDefault();
+// forgets the cached GL state, the next set*() calls reach GL again
+void invalidateState();
+
+// end() shares one GL vertex array between every VertexArrayObject with the same layout, so a temporary
+// built each frame costs a lookup. deleting a buffer drops the vertex arrays using it, this drops the rest
+// and must run while the context is still current.
+void releaseVertexArrays();
 
 Shader* createShader(const char* vert, const char* frag);
 void deleteShader(Shader* shader);
@@ -215,9 +351,18 @@ void deleteVertexBuffer(VertexBuffer* vbo);
 IndexBuffer* createIndexBuffer(GLsizeiptr numBytes, GLenum usage);
 void deleteIndexBuffer(IndexBuffer* ibo);
 
+IndirectBuffer* createIndirectBuffer(GLenum usage);
+void deleteIndirectBuffer(IndirectBuffer* indirect);
+
+StreamingBuffer* createStreamingBuffer(GLsizeiptr numBytesPerFrame, int numFrames = 3);
+void deleteStreamingBuffer(StreamingBuffer* buffer);
+
 UniformBuffer* createUniformBuffer(GLsizeiptr numBytes, GLenum usage);
 void deleteUniformBuffer(UniformBuffer* ubo);
 
+ShaderStorageBuffer* createShaderStorageBuffer(GLsizeiptr numBytes, GLenum usage);
+void deleteShaderStorageBuffer(ShaderStorageBuffer* ssbo);
+
 Texture2D* loadTexture2D(const char* path, bool flipY = false);
 Texture2D* loadTexture2DFromMemory(const unsigned char* src, int len, bool flipY = false, const char* path = "");
 Texture2D* createTexture2D(GLint internalFormat, int width, int height, GLenum format, GLenum type);
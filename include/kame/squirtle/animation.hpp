@@ -3,7 +3,9 @@
 #include <kame/math/math.hpp>
 #include <kame/gltf/gltf.hpp>
 
+#include <array>
 #include <cstdint>
+#include <span>
 #include <vector>
 #include <string>
 #include <unordered_map>
@@ -26,6 +28,18 @@ struct AnimationClip {
         InterpolationType interpolation;
         std::vector<float> inputs;
         std::vector<kame::math::Vector4> outputsVec4;
+        float keyInterval = 0.0f; // > 0 when inputs are evenly spaced, keys are then indexed directly
+
+        // sets keyInterval from inputs
+        void analyzeInputs();
+        // has keys and enough outputs for them, cubic splines need three per key
+        bool isPlayable() const;
+        // i of the keys [inputs[i], inputs[i + 1]] around time, clamped to the first and last pair.
+        // cursor holds the previous result so playing forward rarely needs a search.
+        uint32_t findKey(float time, uint32_t& cursor) const;
+        // value at time with the sampler's interpolation, interpolated rotations come out normalized.
+        // a runtime switch per call, animate() uses per track kernels instead.
+        kame::math::Vector4 sample(float time, bool rotation, uint32_t& cursor) const;
     };
 
     std::string name;
@@ -33,8 +47,25 @@ struct AnimationClip {
     std::vector<Sampler> samplers;
     float startTime = std::numeric_limits<float>::max();
     float endTime = std::numeric_limits<float>::min();
+
+    // a playable channel, animate() runs one kernel per interpolation and path over its tracks
+    struct Track {
+        uint32_t targetID;
+        uint32_t samplerID;
+        uint32_t cursor = 0; // for Sampler::findKey()
+    };
+    static constexpr int kNUM_KERNELS = 9; // interpolation * 3 + path
+    std::array<std::vector<Track>, kNUM_KERNELS> tracks;
+    bool compiled = false;
+
+    // groups the channels into tracks, skipping the ones without a target or enough keys.
+    // animate() compiles on first use, call it again after editing channels or samplers.
+    void compile();
 };
 
+// findKey() over any sorted key times, keyInterval > 0 indexes evenly spaced keys directly
+uint32_t findKey(std::span<const float> inputs, float keyInterval, float time, uint32_t& cursor);
+
 std::unordered_map<std::string, AnimationClip> importAnimation(const kame::gltf::Gltf* gltf);
 
 } // namespace kame::squirtle
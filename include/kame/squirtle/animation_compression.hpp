@@ -0,0 +1,65 @@
+#pragma once
+
+#include <kame/kame.hpp>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "animation.hpp"
+
+namespace kame::squirtle {
+
+struct AnimationCompressionOptions {
+    // keys are removed while the curve stays within these bounds, before quantization
+    float translationError = 1e-3f; // in node units
+    float rotationError = 1e-3f;    // in radians
+    float scaleError = 1e-4f;
+    // cubic splines are resampled to linear keys at least this often
+    float cubicSampleRate = 60.0f;
+};
+
+// quantized clip evaluated directly by animate(). every key is a float time and three uint16:
+// translations and scales are range reduced per track, rotations are smallest-three quaternions.
+// cubic splines become linear tracks.
+struct CompressedAnimationClip {
+    struct Track {
+        uint32_t targetID;
+        uint32_t firstKey; // into times and values
+        uint32_t numKeys;
+        uint32_t cursor = 0;
+        // translation and scale components are min + q / 65535 * extent
+        float min[3] = {};
+        float extent[3] = {};
+    };
+
+    std::string name;
+    float startTime = 0.0f;
+    float endTime = 0.0f;
+    // indexed by interpolation * 3 + path like AnimationClip::tracks, cubic entries stay empty
+    std::array<std::vector<Track>, AnimationClip::kNUM_KERNELS> tracks;
+    std::vector<float> times;
+    std::vector<std::array<uint16_t, 3>> values;
+
+    size_t getSizeInBytes() const;
+};
+
+struct AnimationCompressionStats {
+    size_t originalBytes = 0; // inputs and outputs of the played samplers
+    size_t compressedBytes = 0;
+    float ratio = 0.0f;
+    size_t originalKeys = 0;
+    size_t compressedKeys = 0;
+    // measured against the original clip at every original key and halfway between keys
+    float maxTranslationError = 0.0f;
+    float maxRotationError = 0.0f; // in radians
+    float maxScaleError = 0.0f;
+};
+
+CompressedAnimationClip compressAnimation(const AnimationClip& clip, const AnimationCompressionOptions& options = {}, AnimationCompressionStats* stats = nullptr);
+
+// smallest-three packing, the index of the dropped component is spread over the low bits
+std::array<uint16_t, 3> packQuaternion(kame::math::Quaternion q);
+kame::math::Quaternion unpackQuaternion(std::array<uint16_t, 3> packed);
+
+} // namespace kame::squirtle
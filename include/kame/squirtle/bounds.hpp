@@ -0,0 +1,65 @@
+#pragma once
+
+#include <kame/kame.hpp>
+#include <cfloat>
+#include <cstdint>
+#include <vector>
+
+namespace kame::squirtle {
+
+struct AABB {
+    // inverted so that the first merge() sets both corners
+    kame::math::Vector3 min = kame::math::Vector3(FLT_MAX, FLT_MAX, FLT_MAX);
+    kame::math::Vector3 max = kame::math::Vector3(-FLT_MAX, -FLT_MAX, -FLT_MAX);
+
+    bool isEmpty() const
+    {
+        return min.x > max.x || min.y > max.y || min.z > max.z;
+    }
+
+    kame::math::Vector3 getCenter() const
+    {
+        return (min + max) * 0.5f;
+    }
+
+    kame::math::Vector3 getExtents() const
+    {
+        return (max - min) * 0.5f;
+    }
+
+    void merge(kame::math::Vector3 p);
+    void merge(const AABB& b);
+
+    // box around the transformed box, empty stays empty
+    static AABB transform(const AABB& b, const kame::math::Matrix& m);
+};
+
+struct BoundingSphere {
+    kame::math::Vector3 center = kame::math::Vector3::zero();
+    float radius = -1.0f; // negative when empty
+};
+
+AABB computeAABB(const std::vector<kame::math::Vector3>& positions);
+// centered on the box, radius reaches the farthest position
+BoundingSphere computeBoundingSphere(const std::vector<kame::math::Vector3>& positions, const AABB& aabb);
+
+// planes are a*x + b*y + c*z + d >= 0 inside, stored SoA and padded with always-inside planes.
+// the default frustum has no planes and accepts everything.
+struct Frustum {
+    static constexpr int kMAX_PLANES = 8;
+    alignas(16) float a[kMAX_PLANES] = {};
+    alignas(16) float b[kMAX_PLANES] = {};
+    alignas(16) float c[kMAX_PLANES] = {};
+    alignas(16) float d[kMAX_PLANES] = {1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f};
+
+    // extracts the six planes of a row vector view projection with [-1,1] depth
+    static Frustum fromMatrix(const kame::math::Matrix& viewProj);
+
+    bool isVisible(const AABB& box) const;
+    bool isVisible(const BoundingSphere& sphere) const;
+};
+
+// writes 1 for every box touching the frustum and 0 otherwise, returns the number of visible boxes
+size_t cullAABBs(const Frustum& frustum, const AABB* boxes, size_t count, uint8_t* visible);
+
+} // namespace kame::squirtle
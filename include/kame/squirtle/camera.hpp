@@ -2,6 +2,8 @@
 
 #include <kame/kame.hpp>
 
+#include "bounds.hpp"
+
 namespace kame::squirtle {
 
 struct CameraOrbit {
@@ -28,6 +30,8 @@ struct CameraOrbit {
     const kame::math::Matrix& getModelMatrix() const { return modelMtx; };
     const kame::math::Matrix& getViewMatrix() const { return viewMtx; };
     const kame::math::Matrix& getProjectionMatrix() const { return projMtx; };
+    // planes in the space the model matrix is applied to, for Model::frustum
+    Frustum getFrustum() const;
 };
 
 } // namespace kame::squirtle
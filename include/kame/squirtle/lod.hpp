@@ -0,0 +1,47 @@
+#pragma once
+
+#include <kame/kame.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace kame::squirtle {
+
+struct Primitive;
+
+// a coarser index list over the vertices of its primitive
+struct PrimitiveLOD {
+    std::vector<unsigned int> indices;
+    float error = 0.0f; // object space deviation from the full resolution primitive
+};
+
+struct SimplifyOptions {
+    float normalWeight = 0.5f; // penalty for collapsing across differing normals
+    float skinWeight = 1.0f;   // penalty for collapsing across differing joint influences
+};
+
+// quadric error edge collapse on a triangle list. vertices collapse onto their neighbours, so the result
+// reuses the primitive's vertex attributes as they are. UV/normal seams move only as a pair along the seam,
+// open borders only along the border and vertices where more than two attribute sets meet stay in place.
+// stops at targetIndexCount or before the error (in object space) would exceed targetError.
+std::vector<unsigned int> simplify(const Primitive& primitive, const std::vector<unsigned int>& indices, size_t targetIndexCount, float targetError, float* resultError = nullptr, const SimplifyOptions& options = {});
+
+struct LODOptions {
+    int numLevels = 0;        // levels to build in addition to the full resolution one
+    float reduction = 0.5f;   // triangle ratio between consecutive levels
+    float maxError = 0.05f;   // relative to the primitive's extent
+    SimplifyOptions simplify;
+};
+
+// fills primitive.lods for triangle list primitives, stopping early when a level no longer gets smaller
+void generateLODs(Primitive& primitive, const LODOptions& options);
+
+// picks the coarsest level whose error projects below pixelThreshold on screen
+struct LODSelector {
+    kame::math::Vector3 viewPosition = kame::math::Vector3::zero();
+    float projectionScale = 0.0f; // viewport height / (2 * tan(verticalFov / 2)), 0 always picks level 0
+    float pixelThreshold = 1.0f;
+
+    int select(const Primitive& primitive, const kame::math::Matrix& world) const;
+};
+
+} // namespace kame::squirtle
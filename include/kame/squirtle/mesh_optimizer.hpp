@@ -0,0 +1,39 @@
+#pragma once
+
+#include <kame/kame.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace kame::squirtle {
+
+struct Primitive;
+
+struct VertexCacheStatistics {
+    size_t verticesTransformed = 0;
+    float acmr = 0.0f; // average cache miss ratio, transformed vertices per triangle. 0.5 at best
+    float atvr = 0.0f; // average transformed vertex ratio, transformed vertices per vertex. 1.0 at best
+};
+
+struct MeshOptimizationReport {
+    bool isOptimized = false;
+    VertexCacheStatistics before;
+    VertexCacheStatistics after;
+};
+
+// simulates a FIFO post-transform cache of cacheSize entries over a triangle list
+VertexCacheStatistics analyzeVertexCache(const std::vector<unsigned int>& indices, size_t numVertices, unsigned int cacheSize = 16);
+
+// reorders triangles for post-transform cache locality, Tom Forsyth's linear-speed vertex cache optimisation
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t numVertices);
+
+// reorders the cache friendly runs of triangles front to back from the mesh centre to cut overdraw
+void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<kame::math::Vector3>& positions);
+
+// renumbers vertices in order of first use, returns the old -> new remap table. unused vertices go last
+std::vector<unsigned int> optimizeVertexFetch(std::vector<unsigned int>& indices, size_t numVertices);
+
+// runs the passes above on a triangle list primitive and remaps its attributes.
+// other modes are left alone.
+MeshOptimizationReport optimizePrimitive(Primitive& primitive);
+
+} // namespace kame::squirtle
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <kame/kame.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace kame::squirtle {
+
+struct Primitive;
+
+constexpr size_t kMESHLET_MAX_VERTICES = 64;
+constexpr size_t kMESHLET_MAX_TRIANGLES = 124;
+
+// the structs below follow std430 layout so the vectors of MeshletData upload as they are
+// to a GL shader storage buffer or a Vulkan storage buffer
+struct Meshlet {
+    uint32_t vertexOffset = 0;   // into MeshletData::vertices
+    uint32_t triangleOffset = 0; // byte offset into MeshletData::triangles, a multiple of 4
+    uint32_t vertexCount = 0;
+    uint32_t triangleCount = 0;
+};
+
+struct MeshletBounds {
+    kame::math::Vector3 center; // bounding sphere
+    float radius;
+    kame::math::Vector3 coneApex; // normal cone, the meshlet is back facing for viewers inside it
+    float coneCutoff;             // sine of the cone half angle, 1 when the cone is degenerate
+    kame::math::Vector3 coneAxis;
+    float pad;
+};
+
+static_assert(sizeof(Meshlet) == 16);
+static_assert(sizeof(MeshletBounds) == 48);
+
+struct MeshletData {
+    std::vector<Meshlet> meshlets;
+    std::vector<MeshletBounds> bounds; // one per meshlet
+    std::vector<uint32_t> vertices;    // meshlet local vertex -> primitive vertex
+    std::vector<uint8_t> triangles;    // 3 meshlet local vertices per triangle
+};
+
+// splits a triangle list into meshlets in index order, so run optimizeVertexCache() first for tight clusters
+MeshletData buildMeshlets(const Primitive& primitive, size_t maxVertices = kMESHLET_MAX_VERTICES, size_t maxTriangles = kMESHLET_MAX_TRIANGLES);
+
+// cameraPosition in the primitive's object space
+bool isMeshletBackfacing(const MeshletBounds& bounds, const kame::math::Vector3& cameraPosition);
+
+// appends the triangles of a meshlet as primitive indices, to draw CPU culled meshlets from one index buffer
+void appendMeshletIndices(const MeshletData& data, size_t meshlet, std::vector<unsigned int>& indices);
+
+// storage buffers for GPU culling on GL 4.3+, bound with kame::ogl::setShaderStorageBuffer()
+struct MeshletBuffers {
+    kame::ogl::ShaderStorageBuffer* meshlets = nullptr;
+    kame::ogl::ShaderStorageBuffer* bounds = nullptr;
+    kame::ogl::ShaderStorageBuffer* vertices = nullptr;
+    kame::ogl::ShaderStorageBuffer* triangles = nullptr;
+};
+
+MeshletBuffers createMeshletBuffers(const MeshletData& data);
+void deleteMeshletBuffers(MeshletBuffers& buffers);
+
+} // namespace kame::squirtle
@@ -5,12 +5,21 @@
 #include <cstdint>
 #include <unordered_map>
 #include <functional>
+#include <span>
 #include <variant>
 
+#include "bounds.hpp"
 #include "camera.hpp"
 #include "material.hpp"
 #include "animation.hpp"
+#include "animation_compression.hpp"
 #include "instance.hpp"
+#include "vertex_format.hpp"
+#include "mesh_optimizer.hpp"
+#include "lod.hpp"
+#include "meshlet.hpp"
+#include "skinning.hpp"
+#include "transform_hierarchy.hpp"
 
 namespace kame::squirtle {
 
@@ -25,6 +34,12 @@ struct Primitive {
     std::vector<u16Array4> joints;
     std::vector<kame::math::Vector4> weights;
     std::vector<unsigned int> indices;
+    PackedVertices packed; // filled when ImportOptions::packedAttributes is set
+    std::vector<PrimitiveLOD> lods; // coarser levels over the same vertices, lods[0] is level 1
+    MeshletData meshlets;           // clusters of the full resolution indices
+    AABB bounds;                    // from the POSITION accessor min/max when present
+    BoundingSphere sphere;
+    std::vector<AABB> jointBounds; // per skin joint, positions it influences before skinning
     int material = -1;
     GLenum mode = GL_TRIANGLES;
     int id = -1;
@@ -36,12 +51,19 @@ struct Primitive {
     const std::vector<u16Array4>& getJoints() const;
     const std::vector<kame::math::Vector4>& getWeights() const;
     const std::vector<unsigned int>& getIndices() const;
+    const std::vector<unsigned int>& getIndices(int lod) const; // level 0 is indices
 
     size_t getBytesOfPositions() const;
     size_t getBytesOfNormals() const;
     size_t getBytesOfTangents() const;
     size_t getBytesOfUV(size_t i);
     size_t getBytesOfIndices() const;
+
+    // indices in the smallest type the vertex count allows, narrowed from indices on every call so they
+    // follow whatever rewrote indices last. copyIndexData() writes getBytesOfIndexData() bytes
+    GLenum getIndexType() const;
+    size_t getBytesOfIndexData() const;
+    void copyIndexData(void* dst) const;
 };
 
 struct Mesh {
@@ -68,6 +90,12 @@ struct Node {
     int parent = -1;
     std::vector<int> children;
 
+    // in the space of the positions passed to UpdateCB, refreshed by Model::update()
+    AABB worldBounds;
+    std::vector<AABB> primitiveWorldBounds;
+    // skin matrices relative to this node when it has a skin, refreshed by Model::update()
+    std::vector<kame::math::Matrix> jointMatrices;
+
     kame::math::Matrix updateLocalXForm()
     {
         localXForm = kame::math::Matrix::createScale(scale) * kame::math::Matrix::createFromQuaternion(rotation) * kame::math::Matrix::createTranslation(position);
@@ -79,16 +107,30 @@ struct Skin {
     std::vector<kame::math::Matrix> inverseBindMatrices;
     std::vector<int> joints;
     std::vector<kame::math::Matrix> matrices;
+    bool _changed = true; // a joint moved in the last update(), matrices were rebuilt
 };
 
 struct UpdateData {
     const std::vector<kame::math::Vector3>& positions;
     const Model& model;
     const Primitive& primitive;
+    const std::vector<unsigned int>& indices; // of the selected level of detail
+    int lod;
+    const AABB& bounds; // Node::primitiveWorldBounds of the primitive, e.g. for sorting by depth
+    // set when skinning is left to the vertex shader, positions are then the bind pose
+    std::span<const kame::math::Matrix> jointMatrices = {};
 };
 
 using UpdateCB = std::function<void(const UpdateData&)>;
 
+enum SkinningMode {
+    kSKINNING_CPU,
+    kSKINNING_GPU, // joint matrices go to UpdateCB, skins larger than kMAX_GPU_JOINTS stay on the CPU
+};
+
+// std140 mat4 array filling the 16KB minimum uniform block size
+constexpr int kMAX_GPU_JOINTS = 256;
+
 struct Model {
     std::vector<Mesh> meshes;
     std::vector<Node> nodes;
@@ -97,16 +139,45 @@ struct Model {
     std::vector<Texture> textures;
     std::vector<Image> images;
     bool _isSkinnedMesh = false;
+    LODSelector lodSelector; // picks the level each primitive is updated and drawn at
+    Frustum frustum;         // primitives outside are not updated, the default keeps everything
+    SkinningMode skinningMode = kSKINNING_CPU;
+    Skinner skinner;              // method and threads of kSKINNING_CPU
+    std::vector<uint8_t> _visible; // scratch of update()
+    TransformHierarchy transforms; // flattened node transforms, built by the first update()
 
     bool isSkinnedMesh()
     {
         return _isSkinnedMesh;
     }
 
+    // update() recomputes the nodes whose position, rotation or scale changed since the last update(),
+    // however they were written, and their subtrees. markDirty() forces a node's recompute regardless.
+    void setLocalTransform(int nodeID, kame::math::Vector3 position, kame::math::Quaternion rotation, kame::math::Vector3 scale);
+    void markDirty(int nodeID);
+    void markAllDirty();
+
     void update(std::vector<kame::math::Vector3>& positions, UpdateCB fn);
 };
 
-Model* importModel(const kame::gltf::Gltf* gltf);
+struct ImportOptions {
+    // threads decoding primitives, 1 imports serially and 0 uses all hardware threads.
+    // output order does not depend on the thread count.
+    int numThreads = 1;
+    // vertexAttributeBit() mask of attributes to interleave into Primitive::packed, 0 skips packing
+    uint32_t packedAttributes = 0;
+    // runs optimizePrimitive() on every primitive and logs the vertex cache statistics
+    bool optimizeMeshes = false;
+    LODOptions lod;
+    // fills Primitive::meshlets with buildMeshlets()
+    bool generateMeshlets = false;
+};
+
+Model* importModel(const kame::gltf::Gltf* gltf, const ImportOptions& options = {});
 float animate(AnimationClip& clip, std::vector<Node>& nodes, float playTime);
+float animate(CompressedAnimationClip& clip, std::vector<Node>& nodes, float playTime);
+// animates the model's nodes and marks the animated ones dirty
+float animate(AnimationClip& clip, Model& model, float playTime);
+float animate(CompressedAnimationClip& clip, Model& model, float playTime);
 
 } // namespace kame::squirtle
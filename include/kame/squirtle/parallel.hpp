@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace kame::squirtle {
+
+// fixed size pool of worker threads running parallelFor() jobs with work stealing.
+// the calling thread takes part in every job, so a pool of N threads spawns N-1 workers.
+struct ThreadPool {
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::pair<size_t, size_t>> ranges;
+    };
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<Queue>> queues; // one per thread, [0] is the calling thread
+    std::mutex mutex;
+    std::condition_variable wakeCV;
+    std::condition_variable doneCV;
+    const std::function<void(size_t, size_t)>* job = nullptr;
+    uint64_t generation = 0;
+    std::atomic<size_t> pending = 0;
+    bool isShutdown = false;
+
+    // numThreads <= 0 uses all hardware threads
+    explicit ThreadPool(int numThreads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    void operator=(const ThreadPool&) = delete;
+
+    int getNumThreads() const
+    {
+        return int(queues.size());
+    }
+
+    // calls fn(begin, end) over [0, count) split into ranges of grainSize, returns when all ranges are done.
+    void parallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& fn);
+
+private:
+    bool runOne(size_t self);
+    void workerMain(size_t self);
+};
+
+} // namespace kame::squirtle
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <kame/kame.hpp>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "animation.hpp"
+#include "animation_compression.hpp"
+
+namespace kame::squirtle {
+
+struct Node;
+struct Model;
+
+// local transforms of every node of a model, SoA so blends run over flat arrays.
+// poses are sized once, assigning one pose to another of the same size does not allocate.
+struct Pose {
+    std::vector<kame::math::Vector3> positions;
+    std::vector<kame::math::Quaternion> rotations;
+    std::vector<kame::math::Vector3> scales;
+
+    void resize(size_t numNodes);
+    size_t size() const
+    {
+        return positions.size();
+    }
+};
+
+// copies the nodes' local transforms, e.g. the rest pose after importModel()
+void readPose(const std::vector<Node>& nodes, Pose& pose);
+// writes the pose into the nodes, the global transforms are refreshed by Model::update()
+void applyPose(const Pose& pose, std::vector<Node>& nodes);
+// same, marking the nodes whose transform differs dirty so Model::update() skips the rest
+void applyPose(const Pose& pose, Model& model);
+
+// overwrites the animated nodes of pose with the clip at time, clamped to its keys
+void samplePose(AnimationClip& clip, float time, Pose& pose);
+void samplePose(CompressedAnimationClip& clip, float time, Pose& pose);
+
+// out = a towards b by weight, mask holds an optional per node factor on weight. out may alias a or b.
+void blendPose(const Pose& a, const Pose& b, float weight, Pose& out, std::span<const float> mask = {});
+// out = base plus weight times the motion from reference to pose. out may alias base.
+void addPose(const Pose& base, const Pose& pose, const Pose& reference, float weight, Pose& out, std::span<const float> mask = {});
+
+// plays clips on a model through preallocated poses: a crossfading base clip with blended or
+// additive layers on top. only play(), addLayer() and init() allocate.
+// e.g. animator.play(walk, 0.3f); animator.update(dt); animator.apply(*model);
+struct Animator {
+    struct Layer {
+        AnimationClip* clip = nullptr;
+        float time = 0.0f;
+        float speed = 1.0f;
+        float weight = 1.0f;
+        bool loop = true;
+        bool additive = false; // adds the motion relative to the clip's first frame
+        std::vector<float> mask; // per node, addLayer() fills an empty one with 1 for the clip's animated nodes
+        Pose reference;          // first frame of additive layers
+    };
+
+    Pose restPose; // nodes no clip animates keep this
+    Pose pose;     // the result of update()
+
+    Layer base;
+    Layer fadingOut;
+    float fadeDuration = 0.0f;
+    float fadeElapsed = 0.0f;
+    std::vector<Layer> layers; // applied in order after the base
+
+    Pose basePose;
+    Pose fadePose;
+    Pose layerPose;
+
+    // sets the rest pose and sizes every pose, call before anything else
+    void init(const std::vector<Node>& nodes);
+    // crossfades from the current clip over fadeTime seconds, 0 cuts
+    void play(AnimationClip& clip, float fadeTime = 0.0f, bool loop = true);
+    size_t addLayer(AnimationClip& clip, float weight, bool additive, std::vector<float> mask = {});
+    // advances every clip by dt seconds and blends the result into pose
+    void update(float dt);
+    void apply(std::vector<Node>& nodes) const
+    {
+        applyPose(pose, nodes);
+    }
+    void apply(Model& model) const
+    {
+        applyPose(pose, model);
+    }
+};
+
+} // namespace kame::squirtle
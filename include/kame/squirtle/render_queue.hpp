@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace kame::squirtle {
+
+// 64 bit sort key, fields from the most significant bit:
+//   pass 4 | shader 10 | material 14 | texture 16 | depth 20
+// draws sharing a pass, shader, material and texture end up next to each other, front to back within.
+// the ids are the renderer's, e.g. a GL program slot or a Vulkan pipeline index, values wrap at their width.
+constexpr int kSORT_KEY_PASS_BITS = 4;
+constexpr int kSORT_KEY_SHADER_BITS = 10;
+constexpr int kSORT_KEY_MATERIAL_BITS = 14;
+constexpr int kSORT_KEY_TEXTURE_BITS = 16;
+constexpr int kSORT_KEY_DEPTH_BITS = 20;
+
+uint64_t makeSortKey(uint32_t pass, uint32_t shader, uint32_t material, uint32_t texture, uint32_t depth);
+uint32_t getSortKeyPass(uint64_t key);
+uint32_t getSortKeyShader(uint64_t key);
+uint32_t getSortKeyMaterial(uint64_t key);
+uint32_t getSortKeyTexture(uint64_t key);
+uint32_t getSortKeyDepth(uint64_t key);
+
+// view depth in [nearZ, farZ] to the depth field, clamped. flip it for back to front passes such as blending.
+uint32_t quantizeSortDepth(float depth, float nearZ, float farZ, bool backToFront = false);
+
+// the fields that differ from the previous draw, the first draw of a submit() changes everything
+enum RenderChange : uint32_t {
+    kRENDER_CHANGE_PASS = 1 << 0,
+    kRENDER_CHANGE_SHADER = 1 << 1,
+    kRENDER_CHANGE_MATERIAL = 1 << 2,
+    kRENDER_CHANGE_TEXTURE = 1 << 3,
+};
+
+struct DrawPacket {
+    uint64_t key;
+    uint32_t index; // into the draw data of the caller
+};
+
+// accumulated over submit() calls, e.g. reset per frame with stats = {}
+struct RenderStats {
+    uint64_t draws = 0;
+    uint64_t passChanges = 0;
+    uint64_t shaderChanges = 0;
+    uint64_t materialChanges = 0;
+    uint64_t textureChanges = 0;
+};
+
+using SubmitCB = std::function<void(const DrawPacket& packet, uint32_t changes)>;
+
+// packets of a frame from any number of models, radix sorted by key and handed back in order with the
+// RenderChange bits of what the backend has to rebind. backend neutral, the packet index selects the
+// GL or Vulkan side draw data the caller collected, e.g. from the UpdateCB of Model::update():
+//   queue.clear();
+//   model->update(positions, [&](const UpdateData& d) { queue.push(key, draws.size()); draws.push_back(...); });
+//   queue.sort();
+//   queue.submit([&](const DrawPacket& p, uint32_t changes) { ... });
+struct RenderQueue {
+    std::vector<DrawPacket> packets;
+    std::vector<DrawPacket> _scratch; // other buffer of the radix sort
+    RenderStats stats;
+
+    void clear()
+    {
+        packets.clear();
+    }
+    void push(uint64_t key, uint32_t index)
+    {
+        packets.push_back({key, index});
+    }
+    // stable, equal keys keep the order they were pushed in
+    void sort();
+    void submit(const SubmitCB& fn);
+};
+
+} // namespace kame::squirtle
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <kame/kame.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace kame::squirtle {
+
+struct Model;
+
+// the static primitives of a model merged into one vertex and one index array, a draw per node and primitive.
+// vertices stay in mesh space and draws refer to their node, so a draw's transform is Node::globalXForm and
+// meshes instanced by several nodes are stored once. draws are ordered by material, e.g. one indirect
+// multi draw per texture covers the scene.
+// only level 0 of a primitive is packed, Primitive::lods and the model's LODSelector are not used: the pack is
+// built once for every camera, so keep models that rely on their coarser levels on the per frame path.
+struct ScenePack {
+    struct Draw {
+        uint32_t firstIndex;
+        uint32_t indexCount;
+        int32_t baseVertex;
+        int node;
+        int primitive; // in the node's mesh
+        int material;  // -1 without one
+    };
+
+    std::vector<kame::math::Vector3> positions;
+    std::vector<kame::math::Vector2> uvs; // the material's base color texcoord set, zero for untextured ones
+    std::vector<unsigned int> indices;    // relative to Draw::baseVertex
+    std::vector<Draw> draws;
+    size_t numSkipped = 0; // primitives of skinned nodes, other modes than GL_TRIANGLES or textured without
+                           // their texcoord set, not packed
+};
+
+ScenePack packScene(const Model& model);
+
+} // namespace kame::squirtle
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <kame/kame.hpp>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "parallel.hpp"
+
+namespace kame::squirtle {
+
+enum SkinningMethod {
+    kSKINNING_METHOD_LINEAR_BLEND,
+    kSKINNING_METHOD_DUAL_QUATERNION, // keeps volume at twisted joints, ignores joint scale
+};
+
+// affine joint transform as the three used columns of a row vector matrix, x' = dot((p, 1), c[0])
+struct alignas(16) JointMatrix3x4 {
+    float c[3][4];
+};
+
+// rigid joint transform, real is the rotation and dual encodes the translation
+struct alignas(16) JointDualQuaternion {
+    float real[4]; // x, y, z, w
+    float dual[4];
+};
+
+JointMatrix3x4 toJointMatrix3x4(const kame::math::Matrix& m);
+JointDualQuaternion toJointDualQuaternion(const kame::math::Matrix& m);
+
+struct SkinnedVertices {
+    const kame::math::Vector3* positions = nullptr;
+    const std::array<uint16_t, 4>* joints = nullptr;
+    const kame::math::Vector4* weights = nullptr;
+    size_t numVertices = 0;
+};
+
+// kernels over vertices [begin, end), SIMD when available
+void skinLinearBlend(const SkinnedVertices& vertices, const JointMatrix3x4* joints, size_t begin, size_t end, kame::math::Vector3* out);
+void skinDualQuaternion(const SkinnedVertices& vertices, const JointDualQuaternion* joints, size_t begin, size_t end, kame::math::Vector3* out);
+
+// per model CPU skinning state, models can be skinned from different threads at once.
+// e.g. skinner.setJoints(node.jointMatrices); skinner.skin(vertices, positions.data());
+struct Skinner {
+    SkinningMethod method = kSKINNING_METHOD_LINEAR_BLEND;
+    int numThreads = 1;      // 0 uses all hardware threads
+    size_t grainSize = 4096; // vertices per task
+
+    std::vector<JointMatrix3x4> matrices;
+    std::vector<JointDualQuaternion> dualQuaternions;
+    std::unique_ptr<ThreadPool> pool; // created on the first threaded skin()
+
+    void setJoints(std::span<const kame::math::Matrix> jointMatrices);
+    // every vertex once, joint indices must be below the number of joints set
+    void skin(const SkinnedVertices& vertices, kame::math::Vector3* out);
+};
+
+} // namespace kame::squirtle
@@ -1,4 +1,8 @@
 #include "model.hpp"
+#include "pose.hpp"
+#include "parallel.hpp"
+#include "render_queue.hpp"
+#include "scene_pack.hpp"
 
 namespace kame::squirtle {
 
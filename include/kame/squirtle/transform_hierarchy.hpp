@@ -0,0 +1,71 @@
+#pragma once
+
+#include <kame/kame.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace kame::squirtle {
+
+struct Node;
+
+// affine row vector transform as the three used columns of a Matrix, c[j] = (m1j, m2j, m3j, m4j).
+// the fourth column is always (0, 0, 0, 1).
+struct alignas(16) Affine3x4 {
+    float c[3][4];
+
+    static Affine3x4 identity();
+    static Affine3x4 fromMatrix(const kame::math::Matrix& m);
+    kame::math::Matrix toMatrix() const;
+    // same as Matrix::createScale(s) * createFromQuaternion(r) * createTranslation(t)
+    static Affine3x4 compose(kame::math::Vector3 t, kame::math::Quaternion r, kame::math::Vector3 s);
+    // a * b, SIMD when available
+    static Affine3x4 multiply(const Affine3x4& a, const Affine3x4& b);
+};
+
+// node transforms flattened depth first, parents precede children and every subtree is contiguous.
+// local TRS is kept SoA, update() walks the range below dirty nodes once with world = local * parent world.
+// skinned mesh nodes ignore their parent's transform, as Model::update() always has.
+struct TransformHierarchy {
+    std::vector<int> nodeIDs;          // hierarchy index to node id
+    std::vector<uint32_t> indices;     // node id to hierarchy index
+    std::vector<int> parents;          // hierarchy index of the parent, -1 for roots
+    std::vector<uint32_t> subtreeEnds; // one past the last descendant
+
+    std::vector<kame::math::Vector3> positions;
+    std::vector<kame::math::Quaternion> rotations;
+    std::vector<kame::math::Vector3> scales;
+    std::vector<Affine3x4> locals;
+    std::vector<Affine3x4> worlds;
+
+    std::vector<uint8_t> dirty;   // local TRS changed since the last update()
+    std::vector<uint8_t> changed; // world recomputed by the last update(), all set ones lie in [updatedBegin, updatedEnd)
+    uint32_t dirtyBegin = 0;
+    uint32_t dirtyEnd = 0;
+    uint32_t updatedBegin = 0;
+    uint32_t updatedEnd = 0;
+
+    // copies the nodes' TRS and marks everything dirty
+    void build(const std::vector<Node>& nodes);
+    size_t size() const
+    {
+        return nodeIDs.size();
+    }
+
+    void setLocal(int nodeID, kame::math::Vector3 position, kame::math::Quaternion rotation, kame::math::Vector3 scale);
+    void markDirty(uint32_t index)
+    {
+        dirty[index] = 1;
+        dirtyBegin = std::min(dirtyBegin, index);
+        dirtyEnd = std::max(dirtyEnd, subtreeEnds[index]);
+    }
+
+    // recomputes the dirty locals and the worlds below them, returns the number of worlds recomputed
+    size_t update();
+
+    const Affine3x4& getWorld(int nodeID) const
+    {
+        return worlds[indices[nodeID]];
+    }
+};
+
+} // namespace kame::squirtle
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <kame/kame.hpp>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace kame::squirtle {
+
+struct Primitive;
+
+enum VertexAttribute {
+    kVERTEX_ATTRIBUTE_POSITION, // float x 3
+    kVERTEX_ATTRIBUTE_NORMAL,   // octahedral snorm16 x 2
+    kVERTEX_ATTRIBUTE_TANGENT,  // snorm8 x 4, w is the handedness
+    kVERTEX_ATTRIBUTE_UV0,      // half x 2
+    kVERTEX_ATTRIBUTE_UV1,      // half x 2
+    kVERTEX_ATTRIBUTE_JOINTS,   // uint8 x 4, uint16 x 4 if a joint index exceeds 255
+    kVERTEX_ATTRIBUTE_WEIGHTS,  // unorm8 x 4
+    kVERTEX_ATTRIBUTE_COUNT
+};
+
+constexpr uint32_t vertexAttributeBit(VertexAttribute a)
+{
+    return 1u << a;
+}
+
+constexpr uint32_t kVERTEX_ATTRIBUTES_ALL = (1u << kVERTEX_ATTRIBUTE_COUNT) - 1;
+
+struct PackedAttribute {
+    GLuint componentSize = 0;
+    GLenum type = 0;
+    GLboolean normalized = GL_FALSE;
+    uint32_t offset = 0;
+    bool isInteger = false; // bound with bindIntegerAttribute(), e.g. joints for a uvec4 input
+};
+
+// interleaved vertices ready for a single VBO
+struct PackedVertices {
+    uint32_t attributes = 0; // vertexAttributeBit() of the attributes present
+    uint32_t stride = 0;
+    size_t numVertices = 0;
+    std::array<PackedAttribute, kVERTEX_ATTRIBUTE_COUNT> layout;
+    std::vector<uint8_t> data;
+
+    bool hasAttribute(VertexAttribute a) const
+    {
+        return (attributes & vertexAttributeBit(a)) != 0;
+    }
+};
+
+// attributes requested but missing from the primitive are left out of the layout
+PackedVertices packVertices(const Primitive& primitive, uint32_t attributes = kVERTEX_ATTRIBUTES_ALL);
+
+// binds every attribute of packed with a location >= 0, call between vao.begin() and vao.end().
+// joints are integers, declare them as uvec4 in the shader.
+// the normal has to be decoded in the shader, e.g.
+//   vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+//   if (n.z < 0.0) n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+//   n = normalize(n);
+kame::ogl::VertexArrayObject& bindPackedVertices(kame::ogl::VertexArrayObject& vao, const kame::ogl::VertexBuffer* vbo, const PackedVertices& packed, const std::array<GLint, kVERTEX_ATTRIBUTE_COUNT>& locations);
+
+uint16_t packHalf(float v);
+float unpackHalf(uint16_t h);
+std::array<int16_t, 2> packOctahedral(const kame::math::Vector3& n);
+kame::math::Vector3 unpackOctahedral(const std::array<int16_t, 2>& e);
+
+} // namespace kame::squirtle
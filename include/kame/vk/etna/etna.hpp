@@ -20,6 +20,14 @@ struct StagingBuffer : BufferVK {};
 
 struct SSBO : BufferVK {};
 
+// storage buffers holding a kame::squirtle::MeshletData for compute culling
+struct MeshletBuffers {
+    SSBO meshlets;
+    SSBO bounds;
+    SSBO vertices;
+    SSBO triangles;
+};
+
 struct GraphicsPipeLineCreateInfo {
 
     std::vector<VkDynamicState> dynamicStates = {
@@ -177,6 +185,58 @@ struct Etna : kame::vk::Vulkan {
 
         destroyStagingBuffer(stagingBuffer);
     }
+
+    // host visible so the joint matrices of kame::squirtle::UpdateData can be written every frame
+    void createJointSSBO(uint32_t numJoints, SSBO& bufferResult)
+    {
+        VkDeviceSize size = sizeof(kame::math::Matrix) * numJoints;
+        VkBuffer ssboBuffer = createBuffer(
+            VkBufferCreateInfo{
+                .size = size,
+                .usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT});
+
+        VkMemoryRequirements req = getBufferMemoryRequirements(ssboBuffer);
+
+        VkDeviceMemory memory = allocateDeviceMemory(req, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        assert(memory);
+
+        bindBufferMemory(ssboBuffer, memory);
+
+        bufferResult._buffer = ssboBuffer;
+        bufferResult._memory = memory;
+        bufferResult._size = size;
+    }
+
+    void updateJointSSBO(SSBO& ssbo, std::span<const kame::math::Matrix> jointMatrices)
+    {
+        assert(sizeof(kame::math::Matrix) * jointMatrices.size() <= ssbo._size);
+        memcpyDeviceMemory(ssbo._memory, jointMatrices.data(), sizeof(kame::math::Matrix) * jointMatrices.size());
+    }
+
+    void createMeshletBuffers(const kame::squirtle::MeshletData& data, MeshletBuffers& buffersResult)
+    {
+        assert(!data.meshlets.empty());
+
+        createSSBO(sizeof(kame::squirtle::Meshlet) * data.meshlets.size(), buffersResult.meshlets);
+        updateSSBO(buffersResult.meshlets, data.meshlets.data());
+
+        createSSBO(sizeof(kame::squirtle::MeshletBounds) * data.bounds.size(), buffersResult.bounds);
+        updateSSBO(buffersResult.bounds, data.bounds.data());
+
+        createSSBO(sizeof(uint32_t) * data.vertices.size(), buffersResult.vertices);
+        updateSSBO(buffersResult.vertices, data.vertices.data());
+
+        createSSBO(data.triangles.size(), buffersResult.triangles);
+        updateSSBO(buffersResult.triangles, data.triangles.data());
+    }
+
+    void destroyMeshletBuffers(MeshletBuffers& buffers)
+    {
+        destroySSBO(buffers.meshlets);
+        destroySSBO(buffers.bounds);
+        destroySSBO(buffers.vertices);
+        destroySSBO(buffers.triangles);
+    }
 };
 
 } // namespace kame::vk::etna
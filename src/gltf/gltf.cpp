@@ -5,8 +5,6 @@ using json = nlohmann::json;
 
 namespace kame::gltf {
 
-std::vector<uint8_t> decodeBase64(const std::string& str, integer start);
-
 extern void loadTextures(Gltf* gltf, json& j);
 extern void loadImages(Gltf* gltf, json& j);
 extern void loadSamplers(Gltf* gltf, json& j);
@@ -142,35 +140,54 @@ void loadBuffers(Gltf* gltf, json& j)
             buffer.uri = e["uri"].get<std::string>();
             if (pystring::startswith(buffer.uri, "data:application/octet-stream;base64,"))
             {
-                assert(((buffer.uri.size() - std::string("data:application/octet-stream;base64,").size()) % 4) == 0);
-                buffer.binaryData = decodeBase64(buffer.uri, std::string("data:application/octet-stream;base64,").size());
+                const size_t start = std::string("data:application/octet-stream;base64,").size();
+                if (!decodeBase64(buffer.uri.data() + start, buffer.uri.size() - start, buffer.binaryData))
+                {
+                    SPDLOG_CRITICAL("invalid base64 data in buffer {}", gltf->buffers.size());
+                    assert(false);
+                }
                 assert(buffer.binaryData.size() == buffer.byteLength);
             }
             else if (pystring::endswith(buffer.uri, ".bin"))
             {
                 std::filesystem::path path(gltf->basePath);
                 path /= buffer.uri;
-                SDL_IOStream* fp = SDL_IOFromFile(path.string().c_str(), "rb");
-                assert(fp);
-                Sint64 len = SDL_GetIOSize(fp);
-                assert(len >= 0);
-                assert(kame::gltf::integer(len) == buffer.byteLength);
-                buffer.binaryData.resize(len + 1);
-
-                Sint64 nb_read_total = 0, nb_read = 1;
-                auto* buf = buffer.binaryData.data();
-                while (nb_read_total < len && nb_read != 0)
+                if (gltf->options.useMemoryMapping)
                 {
-                    nb_read = SDL_ReadIO(fp, buf, (len - nb_read_total));
-                    nb_read_total += nb_read;
-                    buf += nb_read;
+                    buffer.mapping = mapFile(path.string().c_str());
+                    assert(buffer.mapping);
+                    assert(buffer.byteLength <= buffer.mapping->size);
+                    buffer.binaryView = std::span<const uint8_t>(buffer.mapping->data, buffer.byteLength);
+                }
+                else
+                {
+                    SDL_IOStream* fp = SDL_IOFromFile(path.string().c_str(), "rb");
+                    assert(fp);
+                    Sint64 len = SDL_GetIOSize(fp);
+                    assert(len >= 0);
+                    assert(kame::gltf::integer(len) == buffer.byteLength);
+                    buffer.binaryData.resize(len);
+
+                    Sint64 nb_read_total = 0, nb_read = 1;
+                    auto* buf = buffer.binaryData.data();
+                    while (nb_read_total < len && nb_read != 0)
+                    {
+                        nb_read = SDL_ReadIO(fp, buf, (len - nb_read_total));
+                        nb_read_total += nb_read;
+                        buf += nb_read;
+                    }
+                    SDL_CloseIO(fp);
+                    assert(nb_read_total == len);
                 }
-                SDL_CloseIO(fp);
-                assert(nb_read_total == len);
-
-                buffer.binaryData.back() = '\0';
             }
         }
+        else if (gltf->isGLB && gltf->buffers.empty())
+        {
+            // the first buffer without uri refers to the BIN chunk
+            assert(!gltf->glbBinChunk.empty());
+            assert(buffer.byteLength <= gltf->glbBinChunk.size());
+            buffer.binaryView = gltf->glbBinChunk.first(buffer.byteLength);
+        }
         gltf->buffers.emplace_back(buffer);
     }
 }
@@ -243,14 +260,14 @@ void loadAccessors(Gltf* gltf, json& j)
         {
             for (auto& x : e["max"])
             {
-                accessor.max.emplace_back(x.get<integer>());
+                accessor.max.emplace_back(x.get<double>());
             }
         }
         if (e.contains("min"))
         {
             for (auto& x : e["min"])
             {
-                accessor.min.emplace_back(x.get<integer>());
+                accessor.min.emplace_back(x.get<double>());
             }
         }
         accessor.componentType = e["componentType"].get<integer>();
@@ -376,31 +393,65 @@ void loadSkins(Gltf* gltf, json& j)
     }
 }
 
-Gltf* loadGLTF(const char* path)
+Gltf* loadGLTF(const char* path, const LoadOptions& options)
 {
 
     assert(std::filesystem::exists(path));
 
+    if (options.useMemoryMapping)
+    {
+        std::shared_ptr<MappedFile> mapping = mapFile(path);
+        assert(mapping);
+        assert(mapping->size <= std::numeric_limits<uint32_t>::max());
+
+        Gltf* gltf = loadGLTFFromMemory(mapping->data, mapping->size, path, options);
+
+        if (gltf->isGLB)
+        {
+            gltf->fileMapping = mapping;
+        }
+
+        return gltf;
+    }
+
     int64_t len;
-    const unsigned char* buf = (const unsigned char*)kame::squirtle::loadFile(path, len);
+    char* buf = kame::squirtle::loadFile(path, len);
     assert(buf);
     assert(len > 0 && len <= std::numeric_limits<uint32_t>::max());
 
-    Gltf* gltf = loadGLTFFromMemory(buf, len, path);
+    Gltf* gltf = loadGLTFFromMemory((const unsigned char*)buf, len, path, options);
+
+    if (gltf->isGLB)
+    {
+        // keep the file image alive, buffers point into it
+        gltf->fileData = buf;
+    }
+    else
+    {
+        free(buf);
+    }
 
     return gltf;
 }
 
-Gltf* loadGLTFFromMemory(const unsigned char* src, unsigned int len, const char* path)
+static constexpr uint32_t kGLBMagic = 0x46546C67;     // "glTF"
+static constexpr uint32_t kGLBChunkJSON = 0x4E4F534A; // "JSON"
+static constexpr uint32_t kGLBChunkBIN = 0x004E4942;  // "BIN\0"
+
+static uint32_t readU32LE(const unsigned char* p)
 {
-    Gltf* gltf = new Gltf();
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
 
-    SPDLOG_DEBUG("[Gltf] loading: {0}", path);
-    json j = json::parse(src, src + len, nullptr);
-    assert(!j.is_discarded());
+bool isGLB(const unsigned char* src, unsigned int len)
+{
+    return len >= 12 && readU32LE(src) == kGLBMagic;
+}
 
-    gltf->path = std::string(path);
-    gltf->basePath = std::filesystem::path(gltf->path).parent_path().string();
+static void loadGLTFFromJSON(Gltf* gltf, const unsigned char* begin, const unsigned char* end)
+{
+    json j = json::parse(begin, end, nullptr);
+    assert(!j.is_discarded());
 
     if (j.contains("scene"))
     {
@@ -420,111 +471,90 @@ Gltf* loadGLTFFromMemory(const unsigned char* src, unsigned int len, const char*
     loadImages(gltf, j);
     loadSamplers(gltf, j);
     loadMaterials(gltf, j);
-
-    SPDLOG_DEBUG("[Gltf] loaded: {0}", path);
-
-    return gltf;
 }
 
-void deleteGLTF(Gltf* gltf)
+static void loadGLB(Gltf* gltf, const unsigned char* src, unsigned int len)
 {
-    for (auto& node : gltf->nodes)
-    {
-        if (node.hasExtensions)
-        {
-            assert(node.extensions);
-            if (node.extensions->hasEXT_mesh_gpu_instancing)
-            {
-                assert(node.extensions->EXT_mesh_gpu_instancing);
-                delete node.extensions->EXT_mesh_gpu_instancing;
-            }
-            delete node.extensions;
-        }
-    }
-    delete gltf;
-}
+    // https://registry.khronos.org/glTF/specs/2.0/glTF-2.0.html#binary-gltf-layout
+    uint32_t version = readU32LE(src + 4);
+    uint32_t length = readU32LE(src + 8);
+    assert(version == 2);
+    assert(length <= len);
 
-int b64ToInt(std::string c)
-{
-    if (pystring::isalpha(c))
+    const unsigned char* json = nullptr;
+    uint32_t jsonLength = 0;
+
+    uint32_t offset = 12;
+    while (offset + 8 <= length)
     {
-        if (pystring::isupper(c))
+        uint32_t chunkLength = readU32LE(src + offset);
+        uint32_t chunkType = readU32LE(src + offset + 4);
+        offset += 8;
+        assert(chunkLength <= length - offset);
+
+        if (chunkType == kGLBChunkJSON)
         {
-            return c[0] - 'A';
+            assert(json == nullptr);
+            json = src + offset;
+            jsonLength = chunkLength;
         }
-        else
+        else if (chunkType == kGLBChunkBIN)
         {
-            return c[0] - 'a' + 26;
+            assert(json != nullptr);
+            assert(gltf->glbBinChunk.empty());
+            gltf->glbBinChunk = std::span<const uint8_t>(src + offset, chunkLength);
         }
+        // unknown chunks are skipped
+
+        offset += chunkLength;
     }
-    else if (pystring::isdigit(c))
-    {
-        return c[0] - '0' + 52;
-    }
-    else if (c == "+")
-    {
-        return 62;
-    }
-    else if (c == "/")
-    {
-        return 63;
-    }
-    else if (c == "=")
+    assert(json);
+
+    loadGLTFFromJSON(gltf, json, json + jsonLength);
+}
+
+Gltf* loadGLTFFromMemory(const unsigned char* src, unsigned int len, const char* path, const LoadOptions& options)
+{
+    Gltf* gltf = new Gltf();
+    gltf->options = options;
+
+    SPDLOG_DEBUG("[Gltf] loading: {0}", path);
+
+    gltf->path = std::string(path);
+    gltf->basePath = std::filesystem::path(gltf->path).parent_path().string();
+
+    if (isGLB(src, len))
     {
-        return 64;
+        gltf->isGLB = true;
+        loadGLB(gltf, src, len);
     }
     else
     {
-        return -1;
+        loadGLTFFromJSON(gltf, src, src + len);
     }
+
+    SPDLOG_DEBUG("[Gltf] loaded: {0}", path);
+
+    return gltf;
 }
 
-std::vector<uint8_t> decodeBase64(const std::string& str, integer start)
+void deleteGLTF(Gltf* gltf)
 {
-    std::vector<uint8_t> data;
-
-    for (integer i = start; i < str.size(); i += 4)
+    for (auto& node : gltf->nodes)
     {
-        int decode[4];
-        unsigned int bytes;
-
-        decode[0] = b64ToInt(std::string{str[i + 0]});
-        decode[1] = b64ToInt(std::string{str[i + 1]});
-        decode[2] = b64ToInt(std::string{str[i + 2]});
-        decode[3] = b64ToInt(std::string{str[i + 3]});
-        for (int n : decode)
-        {
-            assert(n >= 0);
-        }
-
-        if (decode[2] == 64 && decode[3] == 64)
-        {
-            decode[1] = decode[1] & 0b11110000;
-            bytes = decode[0] << 6 | decode[1];
-            bytes = bytes << 12;
-            data.emplace_back(bytes >> 16);
-        }
-        else if (decode[3] == 64)
-        {
-            decode[2] = decode[2] & 0b11111100;
-            bytes = decode[0] << 6 | decode[1];
-            bytes = bytes << 6 | decode[2];
-            bytes = bytes << 6;
-            data.emplace_back(bytes >> 16);
-            data.emplace_back(bytes >> 8);
-        }
-        else
+        if (node.hasExtensions)
         {
-            bytes = decode[0] << 6 | decode[1];
-            bytes = bytes << 6 | decode[2];
-            bytes = bytes << 6 | decode[3];
-            data.emplace_back(bytes >> 16);
-            data.emplace_back(bytes >> 8);
-            data.emplace_back(bytes);
+            assert(node.extensions);
+            if (node.extensions->hasEXT_mesh_gpu_instancing)
+            {
+                assert(node.extensions->EXT_mesh_gpu_instancing);
+                delete node.extensions->EXT_mesh_gpu_instancing;
+            }
+            delete node.extensions;
         }
     }
-
-    return data;
+    free(gltf->fileData);
+    delete gltf;
 }
 
 } // namespace kame::gltf
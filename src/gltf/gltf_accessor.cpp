@@ -0,0 +1,163 @@
+#include <all.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KAME_GLTF_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace kame::gltf {
+
+integer getComponentSize(integer componentType)
+{
+    switch (componentType)
+    {
+        case kCOMPONENT_TYPE_BYTE:
+        case kCOMPONENT_TYPE_UNSIGNED_BYTE:
+            return 1;
+        case kCOMPONENT_TYPE_SHORT:
+        case kCOMPONENT_TYPE_UNSIGNED_SHORT:
+            return 2;
+        case kCOMPONENT_TYPE_UNSIGNED_INT:
+        case kCOMPONENT_TYPE_FLOAT:
+            return 4;
+        default:
+            assert(false && "unknown componentType");
+            return 0;
+    }
+}
+
+integer getNumComponents(const std::string& type)
+{
+    if (type == "SCALAR")
+    {
+        return 1;
+    }
+    else if (type == "VEC2")
+    {
+        return 2;
+    }
+    else if (type == "VEC3")
+    {
+        return 3;
+    }
+    else if (type == "VEC4" || type == "MAT2")
+    {
+        return 4;
+    }
+    else if (type == "MAT3")
+    {
+        return 9;
+    }
+    else if (type == "MAT4")
+    {
+        return 16;
+    }
+    assert(false && "unknown accessor type");
+    return 0;
+}
+
+namespace detail {
+
+void widen(const uint8_t* src, uint16_t* dst, size_t n)
+{
+    size_t i = 0;
+#ifdef KAME_GLTF_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_unpacklo_epi8(v, zero));
+        _mm_storeu_si128((__m128i*)(dst + i + 8), _mm_unpackhi_epi8(v, zero));
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        dst[i] = src[i];
+    }
+}
+
+void widen(const uint8_t* src, uint32_t* dst, size_t n)
+{
+    size_t i = 0;
+#ifdef KAME_GLTF_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_unpacklo_epi16(lo, zero));
+        _mm_storeu_si128((__m128i*)(dst + i + 4), _mm_unpackhi_epi16(lo, zero));
+        _mm_storeu_si128((__m128i*)(dst + i + 8), _mm_unpacklo_epi16(hi, zero));
+        _mm_storeu_si128((__m128i*)(dst + i + 12), _mm_unpackhi_epi16(hi, zero));
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        dst[i] = src[i];
+    }
+}
+
+void widen(const uint16_t* src, uint32_t* dst, size_t n)
+{
+    size_t i = 0;
+#ifdef KAME_GLTF_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_unpacklo_epi16(v, zero));
+        _mm_storeu_si128((__m128i*)(dst + i + 4), _mm_unpackhi_epi16(v, zero));
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        dst[i] = src[i];
+    }
+}
+
+void toFloat(const uint8_t* src, float* dst, size_t n, float divisor)
+{
+    size_t i = 0;
+#ifdef KAME_GLTF_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 d = _mm_set1_ps(divisor);
+    for (; i + 16 <= n; i += 16)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i lo = _mm_unpacklo_epi8(v, zero);
+        __m128i hi = _mm_unpackhi_epi8(v, zero);
+        _mm_storeu_ps(dst + i, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero)), d));
+        _mm_storeu_ps(dst + i + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero)), d));
+        _mm_storeu_ps(dst + i + 8, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero)), d));
+        _mm_storeu_ps(dst + i + 12, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero)), d));
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        dst[i] = float(src[i]) / divisor;
+    }
+}
+
+void toFloat(const uint16_t* src, float* dst, size_t n, float divisor)
+{
+    size_t i = 0;
+#ifdef KAME_GLTF_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 d = _mm_set1_ps(divisor);
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+        _mm_storeu_ps(dst + i, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(v, zero)), d));
+        _mm_storeu_ps(dst + i + 4, _mm_div_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(v, zero)), d));
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        dst[i] = float(src[i]) / divisor;
+    }
+}
+
+} // namespace detail
+
+} // namespace kame::gltf
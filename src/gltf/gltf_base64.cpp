@@ -0,0 +1,259 @@
+#include <all.hpp>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define KAME_BASE64_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define KAME_TARGET(x)
+#else
+#define KAME_TARGET(x) __attribute__((target(x)))
+#endif
+#endif
+
+namespace kame::gltf {
+
+namespace {
+
+constexpr uint8_t kInvalid = 0xff;
+
+struct DecodeTable {
+    uint8_t v[256];
+
+    constexpr DecodeTable()
+        : v{}
+    {
+        for (int i = 0; i < 256; ++i)
+        {
+            v[i] = kInvalid;
+        }
+        for (int i = 0; i < 26; ++i)
+        {
+            v['A' + i] = uint8_t(i);
+            v['a' + i] = uint8_t(i + 26);
+        }
+        for (int i = 0; i < 10; ++i)
+        {
+            v['0' + i] = uint8_t(i + 52);
+        }
+        v['+'] = 62;
+        v['/'] = 63;
+    }
+};
+
+constexpr DecodeTable kDecodeTable;
+
+// decodes n full quanta without padding, returns false on a character outside the alphabet
+bool decodeScalar(const uint8_t* src, size_t n, uint8_t* dst)
+{
+    for (size_t i = 0; i < n; ++i, src += 4, dst += 3)
+    {
+        uint32_t a = kDecodeTable.v[src[0]];
+        uint32_t b = kDecodeTable.v[src[1]];
+        uint32_t c = kDecodeTable.v[src[2]];
+        uint32_t d = kDecodeTable.v[src[3]];
+        if ((a | b | c | d) & 0x80)
+        {
+            return false;
+        }
+        uint32_t bytes = a << 18 | b << 12 | c << 6 | d;
+        dst[0] = uint8_t(bytes >> 16);
+        dst[1] = uint8_t(bytes >> 8);
+        dst[2] = uint8_t(bytes);
+    }
+    return true;
+}
+
+#ifdef KAME_BASE64_X86
+
+// SIMD decoding after Wojciech Mula and Daniel Lemire, "Faster Base64 Encoding and Decoding using AVX2 Instructions".
+// the kernels return the number of quanta consumed and leave invalid input to the scalar path for reporting.
+// each store writes 4(SSSE3) or 8(AVX2) bytes past the decoded ones, so callers leave that much room.
+
+KAME_TARGET("ssse3")
+size_t decodeSSSE3(const uint8_t* src, size_t n, uint8_t* dst)
+{
+    const __m128i lutLo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i lutHi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i lutRoll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i mask2F = _mm_set1_epi8(0x2F);
+    const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4, src += 16, dst += 12)
+    {
+        __m128i in = _mm_loadu_si128((const __m128i*)src);
+        __m128i hiNibbles = _mm_and_si128(_mm_srli_epi32(in, 4), mask2F);
+        __m128i loNibbles = _mm_and_si128(in, mask2F);
+        __m128i hi = _mm_shuffle_epi8(lutHi, hiNibbles);
+        __m128i lo = _mm_shuffle_epi8(lutLo, loNibbles);
+        if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128())) != 0)
+        {
+            break;
+        }
+
+        __m128i roll = _mm_shuffle_epi8(lutRoll, _mm_add_epi8(_mm_cmpeq_epi8(in, mask2F), hiNibbles));
+        in = _mm_add_epi8(in, roll);
+
+        // 4 x 6 bits -> 3 bytes per 32-bit lane
+        in = _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+        in = _mm_madd_epi16(in, _mm_set1_epi32(0x00011000));
+        _mm_storeu_si128((__m128i*)dst, _mm_shuffle_epi8(in, pack));
+    }
+    return i;
+}
+
+KAME_TARGET("avx2")
+size_t decodeAVX2(const uint8_t* src, size_t n, uint8_t* dst)
+{
+    const __m256i lutLo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A, 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m256i lutHi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m256i lutRoll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0, 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m256i mask2F = _mm256_set1_epi8(0x2F);
+    const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, -1, -1);
+
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8, src += 32, dst += 24)
+    {
+        __m256i in = _mm256_loadu_si256((const __m256i*)src);
+        __m256i hiNibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4), mask2F);
+        __m256i loNibbles = _mm256_and_si256(in, mask2F);
+        __m256i hi = _mm256_shuffle_epi8(lutHi, hiNibbles);
+        __m256i lo = _mm256_shuffle_epi8(lutLo, loNibbles);
+        if (!_mm256_testz_si256(lo, hi))
+        {
+            break;
+        }
+
+        __m256i roll = _mm256_shuffle_epi8(lutRoll, _mm256_add_epi8(_mm256_cmpeq_epi8(in, mask2F), hiNibbles));
+        in = _mm256_add_epi8(in, roll);
+
+        in = _mm256_maddubs_epi16(in, _mm256_set1_epi32(0x01400140));
+        in = _mm256_madd_epi16(in, _mm256_set1_epi32(0x00011000));
+        in = _mm256_shuffle_epi8(in, pack);
+        _mm256_storeu_si256((__m256i*)dst, _mm256_permutevar8x32_epi32(in, lanes));
+    }
+    return i;
+}
+
+struct CPUFeatures {
+    bool ssse3 = false;
+    bool avx2 = false;
+
+    CPUFeatures()
+    {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        int numIDs = info[0];
+        __cpuid(info, 1);
+        ssse3 = (info[2] & (1 << 9)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool ymm = osxsave && (_xgetbv(0) & 0x6) == 0x6;
+        if (numIDs >= 7)
+        {
+            __cpuidex(info, 7, 0);
+            avx2 = ymm && (info[1] & (1 << 5)) != 0;
+        }
+#else
+        __builtin_cpu_init();
+        ssse3 = __builtin_cpu_supports("ssse3");
+        avx2 = __builtin_cpu_supports("avx2");
+#endif
+    }
+};
+
+const CPUFeatures& getCPUFeatures()
+{
+    static CPUFeatures features;
+    return features;
+}
+
+#endif
+
+} // namespace
+
+bool decodeBase64(const char* str, size_t len, std::vector<uint8_t>& out)
+{
+    out.clear();
+    if (len == 0)
+    {
+        return true;
+    }
+    if (len % 4 != 0)
+    {
+        return false;
+    }
+
+    const uint8_t* src = (const uint8_t*)str;
+    size_t padding = 0;
+    if (src[len - 1] == '=')
+    {
+        padding = src[len - 2] == '=' ? 2 : 1;
+    }
+
+    // every quantum but the last one is 4 characters from the alphabet
+    const size_t numQuanta = len / 4 - 1;
+    out.resize(len / 4 * 3 - padding);
+    uint8_t* dst = out.data();
+
+    size_t done = 0;
+#ifdef KAME_BASE64_X86
+    // the last full quantum of output is spare room for the SIMD stores' overrun
+    const CPUFeatures& cpu = getCPUFeatures();
+    if (cpu.avx2 && numQuanta >= 3)
+    {
+        done = decodeAVX2(src, numQuanta - 3, dst);
+    }
+    if (cpu.ssse3 && numQuanta >= 2)
+    {
+        done += decodeSSSE3(src + done * 4, numQuanta - 2 - done, dst + done * 3);
+    }
+#endif
+
+    if (!decodeScalar(src + done * 4, numQuanta - done, dst + done * 3))
+    {
+        out.clear();
+        return false;
+    }
+
+    // the last quantum may carry padding
+    const uint8_t* last = src + numQuanta * 4;
+    uint32_t a = kDecodeTable.v[last[0]];
+    uint32_t b = kDecodeTable.v[last[1]];
+    uint32_t c = padding >= 2 ? 0 : kDecodeTable.v[last[2]];
+    uint32_t d = padding >= 1 ? 0 : kDecodeTable.v[last[3]];
+    if ((a | b | c | d) & 0x80)
+    {
+        out.clear();
+        return false;
+    }
+    uint32_t bytes = a << 18 | b << 12 | c << 6 | d;
+    dst += numQuanta * 3;
+    dst[0] = uint8_t(bytes >> 16);
+    if (padding < 2)
+    {
+        dst[1] = uint8_t(bytes >> 8);
+    }
+    if (padding < 1)
+    {
+        dst[2] = uint8_t(bytes);
+    }
+    return true;
+}
+
+std::vector<uint8_t> decodeBase64(const std::string& str, integer start)
+{
+    std::vector<uint8_t> data;
+    assert(start <= str.size());
+    bool ok = decodeBase64(str.data() + start, str.size() - start, data);
+    if (!ok)
+    {
+        SPDLOG_CRITICAL("invalid base64 data");
+    }
+    assert(ok);
+    return data;
+}
+
+} // namespace kame::gltf
@@ -0,0 +1,115 @@
+#include <all.hpp>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace kame::gltf {
+
+#ifdef _WIN32
+
+std::shared_ptr<MappedFile> mapFile(const char* path)
+{
+    assert(path);
+
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        SPDLOG_CRITICAL("[Gltf] failed to open: {}", path);
+        return nullptr;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        SPDLOG_CRITICAL("[Gltf] failed to map an empty file: {}", path);
+        return nullptr;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if (mapping == NULL)
+    {
+        SPDLOG_CRITICAL("[Gltf] CreateFileMapping failed: {}", path);
+        return nullptr;
+    }
+
+    void* addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (addr == NULL)
+    {
+        CloseHandle(mapping);
+        SPDLOG_CRITICAL("[Gltf] MapViewOfFile failed: {}", path);
+        return nullptr;
+    }
+
+    auto m = std::make_shared<MappedFile>();
+    m->data = (const uint8_t*)addr;
+    m->size = size_t(size.QuadPart);
+    m->handle = mapping;
+    return m;
+}
+
+MappedFile::~MappedFile()
+{
+    if (data)
+    {
+        UnmapViewOfFile(data);
+        CloseHandle((HANDLE)handle);
+    }
+}
+
+#else
+
+std::shared_ptr<MappedFile> mapFile(const char* path)
+{
+    assert(path);
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        SPDLOG_CRITICAL("[Gltf] failed to open: {}", path);
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        SPDLOG_CRITICAL("[Gltf] failed to map an empty file: {}", path);
+        return nullptr;
+    }
+
+    // MAP_SHARED on a read-only mapping lets processes share the page cache
+    void* addr = mmap(NULL, size_t(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+    {
+        SPDLOG_CRITICAL("[Gltf] mmap failed: {}", path);
+        return nullptr;
+    }
+
+    auto m = std::make_shared<MappedFile>();
+    m->data = (const uint8_t*)addr;
+    m->size = size_t(st.st_size);
+    return m;
+}
+
+MappedFile::~MappedFile()
+{
+    if (data)
+    {
+        munmap((void*)data, size);
+    }
+}
+
+#endif
+
+} // namespace kame::gltf
@@ -0,0 +1,271 @@
+#include <kame/math/math.hpp>
+
+#include <cassert>
+
+#if defined(KAME_MATH_SSE2) && !defined(KAME_MATH_AVX)
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define KAME_TARGET(x)
+#else
+#define KAME_TARGET(x) __attribute__((target(x)))
+#endif
+#define KAME_MATH_AVX_DISPATCH 1
+#endif
+
+namespace kame::math {
+
+namespace {
+
+#if defined(KAME_MATH_SSE2)
+
+// (x0 y0 z0 x1) (y1 z1 x2 y2) (z2 x3 y3 z3) to (x0 x1 x2 x3) (y0 y1 y2 y3) (z0 z1 z2 z3)
+inline void loadVector3x4(const Vector3* v, __m128& x, __m128& y, __m128& z)
+{
+    const float* p = &v->x;
+    const __m128 v0 = _mm_loadu_ps(p);
+    const __m128 v1 = _mm_loadu_ps(p + 4);
+    const __m128 v2 = _mm_loadu_ps(p + 8);
+    const __m128 x23 = _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(1, 1, 2, 2));
+    x = _mm_shuffle_ps(v0, x23, _MM_SHUFFLE(2, 0, 3, 0));
+    const __m128 y01 = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(0, 0, 1, 1));
+    const __m128 y23 = _mm_shuffle_ps(v1, v2, _MM_SHUFFLE(2, 2, 3, 3));
+    y = _mm_shuffle_ps(y01, y23, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m128 z01 = _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(1, 1, 2, 2));
+    const __m128 z23 = _mm_shuffle_ps(v2, v2, _MM_SHUFFLE(3, 3, 0, 0));
+    z = _mm_shuffle_ps(z01, z23, _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+// the inverse of loadVector3x4
+inline void storeVector3x4(__m128 x, __m128 y, __m128 z, Vector3* v)
+{
+    float* p = &v->x;
+    const __m128 xy01 = _mm_unpacklo_ps(x, y);
+    const __m128 xy23 = _mm_unpackhi_ps(x, y);
+    const __m128 z0x1 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0));
+    const __m128 y1z1 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1));
+    const __m128 z2x3 = _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2));
+    const __m128 y3z3 = _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3));
+    _mm_storeu_ps(p, _mm_shuffle_ps(xy01, z0x1, _MM_SHUFFLE(2, 0, 1, 0)));
+    _mm_storeu_ps(p + 4, _mm_shuffle_ps(y1z1, xy23, _MM_SHUFFLE(1, 0, 2, 0)));
+    _mm_storeu_ps(p + 8, _mm_shuffle_ps(z2x3, y3z3, _MM_SHUFFLE(2, 0, 2, 0)));
+}
+
+// a * b + c, kept as separate multiply and add so the results match the scalar operators
+inline __m128 madd(__m128 a, __m128 b, __m128 c)
+{
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+}
+
+size_t transformPointsSSE(const Vector3* points, size_t count, const Matrix& m, Vector3* out)
+{
+    const __m128 m11 = _mm_set1_ps(m.m11), m12 = _mm_set1_ps(m.m12), m13 = _mm_set1_ps(m.m13);
+    const __m128 m21 = _mm_set1_ps(m.m21), m22 = _mm_set1_ps(m.m22), m23 = _mm_set1_ps(m.m23);
+    const __m128 m31 = _mm_set1_ps(m.m31), m32 = _mm_set1_ps(m.m32), m33 = _mm_set1_ps(m.m33);
+    const __m128 m41 = _mm_set1_ps(m.m41), m42 = _mm_set1_ps(m.m42), m43 = _mm_set1_ps(m.m43);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 x, y, z;
+        loadVector3x4(points + i, x, y, z);
+        __m128 rx = _mm_add_ps(madd(z, m31, madd(y, m21, _mm_mul_ps(x, m11))), m41);
+        __m128 ry = _mm_add_ps(madd(z, m32, madd(y, m22, _mm_mul_ps(x, m12))), m42);
+        __m128 rz = _mm_add_ps(madd(z, m33, madd(y, m23, _mm_mul_ps(x, m13))), m43);
+        storeVector3x4(rx, ry, rz, out + i);
+    }
+    return i;
+}
+
+size_t composeTRSSSE(const Vector3* translations, const Quaternion* rotations, const Vector3* scales, size_t count, Matrix* out)
+{
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128 qx = _mm_loadu_ps(&rotations[i].x);
+        __m128 qy = _mm_loadu_ps(&rotations[i + 1].x);
+        __m128 qz = _mm_loadu_ps(&rotations[i + 2].x);
+        __m128 qw = _mm_loadu_ps(&rotations[i + 3].x);
+        _MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+        __m128 tx, ty, tz, sx, sy, sz;
+        loadVector3x4(translations + i, tx, ty, tz);
+        loadVector3x4(scales + i, sx, sy, sz);
+
+        // the rows of createFromQuaternion(), Vector3::transform(axis, q) with its operation order
+        const __m128 x2 = _mm_add_ps(qx, qx), y2 = _mm_add_ps(qy, qy), z2 = _mm_add_ps(qz, qz);
+        const __m128 e = _mm_sub_ps(_mm_mul_ps(qw, qw), madd(qz, qz, madd(qy, qy, _mm_mul_ps(qx, qx))));
+        __m128 r0 = _mm_mul_ps(sx, _mm_add_ps(_mm_mul_ps(x2, qx), e));
+        __m128 r1 = _mm_mul_ps(sx, _mm_add_ps(_mm_mul_ps(y2, qx), _mm_mul_ps(z2, qw)));
+        __m128 r2 = _mm_mul_ps(sx, _mm_sub_ps(_mm_mul_ps(z2, qx), _mm_mul_ps(y2, qw)));
+        __m128 r3 = zero;
+        __m128 u0 = _mm_mul_ps(sy, _mm_sub_ps(_mm_mul_ps(x2, qy), _mm_mul_ps(z2, qw)));
+        __m128 u1 = _mm_mul_ps(sy, _mm_add_ps(_mm_mul_ps(y2, qy), e));
+        __m128 u2 = _mm_mul_ps(sy, _mm_add_ps(_mm_mul_ps(z2, qy), _mm_mul_ps(x2, qw)));
+        __m128 u3 = zero;
+        __m128 f0 = _mm_mul_ps(sz, _mm_add_ps(_mm_mul_ps(x2, qz), _mm_mul_ps(y2, qw)));
+        __m128 f1 = _mm_mul_ps(sz, _mm_sub_ps(_mm_mul_ps(y2, qz), _mm_mul_ps(x2, qw)));
+        __m128 f2 = _mm_mul_ps(sz, _mm_add_ps(_mm_mul_ps(z2, qz), e));
+        __m128 f3 = zero;
+        __m128 t3 = one;
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _MM_TRANSPOSE4_PS(u0, u1, u2, u3);
+        _MM_TRANSPOSE4_PS(f0, f1, f2, f3);
+        _MM_TRANSPOSE4_PS(tx, ty, tz, t3);
+        const __m128 rows[4][4] = {{r0, u0, f0, tx}, {r1, u1, f1, ty}, {r2, u2, f2, tz}, {r3, u3, f3, t3}};
+        for (int k = 0; k < 4; ++k)
+        {
+            float* M = (float*)&out[i + k];
+            for (int row = 0; row < 4; ++row)
+            {
+                _mm_storeu_ps(M + 4 * row, rows[k][row]);
+            }
+        }
+    }
+    return i;
+}
+
+#endif
+
+#ifdef KAME_MATH_AVX_DISPATCH
+
+bool hasAVX()
+{
+    static const bool supported = [] {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 1);
+        return (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx");
+#endif
+    }();
+    return supported;
+}
+
+// simd::multiply4x4() built for AVX, two rows per 256 bit register
+KAME_TARGET("avx")
+void multiplyMatricesAVX(const Matrix* a, const Matrix* b, size_t strideB, size_t count, Matrix* out)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        const float* A = (const float*)&a[i];
+        const float* B = (const float*)&b[i * strideB];
+        const __m256 b0 = _mm256_broadcast_ps((const __m128*)(B + 0));
+        const __m256 b1 = _mm256_broadcast_ps((const __m128*)(B + 4));
+        const __m256 b2 = _mm256_broadcast_ps((const __m128*)(B + 8));
+        const __m256 b3 = _mm256_broadcast_ps((const __m128*)(B + 12));
+        const __m256 rows01 = _mm256_loadu_ps(A);
+        const __m256 rows23 = _mm256_loadu_ps(A + 8);
+        __m256 r01 = _mm256_mul_ps(_mm256_shuffle_ps(rows01, rows01, 0x00), b0);
+        __m256 r23 = _mm256_mul_ps(_mm256_shuffle_ps(rows23, rows23, 0x00), b0);
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(rows01, rows01, 0x55), b1));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(rows23, rows23, 0x55), b1));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(rows01, rows01, 0xaa), b2));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(rows23, rows23, 0xaa), b2));
+        r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(rows01, rows01, 0xff), b3));
+        r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(rows23, rows23, 0xff), b3));
+        float* M = (float*)&out[i];
+        _mm256_storeu_ps(M, r01);
+        _mm256_storeu_ps(M + 8, r23);
+    }
+}
+
+#endif
+
+#if defined(KAME_MATH_NEON)
+
+size_t transformPointsNEON(const Vector3* points, size_t count, const Matrix& m, Vector3* out)
+{
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        float32x4x3_t v = vld3q_f32(&points[i].x);
+        float32x4x3_t r;
+        r.val[0] = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(v.val[0], m.m11), vmulq_n_f32(v.val[1], m.m21)), vmulq_n_f32(v.val[2], m.m31)), vdupq_n_f32(m.m41));
+        r.val[1] = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(v.val[0], m.m12), vmulq_n_f32(v.val[1], m.m22)), vmulq_n_f32(v.val[2], m.m32)), vdupq_n_f32(m.m42));
+        r.val[2] = vaddq_f32(vaddq_f32(vaddq_f32(vmulq_n_f32(v.val[0], m.m13), vmulq_n_f32(v.val[1], m.m23)), vmulq_n_f32(v.val[2], m.m33)), vdupq_n_f32(m.m43));
+        vst3q_f32(&out[i].x, r);
+    }
+    return i;
+}
+
+#endif
+
+void multiplyMatrices(const Matrix* a, const Matrix* b, size_t strideB, size_t count, Matrix* out)
+{
+#ifdef KAME_MATH_AVX_DISPATCH
+    if (hasAVX())
+    {
+        multiplyMatricesAVX(a, b, strideB, count, out);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < count; ++i)
+    {
+        // a copy first so out may alias a or b
+        Matrix m;
+        simd::multiply4x4((const float*)&a[i], (const float*)&b[i * strideB], (float*)&m);
+        out[i] = m;
+    }
+}
+
+} // namespace
+
+void transformPoints(std::span<const Vector3> points, const Matrix& m, std::span<Vector3> out)
+{
+    assert(out.size() >= points.size());
+    size_t i = 0;
+#if defined(KAME_MATH_SSE2)
+    i = transformPointsSSE(points.data(), points.size(), m, out.data());
+#elif defined(KAME_MATH_NEON)
+    i = transformPointsNEON(points.data(), points.size(), m, out.data());
+#endif
+    for (; i < points.size(); ++i)
+    {
+        out[i] = Vector3::transform(points[i], m);
+    }
+}
+
+void transformPoints(std::span<const Vector3> points, std::span<const uint32_t> indices, const Matrix& m, std::span<Vector3> out)
+{
+    assert(out.size() >= points.size());
+    for (uint32_t index : indices)
+    {
+        assert(index < points.size());
+        float r[4];
+        simd::transformPoint(points[index].x, points[index].y, points[index].z, &m.m11, r);
+        out[index] = {r[0], r[1], r[2]};
+    }
+}
+
+void composeTRS(std::span<const Vector3> translations, std::span<const Quaternion> rotations, std::span<const Vector3> scales, std::span<Matrix> out)
+{
+    assert(translations.size() == rotations.size() && translations.size() == scales.size());
+    assert(out.size() >= translations.size());
+    size_t i = 0;
+#if defined(KAME_MATH_SSE2)
+    i = composeTRSSSE(translations.data(), rotations.data(), scales.data(), translations.size(), out.data());
+#endif
+    for (; i < translations.size(); ++i)
+    {
+        out[i] = Matrix::createScale(scales[i]) * Matrix::createFromQuaternion(rotations[i]) * Matrix::createTranslation(translations[i]);
+    }
+}
+
+void multiplyMatrices(std::span<const Matrix> a, std::span<const Matrix> b, std::span<Matrix> out)
+{
+    assert(a.size() == b.size() && out.size() >= a.size());
+    multiplyMatrices(a.data(), b.data(), 1, a.size(), out.data());
+}
+
+void multiplyMatrices(std::span<const Matrix> a, const Matrix& b, std::span<Matrix> out)
+{
+    assert(out.size() >= a.size());
+    // b may alias an element of out, a copy keeps it intact
+    const Matrix m = b;
+    multiplyMatrices(a.data(), &m, 0, a.size(), out.data());
+}
+
+} // namespace kame::math
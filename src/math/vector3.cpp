@@ -2,10 +2,9 @@
 
 kame::math::Vector3 kame::math::Vector3::transform(kame::math::Vector3 v, const kame::math::Matrix& m)
 {
-    float x = (v.x * m.m11) + (v.y * m.m21) + (v.z * m.m31) + m.m41;
-    float y = (v.x * m.m12) + (v.y * m.m22) + (v.z * m.m32) + m.m42;
-    float z = (v.x * m.m13) + (v.y * m.m23) + (v.z * m.m33) + m.m43;
-    return {x, y, z};
+    float r[4];
+    simd::transformPoint(v.x, v.y, v.z, &m.m11, r);
+    return {r[0], r[1], r[2]};
 }
 
 kame::math::Vector3 kame::math::Vector3::transform(kame::math::Vector3 v, kame::math::Quaternion q)
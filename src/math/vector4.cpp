@@ -2,11 +2,9 @@
 
 kame::math::Vector4 kame::math::Vector4::transform(kame::math::Vector4 v, const kame::math::Matrix& m)
 {
-    float x = (v.x * m.m11) + (v.y * m.m21) + (v.z * m.m31) + (v.w * m.m41);
-    float y = (v.x * m.m12) + (v.y * m.m22) + (v.z * m.m32) + (v.w * m.m42);
-    float z = (v.x * m.m13) + (v.y * m.m23) + (v.z * m.m33) + (v.w * m.m43);
-    float w = (v.x * m.m14) + (v.y * m.m24) + (v.z * m.m34) + (v.w * m.m44);
-    return {x, y, z, w};
+    float r[4];
+    simd::transform4(v.x, v.y, v.z, v.w, &m.m11, r);
+    return {r[0], r[1], r[2], r[3]};
 }
 
 kame::math::Vector4 kame::math::Vector4::lerp(kame::math::Vector4 a, kame::math::Vector4 b, float amount)
@@ -93,105 +93,443 @@ void setClearState(GLbitfield mask, kame::math::Vector4 color)
     glClearColor(color.x, color.y, color.z, color.w);
 }
 
-void setBlendState(BlendState state)
+namespace {
+
+// true when the GL call has to be made
+template <typename T>
+bool isStateChanged(Context::Cached<T>& cached, const std::type_identity_t<T>& value)
 {
-    if (state.useBlend)
+    auto& stats = Context::getInstance().stateStats;
+    if (cached.set(value))
     {
-        glEnable(GL_BLEND);
-        glBlendFuncSeparate(state.srcRGB, state.dstRGB, state.srcA, state.dstA);
-        glBlendEquationSeparate(state.blendEqRGB, state.blendEqA);
+        ++stats.issued;
+        return true;
     }
-    else
+    ++stats.skipped;
+    return false;
+}
+
+void setCapability(Context::Cached<bool>& cached, GLenum cap, bool enable)
+{
+    if (isStateChanged(cached, enable))
     {
-        glDisable(GL_BLEND);
+        if (enable)
+        {
+            glEnable(cap);
+        }
+        else
+        {
+            glDisable(cap);
+        }
     }
 }
 
-void setDepthStencilState(DepthStencilState state)
+// texture uploads bind to the active unit, whatever was cached there is gone
+void forgetActiveTexture()
 {
-    if (state.useDepth)
+    auto& state = Context::getInstance().state;
+    if (state.activeTexture.isValid)
     {
-        glEnable(GL_DEPTH_TEST);
-        glDepthFunc(state.depthFunc);
+        state.textures[state.activeTexture.value].isValid = false;
+        return;
     }
-    else
+    for (auto& t : state.textures)
     {
-        glDisable(GL_DEPTH_TEST);
+        t.isValid = false;
     }
 }
 
-void setRasterizerState(RasterizerState state)
+} // namespace
+
+void invalidateState()
 {
-    if (state.useCullFace)
+    Context::getInstance().state = {};
+}
+
+void setBlendState(BlendState state)
+{
+    auto& cache = Context::getInstance().state;
+    setCapability(cache.blend, GL_BLEND, state.useBlend);
+    if (state.useBlend)
     {
-        glEnable(GL_CULL_FACE);
-        glCullFace(state.cullMode);
+        if (isStateChanged(cache.blendFunction, {state.srcRGB, state.dstRGB, state.srcA, state.dstA}))
+        {
+            glBlendFuncSeparate(state.srcRGB, state.dstRGB, state.srcA, state.dstA);
+        }
+        if (isStateChanged(cache.blendEquation, {state.blendEqRGB, state.blendEqA}))
+        {
+            glBlendEquationSeparate(state.blendEqRGB, state.blendEqA);
+        }
     }
-    else
+}
+
+void setDepthStencilState(DepthStencilState state)
+{
+    auto& cache = Context::getInstance().state;
+    setCapability(cache.depthTest, GL_DEPTH_TEST, state.useDepth);
+    if (state.useDepth && isStateChanged(cache.depthFunc, state.depthFunc))
+    {
+        glDepthFunc(state.depthFunc);
+    }
+}
+
+void setRasterizerState(RasterizerState state)
+{
+    auto& cache = Context::getInstance().state;
+    setCapability(cache.cullFace, GL_CULL_FACE, state.useCullFace);
+    if (state.useCullFace && isStateChanged(cache.cullMode, state.cullMode))
     {
-        glDisable(GL_CULL_FACE);
+        glCullFace(state.cullMode);
     }
 }
 
 void setShader(kame::ogl::Shader* shader)
 {
-    glUseProgram(shader->id);
+    if (isStateChanged(Context::getInstance().state.program, GLuint(shader->id)))
+    {
+        glUseProgram(shader->id);
+    }
 }
 
 void setTexture2D(GLuint slot, Texture2D* tex)
 {
     assert(tex);
-    glActiveTexture(GL_TEXTURE0 + slot);
-    glBindTexture(GL_TEXTURE_2D, tex->id);
+    assert(slot < Context::State::kMAX_TEXTURE_UNITS);
+    auto& cache = Context::getInstance().state;
+    if (isStateChanged(cache.textures[slot], tex->id))
+    {
+        if (isStateChanged(cache.activeTexture, slot))
+        {
+            glActiveTexture(GL_TEXTURE0 + slot);
+        }
+        glBindTexture(GL_TEXTURE_2D, tex->id);
+    }
+}
+
+void setUniformBuffer(GLuint binding, UniformBuffer* ubo)
+{
+    assert(ubo);
+    glBindBufferBase(GL_UNIFORM_BUFFER, binding, ubo->id);
+}
+
+void setShaderStorageBuffer(GLuint binding, ShaderStorageBuffer* ssbo)
+{
+    assert(ssbo);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, ssbo->id);
 }
 
 void setRenderTarget(GBuffer* gbuffer)
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, gbuffer->fbo);
+    if (isStateChanged(Context::getInstance().state.framebuffer, gbuffer->fbo))
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, gbuffer->fbo);
+    }
 }
 
 void setRenderTargetDefault()
 {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (isStateChanged(Context::getInstance().state.framebuffer, 0u))
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
 }
 
-void drawArrays(const VertexArrayObject& vao, GLenum mode, GLint first, GLsizei count)
+namespace {
+
+struct BakedVertexArray {
+    std::vector<VertexArrayObject::Attribute> attributes;
+    GLuint ibo_id;
+    GLuint id;
+};
+// keyed by hashLayout()
+std::unordered_multimap<size_t, BakedVertexArray> gVertexArrays;
+
+size_t hashLayout(const VertexArrayObject& vao)
+{
+    size_t h = std::hash<GLuint>()(vao.ibo_id);
+    auto combine = [&h](uintptr_t v) {
+        h ^= std::hash<uintptr_t>()(v) + 0x9e3779b9 + (h << 6) + (h >> 2);
+    };
+    for (const auto& a : vao.attributes)
+    {
+        combine(a.vbo_id);
+        combine(a.location);
+        combine(a.componentSize);
+        combine(a.type);
+        combine(a.normalized);
+        combine(a.stride);
+        combine(a.isStreaming ? 0 : a.offset);
+        combine(a.divisor);
+        combine(a.isInteger);
+    }
+    return h;
+}
+
+// the stride GL assumes for a tightly packed attribute
+GLsizei getAttributeSize(const VertexArrayObject::Attribute& a)
+{
+    switch (a.type)
+    {
+        case GL_BYTE:
+        case GL_UNSIGNED_BYTE:
+            return a.componentSize;
+        case GL_SHORT:
+        case GL_UNSIGNED_SHORT:
+        case GL_HALF_FLOAT:
+            return a.componentSize * 2;
+        case GL_INT_2_10_10_10_REV:
+        case GL_UNSIGNED_INT_2_10_10_10_REV:
+            return 4;
+        case GL_DOUBLE:
+            return a.componentSize * 8;
+        default:
+            return a.componentSize * 4;
+    }
+}
+
+// glVertexAttribPointer() or glVertexAttribIPointer() for the buffer bound to GL_ARRAY_BUFFER
+void setAttribPointer(const VertexArrayObject::Attribute& a, uintptr_t offset)
+{
+    if (a.isInteger)
+    {
+        glVertexAttribIPointer(a.location, a.componentSize, a.type, a.stride, (const void*)offset);
+    }
+    else
+    {
+        glVertexAttribPointer(a.location, a.componentSize, a.type, a.normalized, a.stride, (const void*)offset);
+    }
+}
+
+void bakeVertexArray(const VertexArrayObject& vao, GLuint id)
+{
+    glBindVertexArray(id);
+    Context::getInstance().state.vertexArray.set(id);
+    if (Context::getInstance().capability.arb_vertex_attrib_binding)
+    {
+        // a binding per attribute with the offset on the binding, relative offsets stay 0 whatever the layout
+        assert(vao.attributes.size() <= 16);
+        for (GLuint b = 0; b < vao.attributes.size(); ++b)
+        {
+            const auto& a = vao.attributes[b];
+            glEnableVertexAttribArray(a.location);
+            if (a.isInteger)
+            {
+                glVertexAttribIFormat(a.location, a.componentSize, a.type, 0);
+            }
+            else
+            {
+                glVertexAttribFormat(a.location, a.componentSize, a.type, a.normalized, 0);
+            }
+            glVertexAttribBinding(a.location, b);
+            glBindVertexBuffer(b, a.vbo_id, GLintptr(a.offset), a.stride ? a.stride : getAttributeSize(a));
+            glVertexBindingDivisor(b, a.divisor);
+        }
+    }
+    else
+    {
+        for (const auto& a : vao.attributes)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, a.vbo_id);
+            glEnableVertexAttribArray(a.location);
+            setAttribPointer(a, a.offset);
+            if (a.divisor > 0)
+            {
+                glVertexAttribDivisor(a.location, a.divisor);
+            }
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vao.ibo_id);
+}
+
+GLuint acquireVertexArray(const VertexArrayObject& vao)
+{
+    size_t h = hashLayout(vao);
+    auto range = gVertexArrays.equal_range(h);
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second.ibo_id == vao.ibo_id && it->second.attributes == vao.attributes)
+        {
+            return it->second.id;
+        }
+    }
+
+    GLuint id = 0;
+    glGenVertexArrays(1, &id);
+    assert(id);
+    bakeVertexArray(vao, id);
+    gVertexArrays.emplace(h, BakedVertexArray{vao.attributes, vao.ibo_id, id});
+    return id;
+}
+
+// deleting the bound vertex array binds 0
+void forgetVertexArray(GLuint id)
+{
+    auto& cached = Context::getInstance().state.vertexArray;
+    if (cached.isValid && cached.value == id)
+    {
+        cached.value = 0;
+    }
+}
+
+// a new buffer may get the deleted one's name, the vertex arrays referencing it must go with it
+void evictVertexArrays(GLuint buffer)
+{
+    for (auto it = gVertexArrays.begin(); it != gVertexArrays.end();)
+    {
+        const auto& baked = it->second;
+        bool uses = baked.ibo_id == buffer;
+        for (const auto& a : baked.attributes)
+        {
+            uses |= a.vbo_id == buffer;
+        }
+        if (uses)
+        {
+            forgetVertexArray(baked.id);
+            glDeleteVertexArrays(1, &baked.id);
+            it = gVertexArrays.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+// without vertex array objects every draw specifies the attributes again
+void setAttributes(const VertexArrayObject& vao)
 {
     for (const auto& i : vao.attributes)
     {
         glBindBuffer(GL_ARRAY_BUFFER, i.vbo_id);
         glEnableVertexAttribArray(i.location);
-        glVertexAttribPointer(i.location, i.componentSize, i.type, i.normalized, i.stride, (const void*)i.offset);
+        setAttribPointer(i, i.offset);
+    }
+}
+
+// binds the baked vertex array and points its streaming attributes at this draw's offsets
+void bindVertexArray(const VertexArrayObject& vao)
+{
+    if (isStateChanged(Context::getInstance().state.vertexArray, vao.id))
+    {
+        glBindVertexArray(vao.id);
+    }
+    if (!vao.hasStreaming)
+    {
+        return;
+    }
+    const bool hasAttribBinding = Context::getInstance().capability.arb_vertex_attrib_binding;
+    for (GLuint b = 0; b < vao.attributes.size(); ++b)
+    {
+        const auto& a = vao.attributes[b];
+        if (!a.isStreaming)
+        {
+            continue;
+        }
+        if (hasAttribBinding)
+        {
+            glBindVertexBuffer(b, a.vbo_id, GLintptr(a.offset), a.stride ? a.stride : getAttributeSize(a));
+        }
+        else
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, a.vbo_id);
+            setAttribPointer(a, a.offset);
+        }
+    }
+}
+
+// what a base instance does to the attributes with a divisor, for the draws that cannot pass one
+void offsetInstancedAttributes(const VertexArrayObject& vao, GLuint baseInstance)
+{
+    const bool hasAttribBinding = vao.id && Context::getInstance().capability.arb_vertex_attrib_binding;
+    for (GLuint b = 0; b < vao.attributes.size(); ++b)
+    {
+        const auto& a = vao.attributes[b];
+        if (a.divisor == 0)
+        {
+            continue;
+        }
+        const GLsizei stride = a.stride ? a.stride : getAttributeSize(a);
+        const uintptr_t offset = a.offset + uintptr_t(baseInstance / a.divisor) * stride;
+        if (hasAttribBinding)
+        {
+            glBindVertexBuffer(b, a.vbo_id, GLintptr(offset), stride);
+        }
+        else
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, a.vbo_id);
+            setAttribPointer(a, offset);
+        }
+    }
+}
+
+} // namespace
+
+void releaseVertexArrays()
+{
+    for (auto& [h, baked] : gVertexArrays)
+    {
+        forgetVertexArray(baked.id);
+        glDeleteVertexArrays(1, &baked.id);
+    }
+    gVertexArrays.clear();
+}
+
+bool VertexArrayObject::Attribute::operator==(const Attribute& a) const
+{
+    // streaming offsets are not part of the baked layout
+    return vbo_id == a.vbo_id && location == a.location && componentSize == a.componentSize && type == a.type &&
+           normalized == a.normalized && stride == a.stride && (isStreaming || offset == a.offset) &&
+           divisor == a.divisor && isStreaming == a.isStreaming && isInteger == a.isInteger;
+}
+
+void drawArrays(const VertexArrayObject& vao, GLenum mode, GLint first, GLsizei count)
+{
+    if (vao.id)
+    {
+        bindVertexArray(vao);
+    }
+    else
+    {
+        setAttributes(vao);
     }
     glDrawArrays(mode, first, count);
 }
 
 void drawElements(const VertexArrayObject& vao, GLenum mode, GLsizei count, GLenum type)
 {
-    for (const auto& i : vao.attributes)
+    if (vao.id)
     {
-        glBindBuffer(GL_ARRAY_BUFFER, i.vbo_id);
-        glEnableVertexAttribArray(i.location);
-        glVertexAttribPointer(i.location, i.componentSize, i.type, i.normalized, i.stride, (const void*)i.offset);
+        bindVertexArray(vao);
     }
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vao.ibo_id);
-    glDrawElements(mode, count, type, NULL);
+    else
+    {
+        setAttributes(vao);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vao.ibo_id);
+    }
+    glDrawElements(mode, count, type, (const void*)vao.iboOffset);
 }
 
 void drawElementsInstanced(const VertexArrayObject& vao, GLenum mode, GLsizei count, GLenum type, GLsizei primCount)
 {
+    if (vao.id)
+    {
+        // the divisors are part of the vertex array
+        bindVertexArray(vao);
+        glDrawElementsInstanced(mode, count, type, (const void*)vao.iboOffset, primCount);
+        return;
+    }
+
+    setAttributes(vao);
     for (const auto& i : vao.attributes)
     {
-        glBindBuffer(GL_ARRAY_BUFFER, i.vbo_id);
-        glEnableVertexAttribArray(i.location);
-        glVertexAttribPointer(i.location, i.componentSize, i.type, i.normalized, i.stride, (const void*)i.offset);
         if (i.divisor > 0)
         {
             glVertexAttribDivisor(i.location, i.divisor);
         }
     }
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vao.ibo_id);
-    glDrawElementsInstanced(mode, count, type, NULL, primCount);
+    glDrawElementsInstanced(mode, count, type, (const void*)vao.iboOffset, primCount);
     // reset divisor
     for (const auto& i : vao.attributes)
     {
@@ -202,10 +540,96 @@ void drawElementsInstanced(const VertexArrayObject& vao, GLenum mode, GLsizei co
     }
 }
 
+void multiDrawElementsIndirect(const VertexArrayObject& vao, GLenum mode, GLenum type, const IndirectBuffer* indirect, GLsizei first, GLsizei drawCount)
+{
+    assert(indirect);
+    assert(first >= 0 && size_t(first) + size_t(drawCount) <= indirect->commands.size());
+    // firstIndex counts from the start of the index buffer
+    assert(vao.iboOffset == 0);
+    const auto& ctx = Context::getInstance();
+
+    bool hasInstanced = false;
+    for (const auto& a : vao.attributes)
+    {
+        hasInstanced |= a.divisor > 0;
+    }
+
+    if (vao.id)
+    {
+        bindVertexArray(vao);
+    }
+    else
+    {
+        setAttributes(vao);
+        for (const auto& a : vao.attributes)
+        {
+            if (a.divisor > 0)
+            {
+                glVertexAttribDivisor(a.location, a.divisor);
+            }
+        }
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, vao.ibo_id);
+    }
+
+    if (ctx.capability.arb_multi_draw_indirect)
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect->id);
+        glMultiDrawElementsIndirect(mode, type, (const void*)(uintptr_t(first) * sizeof(DrawElementsIndirectCommand)), drawCount, 0);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+    else
+    {
+        assert(ctx.capability.arb_draw_elements_base_vertex);
+        const uintptr_t indexSize = type == GL_UNSIGNED_BYTE ? 1 : (type == GL_UNSIGNED_SHORT ? 2 : 4);
+        for (GLsizei i = 0; i < drawCount; ++i)
+        {
+            const auto& c = indirect->commands[first + i];
+            if (c.count == 0 || c.instanceCount == 0)
+            {
+                continue;
+            }
+            const void* indices = (const void*)(uintptr_t(c.firstIndex) * indexSize);
+            if (hasInstanced)
+            {
+                offsetInstancedAttributes(vao, c.baseInstance);
+                glDrawElementsInstancedBaseVertex(mode, c.count, type, indices, c.instanceCount, c.baseVertex);
+            }
+            else if (c.instanceCount == 1)
+            {
+                glDrawElementsBaseVertex(mode, c.count, type, indices, c.baseVertex);
+            }
+            else
+            {
+                glDrawElementsInstancedBaseVertex(mode, c.count, type, indices, c.instanceCount, c.baseVertex);
+            }
+        }
+        // back to the offsets the vertex array was baked with
+        if (hasInstanced)
+        {
+            offsetInstancedAttributes(vao, 0);
+        }
+    }
+
+    if (!vao.id)
+    {
+        for (const auto& a : vao.attributes)
+        {
+            if (a.divisor > 0)
+            {
+                glVertexAttribDivisor(a.location, 0);
+            }
+        }
+    }
+}
+
 VertexArrayObject& VertexArrayObject::begin()
 {
     inSetAttributes = true;
     attributes.clear();
+    ibo_id = 0;
+    iboOffset = 0;
+    id = 0;
+    hasStreaming = false;
     return *this;
 }
 
@@ -223,22 +647,68 @@ VertexArrayObject& VertexArrayObject::bindAttribute(const VertexBuffer* vbo, GLu
     attr.stride = stride;
     attr.offset = offset;
     attr.divisor = divisor;
+    attr.isStreaming = false;
+    attr.isInteger = false;
 
     attributes.push_back(attr);
 
     return *this;
 }
 
+VertexArrayObject& VertexArrayObject::bindIntegerAttribute(const VertexBuffer* vbo, GLuint location, GLuint componentSize, GLenum type, GLsizei stride, uintptr_t offset, GLuint divisor)
+{
+    assert(type == GL_BYTE || type == GL_UNSIGNED_BYTE || type == GL_SHORT || type == GL_UNSIGNED_SHORT || type == GL_INT || type == GL_UNSIGNED_INT);
+    bindAttribute(vbo, location, componentSize, type, GL_FALSE, stride, offset, divisor);
+    attributes.back().isInteger = true;
+    return *this;
+}
+
+VertexArrayObject& VertexArrayObject::bindAttribute(const StreamingBuffer* buffer, GLuint location, GLuint componentSize, GLenum type, GLboolean normalized, GLsizei stride, StreamingBuffer::Allocation allocation, GLuint divisor)
+{
+    assert(inSetAttributes);
+    assert(componentSize >= 1 && componentSize <= 4);
+
+    VertexArrayObject::Attribute attr;
+    attr.vbo_id = buffer->id;
+    attr.location = location;
+    attr.componentSize = componentSize;
+    attr.type = type;
+    attr.normalized = normalized;
+    attr.stride = stride;
+    attr.offset = uintptr_t(allocation.offset);
+    attr.divisor = divisor;
+    attr.isStreaming = true;
+    attr.isInteger = false;
+
+    attributes.push_back(attr);
+    hasStreaming = true;
+
+    return *this;
+}
+
 VertexArrayObject& VertexArrayObject::bindIndexBuffer(const IndexBuffer* ibo)
 {
     assert(inSetAttributes);
     ibo_id = ibo->id;
+    iboOffset = 0;
+    return *this;
+}
+
+VertexArrayObject& VertexArrayObject::bindIndexBuffer(const StreamingBuffer* buffer, StreamingBuffer::Allocation allocation)
+{
+    assert(inSetAttributes);
+    ibo_id = buffer->id;
+    iboOffset = allocation.offset;
     return *this;
 }
 
 void VertexArrayObject::end()
 {
     inSetAttributes = false;
+    if (Context::getInstance().capability.arb_vertex_array_object)
+    {
+        id = acquireVertexArray(*this);
+    }
 }
 
 void VertexArrayObject::drawArrays(GLenum mode, GLint first, GLsizei count)
@@ -259,6 +729,12 @@ void VertexArrayObject::drawElementsInstanced(GLenum mode, GLsizei count, GLenum
     kame::ogl::drawElementsInstanced(*this, mode, count, type, primCount);
 }
 
+void VertexArrayObject::multiDrawElementsIndirect(GLenum mode, GLenum type, const IndirectBuffer* indirect, GLsizei first, GLsizei drawCount)
+{
+    assert(!inSetAttributes);
+    kame::ogl::multiDrawElementsIndirect(*this, mode, type, indirect, first, drawCount);
+}
+
 Shader* createShader(const char* vert, const char* frag)
 {
     Shader* s = new Shader();
@@ -331,6 +807,12 @@ Shader* createShader(const char* vert, const char* frag)
 
 void deleteShader(Shader* shader)
 {
+    // a later program may get the same name
+    auto& cached = Context::getInstance().state.program;
+    if (cached.value == GLuint(shader->id))
+    {
+        cached.isValid = false;
+    }
     glDeleteProgram(shader->id);
     delete shader;
 }
@@ -380,6 +862,17 @@ void Shader::setInt(const char* name, int x)
     glUniform1iv(getUniformLocation(name), 1, (const GLint*)&x);
 }
 
+void Shader::setUniformBlockBinding(const char* name, GLuint binding)
+{
+    GLuint index = glGetUniformBlockIndex(id, name);
+    if (index == GL_INVALID_INDEX)
+    {
+        SPDLOG_WARN("uniform block {} is not active", name);
+        return;
+    }
+    glUniformBlockBinding(id, index, binding);
+}
+
 VertexBuffer* createVertexBuffer(GLsizeiptr numBytes, GLenum usage)
 {
     VertexBuffer* vbo = new VertexBuffer();
@@ -400,6 +893,7 @@ VertexBuffer* createVertexBuffer(GLsizeiptr numBytes, GLenum usage)
 
 void deleteVertexBuffer(VertexBuffer* vbo)
 {
+    evictVertexArrays(vbo->id);
     glDeleteBuffers(1, &vbo->id);
     delete vbo;
 }
@@ -455,11 +949,12 @@ IndexBuffer* createIndexBuffer(GLsizeiptr numBytes, GLenum usage)
     IndexBuffer* ibo = new IndexBuffer();
     assert(ibo);
 
+    // uploads go through GL_ARRAY_BUFFER, the element binding belongs to the bound vertex array
     GLuint buffer;
     glGenBuffers(1, &buffer);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, numBytes, NULL, usage);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, numBytes, NULL, usage);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 
     ibo->id = buffer;
     ibo->numBytes = numBytes;
@@ -468,29 +963,30 @@ IndexBuffer* createIndexBuffer(GLsizeiptr numBytes, GLenum usage)
 }
 void deleteIndexBuffer(IndexBuffer* ibo)
 {
+    evictVertexArrays(ibo->id);
     glDeleteBuffers(1, &ibo->id);
     delete ibo;
 }
 
 void IndexBuffer::setBuffer(const unsigned char* vertices)
 {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, id);
-    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, numBytes, vertices);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, id);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, numBytes, vertices);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void IndexBuffer::setBuffer(const unsigned short* vertices)
 {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, id);
-    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, numBytes, vertices);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, id);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, numBytes, vertices);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void IndexBuffer::setBuffer(const unsigned int* vertices)
 {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, id);
-    glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, numBytes, vertices);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+    glBindBuffer(GL_ARRAY_BUFFER, id);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, numBytes, vertices);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
 void IndexBuffer::setBuffer(const std::vector<unsigned int>& vertices)
@@ -498,6 +994,128 @@ void IndexBuffer::setBuffer(const std::vector<unsigned int>& vertices)
     setBuffer((const unsigned int*)vertices.data());
 }
 
+StreamingBuffer* createStreamingBuffer(GLsizeiptr numBytesPerFrame, int numFrames)
+{
+    assert(numBytesPerFrame > 0);
+    assert(numFrames >= 1 && numFrames <= StreamingBuffer::kMAX_FRAMES);
+    StreamingBuffer* sb = new StreamingBuffer();
+    assert(sb);
+
+    const auto& ctx = Context::getInstance();
+    const GLsizeiptr total = numBytesPerFrame * numFrames;
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    assert(buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    if (ctx.capability.arb_buffer_storage)
+    {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, total, NULL, flags);
+        sb->mapped = (unsigned char*)glMapBufferRange(GL_ARRAY_BUFFER, 0, total, flags);
+        assert(sb->mapped);
+        sb->isPersistent = true;
+    }
+    else
+    {
+        glBufferData(GL_ARRAY_BUFFER, total, NULL, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    sb->id = buffer;
+    sb->numBytes = numBytesPerFrame;
+    sb->numFrames = numFrames;
+    return sb;
+}
+
+void deleteStreamingBuffer(StreamingBuffer* sb)
+{
+    for (auto& fence : sb->fences)
+    {
+        if (fence)
+        {
+            glDeleteSync(fence);
+        }
+    }
+    if (sb->isPersistent)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, sb->id);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    evictVertexArrays(sb->id);
+    glDeleteBuffers(1, &sb->id);
+    delete sb;
+}
+
+StreamingBuffer::Allocation StreamingBuffer::upload(const void* data, GLsizeiptr size, GLsizeiptr alignment)
+{
+    assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+    GLsizeiptr begin = (head + alignment - 1) & ~(alignment - 1);
+    if (begin + size > numBytes)
+    {
+        SPDLOG_CRITICAL("StreamingBuffer overflow: {} bytes requested, {} of {} used this frame", size, head, numBytes);
+        return {};
+    }
+
+    const GLintptr offset = GLintptr(frame) * numBytes + begin;
+    head = begin + size;
+    if (size == 0)
+    {
+        return {offset, 0};
+    }
+
+    if (isPersistent)
+    {
+        std::memcpy(mapped + offset, data, size);
+    }
+    else
+    {
+        // the region is unused by the GPU, nextFrame() made sure of that
+        glBindBuffer(GL_ARRAY_BUFFER, id);
+        void* dst = glMapBufferRange(GL_ARRAY_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+        assert(dst);
+        std::memcpy(dst, data, size);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+    return {offset, size};
+}
+
+void StreamingBuffer::nextFrame()
+{
+    if (Context::getInstance().capability.arb_sync)
+    {
+        assert(!fences[frame]);
+        fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+    frame = (frame + 1) % numFrames;
+    head = 0;
+
+    if (fences[frame])
+    {
+        // numFrames - 1 frames old, normally signaled already
+        GLenum result = glClientWaitSync(fences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+        while (result == GL_TIMEOUT_EXPIRED)
+        {
+            result = glClientWaitSync(fences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        }
+        if (result == GL_WAIT_FAILED)
+        {
+            SPDLOG_WARN("glClientWaitSync failed on StreamingBuffer {}", id);
+        }
+        glDeleteSync(fences[frame]);
+        fences[frame] = nullptr;
+    }
+    else if (frame == 0 && !isPersistent)
+    {
+        // no sync objects, orphaning gives fresh storage while the GPU may still read the old ring
+        glBindBuffer(GL_ARRAY_BUFFER, id);
+        glBufferData(GL_ARRAY_BUFFER, numBytes * numFrames, NULL, GL_STREAM_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+    }
+}
+
 UniformBuffer* createUniformBuffer(GLsizeiptr numBytes, GLenum usage)
 {
     UniformBuffer* ubo = new UniformBuffer();
@@ -528,6 +1146,81 @@ void UniformBuffer::setBuffer(const float* vertices)
     glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
+void UniformBuffer::setBufferSubData(GLintptr offset, GLsizeiptr size, const void* data)
+{
+    assert(offset + size <= numBytes);
+    glBindBuffer(GL_UNIFORM_BUFFER, id);
+    glBufferSubData(GL_UNIFORM_BUFFER, offset, size, data);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+ShaderStorageBuffer* createShaderStorageBuffer(GLsizeiptr numBytes, GLenum usage)
+{
+    ShaderStorageBuffer* ssbo = new ShaderStorageBuffer();
+    assert(ssbo);
+
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, numBytes, NULL, usage);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    ssbo->id = buffer;
+    ssbo->numBytes = numBytes;
+    ssbo->usage = usage;
+    return ssbo;
+}
+
+void deleteShaderStorageBuffer(ShaderStorageBuffer* ssbo)
+{
+    glDeleteBuffers(1, &ssbo->id);
+    delete ssbo;
+}
+
+IndirectBuffer* createIndirectBuffer(GLenum usage)
+{
+    IndirectBuffer* indirect = new IndirectBuffer();
+    assert(indirect);
+
+    GLuint buffer = 0;
+    if (Context::getInstance().capability.arb_multi_draw_indirect)
+    {
+        glGenBuffers(1, &buffer);
+        assert(buffer);
+    }
+
+    indirect->id = buffer;
+    indirect->usage = usage;
+    return indirect;
+}
+
+void deleteIndirectBuffer(IndirectBuffer* indirect)
+{
+    if (indirect->id)
+    {
+        glDeleteBuffers(1, &indirect->id);
+    }
+    delete indirect;
+}
+
+void IndirectBuffer::setBuffer(const std::vector<DrawElementsIndirectCommand>& src)
+{
+    commands = src;
+    if (id)
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, id);
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), usage);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    }
+}
+
+void ShaderStorageBuffer::setBuffer(const void* data)
+{
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, id);
+    glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, numBytes, data);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+}
+
 Texture2D* loadTexture2D(const char* path, bool flipY)
 {
     assert(path);
@@ -561,6 +1254,7 @@ Texture2D* loadTexture2DFromMemory(const unsigned char* src, int len, bool flipY
     GLuint tex = 0;
     glGenTextures(1, &tex);
     assert(tex);
+    forgetActiveTexture();
     glBindTexture(GL_TEXTURE_2D, tex);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -593,6 +1287,7 @@ Texture2D* createTexture2D(GLint internalFormat, int width, int height, GLenum f
     GLuint tex = 0;
     glGenTextures(1, &tex);
     assert(tex);
+    forgetActiveTexture();
     glBindTexture(GL_TEXTURE_2D, tex);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -622,12 +1317,21 @@ Texture2D* createTexture2D(GLint internalFormat, int width, int height, GLenum f
 
 void deleteTexture2D(Texture2D* tex)
 {
+    // GL unbinds a deleted texture from every unit
+    for (auto& t : Context::getInstance().state.textures)
+    {
+        if (t.isValid && t.value == tex->id)
+        {
+            t.value = 0;
+        }
+    }
     glDeleteTextures(1, &tex->id);
     delete tex;
 }
 
 void Texture2D::setTexParameteri(GLenum pname, GLint param)
 {
+    forgetActiveTexture();
     glBindTexture(GL_TEXTURE_2D, id);
     glTexParameteri(GL_TEXTURE_2D, pname, param);
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -635,6 +1339,7 @@ void Texture2D::setTexParameteri(GLenum pname, GLint param)
 
 void Texture2D::setTexParameterfv(GLenum pname, const GLfloat* param)
 {
+    forgetActiveTexture();
     glBindTexture(GL_TEXTURE_2D, id);
     glTexParameterfv(GL_TEXTURE_2D, pname, param);
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -642,6 +1347,7 @@ void Texture2D::setTexParameterfv(GLenum pname, const GLfloat* param)
 
 void Texture2D::generateMipmap()
 {
+    forgetActiveTexture();
     glBindTexture(GL_TEXTURE_2D, id);
     glGenerateMipmap(GL_TEXTURE_2D);
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -692,8 +1398,10 @@ GBuffer* createGBuffer(int width, int height)
     assert(status == GL_FRAMEBUFFER_COMPLETE);
 
     glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    Context::getInstance().state.framebuffer.set(0);
 
     glBindTexture(GL_TEXTURE_2D, 0);
+    forgetActiveTexture();
 
     return gb;
 }
@@ -702,11 +1410,23 @@ void deleteGBuffer(GBuffer* gb)
 {
     assert(gb);
 
+    auto& state = Context::getInstance().state;
     for (auto& tex : gb->textures)
     {
+        for (auto& t : state.textures)
+        {
+            if (t.isValid && t.value == tex.id)
+            {
+                t.value = 0;
+            }
+        }
         glDeleteTextures(1, &tex.id);
     }
 
+    if (state.framebuffer.isValid && state.framebuffer.value == gb->fbo)
+    {
+        state.framebuffer.value = 0;
+    }
     glDeleteFramebuffers(1, &gb->fbo);
 
     delete gb;
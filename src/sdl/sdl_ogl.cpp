@@ -124,12 +124,47 @@ void WindowOGL::openWindow(const char* title, int w, int h)
         GLuint VAO;
         glGenVertexArrays(1, &VAO);
         glBindVertexArray(VAO);
+        kame::ogl::Context::getInstance().capability.arb_vertex_array_object = true;
     }
     else
     {
         glEnable(GL_TEXTURE_2D);
     }
 
+    if (GLAD_GL_VERSION_4_3 || GLAD_GL_ARB_vertex_attrib_binding)
+    {
+        SPDLOG_INFO("GL_ARB_vertex_attrib_binding is avaliable");
+        kame::ogl::Context::getInstance().capability.arb_vertex_attrib_binding = true;
+    }
+
+    if (GLAD_GL_VERSION_4_4 || GLAD_GL_ARB_buffer_storage)
+    {
+        SPDLOG_INFO("GL_ARB_buffer_storage is avaliable");
+        kame::ogl::Context::getInstance().capability.arb_buffer_storage = true;
+    }
+    if (GLAD_GL_VERSION_3_2 || GLAD_GL_ARB_sync)
+    {
+        SPDLOG_INFO("GL_ARB_sync is avaliable");
+        kame::ogl::Context::getInstance().capability.arb_sync = true;
+    }
+
+    if (GLAD_GL_VERSION_3_2 || GLAD_GL_ARB_draw_elements_base_vertex)
+    {
+        SPDLOG_INFO("GL_ARB_draw_elements_base_vertex is avaliable");
+        kame::ogl::Context::getInstance().capability.arb_draw_elements_base_vertex = true;
+    }
+    // baseInstance of the commands needs ARB_base_instance
+    if (GLAD_GL_VERSION_4_3 || (GLAD_GL_ARB_multi_draw_indirect && GLAD_GL_ARB_base_instance))
+    {
+        SPDLOG_INFO("GL_ARB_multi_draw_indirect is avaliable");
+        kame::ogl::Context::getInstance().capability.arb_multi_draw_indirect = true;
+    }
+    if (GLAD_GL_VERSION_4_3 || GLAD_GL_ARB_shader_storage_buffer_object)
+    {
+        SPDLOG_INFO("GL_ARB_shader_storage_buffer_object is avaliable");
+        kame::ogl::Context::getInstance().capability.arb_shader_storage_buffer_object = true;
+    }
+
     if (GLAD_GL_EXT_framebuffer_object || GLAD_GL_ARB_framebuffer_object)
     {
         SPDLOG_INFO("GL_EXT_framebuffer_object is avaliable");
@@ -163,6 +198,8 @@ void WindowOGL::openWindow(const char* title, int w, int h)
 
 void WindowOGL::closeWindow()
 {
+    kame::ogl::releaseVertexArrays();
+    kame::ogl::invalidateState();
     kame::ogl::Context::getInstance().isAvaliable = false;
     SDL_GL_DeleteContext(glc);
     SDL_DestroyWindow(window);
@@ -2,6 +2,292 @@
 
 namespace kame::squirtle {
 
+void AnimationClip::Sampler::analyzeInputs()
+{
+    keyInterval = 0.0f;
+    if (inputs.size() < 3)
+    {
+        return;
+    }
+
+    float interval = (inputs.back() - inputs.front()) / float(inputs.size() - 1);
+    if (interval <= 0.0f)
+    {
+        return;
+    }
+    for (size_t i = 1; i < inputs.size(); ++i)
+    {
+        if (std::abs(inputs[i] - (inputs.front() + interval * float(i))) > interval * 1e-3f)
+        {
+            return;
+        }
+    }
+    keyInterval = interval;
+}
+
+bool AnimationClip::Sampler::isPlayable() const
+{
+    // cubic splines store an in-tangent, value and out-tangent per key
+    size_t outputsPerKey = interpolation == kCUBICSPLINE ? 3 : 1;
+    return !inputs.empty() && inputs.size() * outputsPerKey <= outputsVec4.size();
+}
+
+uint32_t findKey(std::span<const float> inputs, float keyInterval, float time, uint32_t& cursor)
+{
+    if (inputs.size() < 2)
+    {
+        return 0;
+    }
+    const uint32_t last = uint32_t(inputs.size() - 2);
+
+    uint32_t i = std::min(cursor, last);
+    if (keyInterval > 0.0f)
+    {
+        // clamped as a float, converting NaN or a k beyond uint32_t is undefined
+        float k = (time - inputs.front()) / keyInterval;
+        if (!(k > 0.0f))
+        {
+            i = 0;
+        }
+        else
+        {
+            i = k >= float(last) ? last : uint32_t(k);
+        }
+    }
+    else if (!(time >= inputs[i] && time < inputs[i + 1]))
+    {
+        // playing forward usually lands in the next pair, anything else is a seek
+        if (i < last && time >= inputs[i + 1] && time < inputs[i + 2])
+        {
+            ++i;
+        }
+        else
+        {
+            auto it = std::upper_bound(inputs.begin(), inputs.end(), time);
+            i = uint32_t(std::clamp<ptrdiff_t>(it - inputs.begin() - 1, 0, last));
+        }
+    }
+
+    // evenly spaced keys are only equal up to rounding, settle on the exact pair
+    while (i > 0 && time < inputs[i])
+    {
+        --i;
+    }
+    while (i < last && time >= inputs[i + 1])
+    {
+        ++i;
+    }
+    cursor = i;
+    return i;
+}
+
+uint32_t AnimationClip::Sampler::findKey(float time, uint32_t& cursor) const
+{
+    return kame::squirtle::findKey(inputs, keyInterval, time, cursor);
+}
+
+void AnimationClip::compile()
+{
+    for (auto& t : tracks)
+    {
+        t.clear();
+    }
+    for (auto& c : channels)
+    {
+        if (c.targetID < 0 || c.samplerID >= samplers.size())
+        {
+            continue;
+        }
+        auto& s = samplers[c.samplerID];
+        if (!s.isPlayable())
+        {
+            continue;
+        }
+        tracks[s.interpolation * 3 + c.path].push_back({uint32_t(c.targetID), c.samplerID});
+    }
+    compiled = true;
+}
+
+namespace {
+
+using Interpolation = AnimationClip::Sampler::InterpolationType;
+using Path = AnimationClip::Channel::PathType;
+
+// value between keys i and i + 1, rotations come out normalized
+template <Interpolation I, bool Rotation>
+kame::math::Vector4 sampleKeys(const AnimationClip::Sampler& s, uint32_t i, float time)
+{
+    using kame::math::Quaternion;
+    using kame::math::Vector4;
+
+    const uint32_t next = std::min(i + 1, uint32_t(s.inputs.size() - 1));
+    const Vector4* out = s.outputsVec4.data();
+    if constexpr (I == Interpolation::kSTEP)
+    {
+        // findKey() stops at the last pair, past its end the last key holds
+        return out[time >= s.inputs[next] ? next : i];
+    }
+    else if constexpr (I == Interpolation::kLINEAR)
+    {
+        float u = next != i ? std::clamp((time - s.inputs[i]) / (s.inputs[next] - s.inputs[i]), 0.0f, 1.0f) : 0.0f;
+        if constexpr (Rotation)
+        {
+            Quaternion q = Quaternion::normalize(Quaternion::slerp(out[i], out[next], u));
+            return Vector4(q.x, q.y, q.z, q.w);
+        }
+        else
+        {
+            return Vector4::lerp(out[i], out[next], u);
+        }
+    }
+    else
+    {
+        // hermite spline over (in-tangent, value, out-tangent) triplets, tangents are per second
+        float dt = s.inputs[next] - s.inputs[i];
+        float u = next != i ? std::clamp((time - s.inputs[i]) / dt, 0.0f, 1.0f) : 0.0f;
+        float u2 = u * u;
+        float u3 = u2 * u;
+        float h00 = 2.0f * u3 - 3.0f * u2 + 1.0f;
+        float h10 = (u3 - 2.0f * u2 + u) * dt;
+        float h01 = -2.0f * u3 + 3.0f * u2;
+        float h11 = (u3 - u2) * dt;
+        Vector4 v = out[i * 3 + 1] * h00 + out[i * 3 + 2] * h10 + out[next * 3 + 1] * h01 + out[next * 3] * h11;
+        if constexpr (Rotation)
+        {
+            return Vector4::normalize(v);
+        }
+        else
+        {
+            return v;
+        }
+    }
+}
+
+template <Path P>
+void writeTrack(Node* nodes, uint32_t id, kame::math::Vector4 v)
+{
+    if constexpr (P == Path::kTRANSLATION)
+    {
+        nodes[id].position = kame::math::Vector3(v.x, v.y, v.z);
+    }
+    else if constexpr (P == Path::kROTATION)
+    {
+        nodes[id].rotation = kame::math::Quaternion(v);
+    }
+    else
+    {
+        nodes[id].scale = kame::math::Vector3(v.x, v.y, v.z);
+    }
+}
+
+template <Path P>
+void writeTrack(Pose* pose, uint32_t id, kame::math::Vector4 v)
+{
+    if constexpr (P == Path::kTRANSLATION)
+    {
+        pose->positions[id] = kame::math::Vector3(v.x, v.y, v.z);
+    }
+    else if constexpr (P == Path::kROTATION)
+    {
+        pose->rotations[id] = kame::math::Quaternion(v);
+    }
+    else
+    {
+        pose->scales[id] = kame::math::Vector3(v.x, v.y, v.z);
+    }
+}
+
+// Target is Node* or Pose*
+template <Interpolation I, Path P, typename Target>
+void evaluateTracks(std::vector<AnimationClip::Track>& tracks, const std::vector<AnimationClip::Sampler>& samplers, Target target, float time)
+{
+    for (auto& t : tracks)
+    {
+        const auto& s = samplers[t.samplerID];
+        writeTrack<P>(target, t.targetID, sampleKeys<I, P == Path::kROTATION>(s, s.findKey(time, t.cursor), time));
+    }
+}
+
+template <typename Target>
+using TrackKernel = void (*)(std::vector<AnimationClip::Track>&, const std::vector<AnimationClip::Sampler>&, Target, float);
+
+// indexed by interpolation * 3 + path
+template <typename Target>
+constexpr TrackKernel<Target> kTrackKernels[AnimationClip::kNUM_KERNELS] = {
+    evaluateTracks<Interpolation::kLINEAR, Path::kTRANSLATION, Target>,
+    evaluateTracks<Interpolation::kLINEAR, Path::kROTATION, Target>,
+    evaluateTracks<Interpolation::kLINEAR, Path::kSCALE, Target>,
+    evaluateTracks<Interpolation::kSTEP, Path::kTRANSLATION, Target>,
+    evaluateTracks<Interpolation::kSTEP, Path::kROTATION, Target>,
+    evaluateTracks<Interpolation::kSTEP, Path::kSCALE, Target>,
+    evaluateTracks<Interpolation::kCUBICSPLINE, Path::kTRANSLATION, Target>,
+    evaluateTracks<Interpolation::kCUBICSPLINE, Path::kROTATION, Target>,
+    evaluateTracks<Interpolation::kCUBICSPLINE, Path::kSCALE, Target>,
+};
+
+template <typename Target>
+void evaluateClip(AnimationClip& clip, Target target, float time)
+{
+    if (!clip.compiled)
+    {
+        clip.compile();
+    }
+    for (int k = 0; k < AnimationClip::kNUM_KERNELS; ++k)
+    {
+        if (!clip.tracks[k].empty())
+        {
+            kTrackKernels<Target>[k](clip.tracks[k], clip.samplers, target, time);
+        }
+    }
+}
+
+} // namespace
+
+kame::math::Vector4 AnimationClip::Sampler::sample(float time, bool rotation, uint32_t& cursor) const
+{
+    uint32_t i = findKey(time, cursor);
+    switch (interpolation)
+    {
+        case kSTEP:
+            return rotation ? sampleKeys<kSTEP, true>(*this, i, time) : sampleKeys<kSTEP, false>(*this, i, time);
+        case kCUBICSPLINE:
+            return rotation ? sampleKeys<kCUBICSPLINE, true>(*this, i, time) : sampleKeys<kCUBICSPLINE, false>(*this, i, time);
+        default:
+            return rotation ? sampleKeys<kLINEAR, true>(*this, i, time) : sampleKeys<kLINEAR, false>(*this, i, time);
+    }
+}
+
+float animate(AnimationClip& clip, std::vector<Node>& nodes, float playTime)
+{
+    if (playTime > clip.endTime)
+    {
+        playTime = clip.startTime + (clip.endTime - playTime);
+    }
+
+    float time = playTime;
+    evaluateClip(clip, nodes.data(), time);
+
+    return time;
+}
+
+float animate(AnimationClip& clip, Model& model, float playTime)
+{
+    float time = animate(clip, model.nodes, playTime);
+    for (auto& tracks : clip.tracks)
+    {
+        for (auto& t : tracks)
+        {
+            model.markDirty(int(t.targetID));
+        }
+    }
+    return time;
+}
+
+void samplePose(AnimationClip& clip, float time, Pose& pose)
+{
+    evaluateClip(clip, &pose, time);
+}
+
 std::unordered_map<std::string, AnimationClip> importAnimation(const kame::gltf::Gltf* gltf)
 {
     std::unordered_map<std::string, AnimationClip> clips;
@@ -54,45 +340,41 @@ std::unordered_map<std::string, AnimationClip> importAnimation(const kame::gltf:
             }
 
             {
-                auto& acc = gltf->accessors[s.input];
-                auto& bv = gltf->bufferViews[acc.bufferView];
-                auto& b = gltf->buffers[bv.buffer];
-                smp.inputs.reserve(acc.count);
-                assert(acc.componentType == GL_FLOAT);
-                for (unsigned int i = 0; i < acc.count; ++i)
+                kame::gltf::AccessorView<float> view(gltf, s.input);
+                assert(view.componentType == GL_FLOAT);
+                smp.inputs = view.toVector();
+                for (float v : smp.inputs)
                 {
-                    auto v = ((float*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                    smp.inputs.emplace_back(v);
                     clip.startTime = std::min(clip.startTime, v);
                     clip.endTime = std::max(clip.endTime, v);
                 }
+                smp.analyzeInputs();
             }
             {
                 auto& acc = gltf->accessors[s.output];
-                auto& bv = gltf->bufferViews[acc.bufferView];
-                auto& b = gltf->buffers[bv.buffer];
-                smp.outputsVec4.reserve(acc.count);
-                assert(acc.componentType == GL_FLOAT);
                 if (acc.type == "VEC3")
                 {
-                    for (unsigned int i = 0; i < acc.count; ++i)
+                    kame::gltf::AccessorView<kame::math::Vector3> view(gltf, s.output);
+                    smp.outputsVec4.reserve(view.size());
+                    for (size_t i = 0; i < view.size(); ++i)
                     {
-                        auto v = ((kame::math::Vector3*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                        smp.outputsVec4.emplace_back(kame::math::Vector4(v, 0.0f));
+                        smp.outputsVec4.emplace_back(kame::math::Vector4(view[i], 0.0f));
                     }
                 }
                 else if (acc.type == "VEC4")
                 {
-                    for (unsigned int i = 0; i < acc.count; ++i)
-                    {
-                        auto v = ((kame::math::Vector4*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                        smp.outputsVec4.emplace_back(v);
-                    }
+                    // rotations may be normalized integers
+                    smp.outputsVec4 = kame::gltf::AccessorView<kame::math::Vector4>(gltf, s.output).toVector();
                 }
             }
         }
     }
 
+    for (auto& [_, clip] : clips)
+    {
+        clip.compile();
+    }
+
     return clips;
 }
 
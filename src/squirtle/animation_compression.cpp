@@ -0,0 +1,436 @@
+#include <all.hpp>
+
+namespace kame::squirtle {
+
+using kame::math::Quaternion;
+using kame::math::Vector3;
+using kame::math::Vector4;
+
+namespace {
+
+using Interpolation = AnimationClip::Sampler::InterpolationType;
+using Path = AnimationClip::Channel::PathType;
+
+constexpr float kSQRT1_2 = 0.70710678f;
+// the non-cubic kernels, indexed like AnimationClip::tracks
+constexpr int kNUM_COMPRESSED_KERNELS = 6;
+
+// angle of the rotation between a and b, atan2 keeps it precise for tiny angles where acos is not
+float rotationError(Vector4 a, Vector4 b)
+{
+    a = Vector4::normalize(a);
+    b = Vector4::normalize(b);
+    if (Vector4::dot(a, b) < 0.0f)
+    {
+        b = -b;
+    }
+    return 4.0f * std::atan2(Vector4::length(a - b), Vector4::length(a + b));
+}
+
+float componentError(Vector4 a, Vector4 b)
+{
+    return std::max({std::abs(a.x - b.x), std::abs(a.y - b.y), std::abs(a.z - b.z)});
+}
+
+Vector4 interpolateKeys(Vector4 a, Vector4 b, float u, bool rotation)
+{
+    if (rotation)
+    {
+        Quaternion q = Quaternion::normalize(Quaternion::slerp(a, b, u));
+        return Vector4(q.x, q.y, q.z, q.w);
+    }
+    return Vector4::lerp(a, b, u);
+}
+
+// indices of the keys to keep so that every dropped key stays within maxError of the result
+std::vector<uint32_t> reduceKeys(const std::vector<float>& times, const std::vector<Vector4>& values, bool step, bool rotation, float maxError)
+{
+    auto error = [&](Vector4 a, Vector4 b) {
+        return rotation ? rotationError(a, b) : componentError(a, b);
+    };
+
+    std::vector<uint32_t> kept = {0};
+    const uint32_t n = uint32_t(times.size());
+    bool constant = true;
+    for (uint32_t k = 1; k < n && constant; ++k)
+    {
+        constant = error(values[k], values[0]) <= maxError;
+    }
+    if (constant)
+    {
+        return kept;
+    }
+
+    if (step)
+    {
+        for (uint32_t k = 1; k < n; ++k)
+        {
+            if (error(values[k], values[kept.back()]) > maxError)
+            {
+                kept.emplace_back(k);
+            }
+        }
+        return kept;
+    }
+
+    // grow the segment from the last kept key until one of the keys it skips falls off it
+    uint32_t a = 0;
+    for (uint32_t b = 2; b < n; ++b)
+    {
+        float dt = times[b] - times[a];
+        for (uint32_t k = a + 1; k < b; ++k)
+        {
+            float u = dt > 0.0f ? (times[k] - times[a]) / dt : 0.0f;
+            if (error(interpolateKeys(values[a], values[b], u, rotation), values[k]) > maxError)
+            {
+                a = b - 1;
+                kept.emplace_back(a);
+                break;
+            }
+        }
+    }
+    kept.emplace_back(n - 1);
+    return kept;
+}
+
+template <Path P>
+Vector4 decodeKey(const CompressedAnimationClip::Track& t, std::array<uint16_t, 3> v)
+{
+    if constexpr (P == Path::kROTATION)
+    {
+        Quaternion q = unpackQuaternion(v);
+        return Vector4(q.x, q.y, q.z, q.w);
+    }
+    else
+    {
+        return Vector4(t.min[0] + float(v[0]) * (t.extent[0] / 65535.0f),
+                       t.min[1] + float(v[1]) * (t.extent[1] / 65535.0f),
+                       t.min[2] + float(v[2]) * (t.extent[2] / 65535.0f),
+                       0.0f);
+    }
+}
+
+template <Interpolation I, Path P>
+Vector4 sampleTrack(const CompressedAnimationClip& clip, CompressedAnimationClip::Track& t, float time)
+{
+    const float* times = clip.times.data() + t.firstKey;
+    const auto* values = clip.values.data() + t.firstKey;
+    const uint32_t i = findKey(std::span<const float>(times, t.numKeys), 0.0f, time, t.cursor);
+    const uint32_t next = std::min(i + 1, t.numKeys - 1);
+    if constexpr (I == Interpolation::kSTEP)
+    {
+        return decodeKey<P>(t, values[time >= times[next] ? next : i]);
+    }
+    else
+    {
+        float u = next != i ? std::clamp((time - times[i]) / (times[next] - times[i]), 0.0f, 1.0f) : 0.0f;
+        return interpolateKeys(decodeKey<P>(t, values[i]), decodeKey<P>(t, values[next]), u, P == Path::kROTATION);
+    }
+}
+
+void writeKey(Node* nodes, uint32_t id, Path path, Vector4 v)
+{
+    switch (path)
+    {
+        case Path::kTRANSLATION:
+            nodes[id].position = Vector3(v.x, v.y, v.z);
+            break;
+        case Path::kROTATION:
+            nodes[id].rotation = Quaternion(v);
+            break;
+        case Path::kSCALE:
+            nodes[id].scale = Vector3(v.x, v.y, v.z);
+            break;
+    }
+}
+
+void writeKey(Pose* pose, uint32_t id, Path path, Vector4 v)
+{
+    switch (path)
+    {
+        case Path::kTRANSLATION:
+            pose->positions[id] = Vector3(v.x, v.y, v.z);
+            break;
+        case Path::kROTATION:
+            pose->rotations[id] = Quaternion(v);
+            break;
+        case Path::kSCALE:
+            pose->scales[id] = Vector3(v.x, v.y, v.z);
+            break;
+    }
+}
+
+// Target is Node* or Pose*, the path switch folds away once inlined
+template <Interpolation I, Path P, typename Target>
+void evaluateTracks(CompressedAnimationClip& clip, std::vector<CompressedAnimationClip::Track>& tracks, Target target, float time)
+{
+    for (auto& t : tracks)
+    {
+        writeKey(target, t.targetID, P, sampleTrack<I, P>(clip, t, time));
+    }
+}
+
+template <typename Target>
+using CompressedTrackKernel = void (*)(CompressedAnimationClip&, std::vector<CompressedAnimationClip::Track>&, Target, float);
+
+template <typename Target>
+constexpr CompressedTrackKernel<Target> kCompressedTrackKernels[kNUM_COMPRESSED_KERNELS] = {
+    evaluateTracks<Interpolation::kLINEAR, Path::kTRANSLATION, Target>,
+    evaluateTracks<Interpolation::kLINEAR, Path::kROTATION, Target>,
+    evaluateTracks<Interpolation::kLINEAR, Path::kSCALE, Target>,
+    evaluateTracks<Interpolation::kSTEP, Path::kTRANSLATION, Target>,
+    evaluateTracks<Interpolation::kSTEP, Path::kROTATION, Target>,
+    evaluateTracks<Interpolation::kSTEP, Path::kSCALE, Target>,
+};
+
+template <typename Target>
+void evaluateClip(CompressedAnimationClip& clip, Target target, float time)
+{
+    for (int k = 0; k < kNUM_COMPRESSED_KERNELS; ++k)
+    {
+        if (!clip.tracks[k].empty())
+        {
+            kCompressedTrackKernels<Target>[k](clip, clip.tracks[k], target, time);
+        }
+    }
+}
+
+Vector4 sampleCompressed(const CompressedAnimationClip& clip, CompressedAnimationClip::Track t, int kernel, float time)
+{
+    switch (kernel)
+    {
+        case 0: return sampleTrack<Interpolation::kLINEAR, Path::kTRANSLATION>(clip, t, time);
+        case 1: return sampleTrack<Interpolation::kLINEAR, Path::kROTATION>(clip, t, time);
+        case 2: return sampleTrack<Interpolation::kLINEAR, Path::kSCALE>(clip, t, time);
+        case 3: return sampleTrack<Interpolation::kSTEP, Path::kTRANSLATION>(clip, t, time);
+        case 4: return sampleTrack<Interpolation::kSTEP, Path::kROTATION>(clip, t, time);
+        default: return sampleTrack<Interpolation::kSTEP, Path::kSCALE>(clip, t, time);
+    }
+}
+
+} // namespace
+
+std::array<uint16_t, 3> packQuaternion(Quaternion q)
+{
+    float c[4] = {q.x, q.y, q.z, q.w};
+    int largest = 0;
+    for (int i = 1; i < 4; ++i)
+    {
+        if (std::abs(c[i]) > std::abs(c[largest]))
+        {
+            largest = i;
+        }
+    }
+
+    // q and -q are the same rotation, flip so the dropped component is positive
+    float len = std::sqrt(c[0] * c[0] + c[1] * c[1] + c[2] * c[2] + c[3] * c[3]);
+    float scale = (c[largest] < 0.0f ? -1.0f : 1.0f) / len;
+
+    // the other three are within +-1/sqrt(2), 15 bits each
+    std::array<uint16_t, 3> packed;
+    int k = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+        {
+            continue;
+        }
+        float v = std::clamp(c[i] * scale * kSQRT1_2 + 0.5f, 0.0f, 1.0f);
+        packed[k++] = uint16_t(uint16_t(std::lround(v * 32767.0f)) << 1);
+    }
+    packed[0] |= uint16_t(largest >> 1);
+    packed[1] |= uint16_t(largest & 1);
+    return packed;
+}
+
+Quaternion unpackQuaternion(std::array<uint16_t, 3> packed)
+{
+    int largest = ((packed[0] & 1) << 1) | (packed[1] & 1);
+    float c[4];
+    float sumSq = 0.0f;
+    int k = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        if (i == largest)
+        {
+            continue;
+        }
+        c[i] = (float(packed[k++] >> 1) / 32767.0f - 0.5f) / kSQRT1_2;
+        sumSq += c[i] * c[i];
+    }
+    c[largest] = std::sqrt(std::max(0.0f, 1.0f - sumSq));
+    return Quaternion(c[0], c[1], c[2], c[3]);
+}
+
+size_t CompressedAnimationClip::getSizeInBytes() const
+{
+    size_t bytes = times.size() * sizeof(float) + values.size() * sizeof(values[0]);
+    for (auto& t : tracks)
+    {
+        bytes += t.size() * sizeof(Track);
+    }
+    return bytes;
+}
+
+CompressedAnimationClip compressAnimation(const AnimationClip& clip, const AnimationCompressionOptions& options, AnimationCompressionStats* stats)
+{
+    CompressedAnimationClip compressed;
+    compressed.name = clip.name;
+    compressed.startTime = clip.startTime;
+    compressed.endTime = clip.endTime;
+
+    AnimationCompressionStats s;
+    std::vector<bool> countedSamplers(clip.samplers.size(), false);
+    std::vector<float> times;
+    std::vector<Vector4> values;
+    for (auto& c : clip.channels)
+    {
+        if (c.targetID < 0 || c.samplerID >= clip.samplers.size() || !clip.samplers[c.samplerID].isPlayable())
+        {
+            continue;
+        }
+        const auto& sampler = clip.samplers[c.samplerID];
+        const bool rotation = c.path == Path::kROTATION;
+        if (!countedSamplers[c.samplerID])
+        {
+            countedSamplers[c.samplerID] = true;
+            s.originalBytes += sampler.inputs.size() * sizeof(float) + sampler.outputsVec4.size() * sizeof(Vector4);
+        }
+        s.originalKeys += sampler.inputs.size();
+
+        times.clear();
+        values.clear();
+        uint32_t cursor = 0;
+        Interpolation interpolation = sampler.interpolation;
+        if (interpolation == Interpolation::kCUBICSPLINE)
+        {
+            // resample between every key pair, the key times themselves are kept
+            interpolation = Interpolation::kLINEAR;
+            for (size_t k = 0; k < sampler.inputs.size(); ++k)
+            {
+                int steps = 1;
+                if (k + 1 < sampler.inputs.size())
+                {
+                    steps = std::max(1, int(std::ceil((sampler.inputs[k + 1] - sampler.inputs[k]) * options.cubicSampleRate)));
+                }
+                for (int j = 0; j < steps; ++j)
+                {
+                    float t = k + 1 < sampler.inputs.size() ? std::lerp(sampler.inputs[k], sampler.inputs[k + 1], float(j) / float(steps)) : sampler.inputs[k];
+                    times.emplace_back(t);
+                    values.emplace_back(sampler.sample(t, rotation, cursor));
+                }
+            }
+        }
+        else
+        {
+            times.assign(sampler.inputs.begin(), sampler.inputs.end());
+            values.assign(sampler.outputsVec4.begin(), sampler.outputsVec4.begin() + sampler.inputs.size());
+        }
+
+        float maxError = rotation ? options.rotationError : c.path == Path::kTRANSLATION ? options.translationError : options.scaleError;
+        std::vector<uint32_t> kept = reduceKeys(times, values, interpolation == Interpolation::kSTEP, rotation, maxError);
+
+        CompressedAnimationClip::Track track;
+        track.targetID = uint32_t(c.targetID);
+        track.firstKey = uint32_t(compressed.times.size());
+        track.numKeys = uint32_t(kept.size());
+        if (!rotation)
+        {
+            Vector4 lo = values[kept[0]];
+            Vector4 hi = lo;
+            for (uint32_t k : kept)
+            {
+                lo = Vector4(std::min(lo.x, values[k].x), std::min(lo.y, values[k].y), std::min(lo.z, values[k].z), 0.0f);
+                hi = Vector4(std::max(hi.x, values[k].x), std::max(hi.y, values[k].y), std::max(hi.z, values[k].z), 0.0f);
+            }
+            track.min[0] = lo.x;
+            track.min[1] = lo.y;
+            track.min[2] = lo.z;
+            track.extent[0] = hi.x - lo.x;
+            track.extent[1] = hi.y - lo.y;
+            track.extent[2] = hi.z - lo.z;
+        }
+        for (uint32_t k : kept)
+        {
+            compressed.times.emplace_back(times[k]);
+            if (rotation)
+            {
+                compressed.values.emplace_back(packQuaternion(values[k]));
+                continue;
+            }
+            std::array<uint16_t, 3> q;
+            const float v[3] = {values[k].x, values[k].y, values[k].z};
+            for (int i = 0; i < 3; ++i)
+            {
+                q[i] = track.extent[i] > 0.0f ? uint16_t(std::lround((v[i] - track.min[i]) / track.extent[i] * 65535.0f)) : 0;
+            }
+            compressed.values.emplace_back(q);
+        }
+        s.compressedKeys += kept.size();
+
+        int kernel = interpolation * 3 + c.path;
+        compressed.tracks[kernel].emplace_back(track);
+
+        if (stats)
+        {
+            // at the original keys and halfway between them
+            uint32_t sourceCursor = 0;
+            float& maxMeasured = rotation ? s.maxRotationError : c.path == Path::kTRANSLATION ? s.maxTranslationError : s.maxScaleError;
+            for (size_t k = 0; k < sampler.inputs.size(); ++k)
+            {
+                for (int half = 0; half < 2; ++half)
+                {
+                    if (half == 1 && k + 1 == sampler.inputs.size())
+                    {
+                        break;
+                    }
+                    float t = half == 0 ? sampler.inputs[k] : 0.5f * (sampler.inputs[k] + sampler.inputs[k + 1]);
+                    Vector4 a = sampler.sample(t, rotation, sourceCursor);
+                    Vector4 b = sampleCompressed(compressed, track, kernel, t);
+                    maxMeasured = std::max(maxMeasured, rotation ? rotationError(a, b) : componentError(a, b));
+                }
+            }
+        }
+    }
+
+    if (stats)
+    {
+        s.compressedBytes = compressed.getSizeInBytes();
+        s.ratio = s.compressedBytes > 0 ? float(s.originalBytes) / float(s.compressedBytes) : 0.0f;
+        *stats = s;
+    }
+    return compressed;
+}
+
+float animate(CompressedAnimationClip& clip, std::vector<Node>& nodes, float playTime)
+{
+    if (playTime > clip.endTime)
+    {
+        playTime = clip.startTime + (clip.endTime - playTime);
+    }
+
+    float time = playTime;
+    evaluateClip(clip, nodes.data(), time);
+
+    return time;
+}
+
+float animate(CompressedAnimationClip& clip, Model& model, float playTime)
+{
+    float time = animate(clip, model.nodes, playTime);
+    for (auto& tracks : clip.tracks)
+    {
+        for (auto& t : tracks)
+        {
+            model.markDirty(int(t.targetID));
+        }
+    }
+    return time;
+}
+
+void samplePose(CompressedAnimationClip& clip, float time, Pose& pose)
+{
+    evaluateClip(clip, &pose, time);
+}
+
+} // namespace kame::squirtle
@@ -0,0 +1,221 @@
+#include <all.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KAME_SQUIRTLE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace kame::squirtle {
+
+using kame::math::Matrix;
+using kame::math::Vector3;
+
+void AABB::merge(Vector3 p)
+{
+    min.x = std::min(min.x, p.x);
+    min.y = std::min(min.y, p.y);
+    min.z = std::min(min.z, p.z);
+    max.x = std::max(max.x, p.x);
+    max.y = std::max(max.y, p.y);
+    max.z = std::max(max.z, p.z);
+}
+
+void AABB::merge(const AABB& b)
+{
+    if (b.isEmpty())
+    {
+        return;
+    }
+    merge(b.min);
+    merge(b.max);
+}
+
+AABB AABB::transform(const AABB& b, const Matrix& m)
+{
+    if (b.isEmpty())
+    {
+        return b;
+    }
+
+    // the center moves with the matrix, the extents with its absolute values (Arvo)
+    Vector3 c = Vector3::transform(b.getCenter(), m);
+    Vector3 e = b.getExtents();
+    Vector3 r(std::abs(m.m11) * e.x + std::abs(m.m21) * e.y + std::abs(m.m31) * e.z,
+              std::abs(m.m12) * e.x + std::abs(m.m22) * e.y + std::abs(m.m32) * e.z,
+              std::abs(m.m13) * e.x + std::abs(m.m23) * e.y + std::abs(m.m33) * e.z);
+
+    AABB result;
+    result.min = c - r;
+    result.max = c + r;
+    return result;
+}
+
+AABB computeAABB(const std::vector<Vector3>& positions)
+{
+    AABB box;
+    for (const auto& p : positions)
+    {
+        box.merge(p);
+    }
+    return box;
+}
+
+BoundingSphere computeBoundingSphere(const std::vector<Vector3>& positions, const AABB& aabb)
+{
+    BoundingSphere sphere;
+    if (aabb.isEmpty())
+    {
+        return sphere;
+    }
+
+    sphere.center = aabb.getCenter();
+    float radiusSq = 0.0f;
+    for (const auto& p : positions)
+    {
+        radiusSq = std::max(radiusSq, Vector3::lengthSquared(p - sphere.center));
+    }
+    sphere.radius = std::sqrt(radiusSq);
+    return sphere;
+}
+
+Frustum Frustum::fromMatrix(const Matrix& viewProj)
+{
+    // clip = v * m, so each clip coordinate is a dot with a column (Gribb/Hartmann)
+    const Matrix& m = viewProj;
+    const float col1[4] = {m.m11, m.m21, m.m31, m.m41};
+    const float col2[4] = {m.m12, m.m22, m.m32, m.m42};
+    const float col3[4] = {m.m13, m.m23, m.m33, m.m43};
+    const float col4[4] = {m.m14, m.m24, m.m34, m.m44};
+    const float* cols[3] = {col1, col2, col3};
+
+    Frustum f;
+    for (int i = 0; i < 6; ++i)
+    {
+        // left, right, bottom, top, near, far
+        const float* col = cols[i / 2];
+        float sign = (i & 1) ? -1.0f : 1.0f;
+        float p[4];
+        for (int k = 0; k < 4; ++k)
+        {
+            p[k] = col4[k] + sign * col[k];
+        }
+        float len = std::sqrt(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]);
+        float invLen = len > 0.0f ? 1.0f / len : 0.0f;
+        f.a[i] = p[0] * invLen;
+        f.b[i] = p[1] * invLen;
+        f.c[i] = p[2] * invLen;
+        f.d[i] = p[3] * invLen;
+    }
+    return f;
+}
+
+bool Frustum::isVisible(const AABB& box) const
+{
+    if (box.isEmpty())
+    {
+        return false;
+    }
+
+    // the box is outside when its corner nearest the inside of a plane is still behind it
+    Vector3 center = box.getCenter();
+    Vector3 extents = box.getExtents();
+#ifdef KAME_SQUIRTLE_SSE2
+    const __m128 cx = _mm_set1_ps(center.x);
+    const __m128 cy = _mm_set1_ps(center.y);
+    const __m128 cz = _mm_set1_ps(center.z);
+    const __m128 ex = _mm_set1_ps(extents.x);
+    const __m128 ey = _mm_set1_ps(extents.y);
+    const __m128 ez = _mm_set1_ps(extents.z);
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 outside = _mm_setzero_ps();
+    for (int i = 0; i < kMAX_PLANES; i += 4)
+    {
+        __m128 pa = _mm_load_ps(a + i);
+        __m128 pb = _mm_load_ps(b + i);
+        __m128 pc = _mm_load_ps(c + i);
+        __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(pa, cx), _mm_mul_ps(pb, cy)), _mm_add_ps(_mm_mul_ps(pc, cz), _mm_load_ps(d + i)));
+        __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_and_ps(pa, absMask), ex), _mm_mul_ps(_mm_and_ps(pb, absMask), ey)), _mm_mul_ps(_mm_and_ps(pc, absMask), ez));
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, radius), _mm_setzero_ps()));
+    }
+    return _mm_movemask_ps(outside) == 0;
+#else
+    for (int i = 0; i < kMAX_PLANES; ++i)
+    {
+        float dist = a[i] * center.x + b[i] * center.y + c[i] * center.z + d[i];
+        float radius = std::abs(a[i]) * extents.x + std::abs(b[i]) * extents.y + std::abs(c[i]) * extents.z;
+        if (dist + radius < 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+#endif
+}
+
+bool Frustum::isVisible(const BoundingSphere& sphere) const
+{
+    if (sphere.radius < 0.0f)
+    {
+        return false;
+    }
+
+    for (int i = 0; i < kMAX_PLANES; ++i)
+    {
+        if (a[i] * sphere.center.x + b[i] * sphere.center.y + c[i] * sphere.center.z + d[i] < -sphere.radius)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t cullAABBs(const Frustum& frustum, const AABB* boxes, size_t count, uint8_t* visible)
+{
+    size_t numVisible = 0;
+    size_t i = 0;
+#ifdef KAME_SQUIRTLE_SSE2
+    // four boxes per step against one broadcast plane at a time
+    const __m128 half = _mm_set1_ps(0.5f);
+    for (; i + 4 <= count; i += 4)
+    {
+        const AABB* q = boxes + i;
+        __m128 minX = _mm_setr_ps(q[0].min.x, q[1].min.x, q[2].min.x, q[3].min.x);
+        __m128 minY = _mm_setr_ps(q[0].min.y, q[1].min.y, q[2].min.y, q[3].min.y);
+        __m128 minZ = _mm_setr_ps(q[0].min.z, q[1].min.z, q[2].min.z, q[3].min.z);
+        __m128 maxX = _mm_setr_ps(q[0].max.x, q[1].max.x, q[2].max.x, q[3].max.x);
+        __m128 maxY = _mm_setr_ps(q[0].max.y, q[1].max.y, q[2].max.y, q[3].max.y);
+        __m128 maxZ = _mm_setr_ps(q[0].max.z, q[1].max.z, q[2].max.z, q[3].max.z);
+        __m128 cx = _mm_mul_ps(_mm_add_ps(minX, maxX), half);
+        __m128 cy = _mm_mul_ps(_mm_add_ps(minY, maxY), half);
+        __m128 cz = _mm_mul_ps(_mm_add_ps(minZ, maxZ), half);
+        __m128 ex = _mm_mul_ps(_mm_sub_ps(maxX, minX), half);
+        __m128 ey = _mm_mul_ps(_mm_sub_ps(maxY, minY), half);
+        __m128 ez = _mm_mul_ps(_mm_sub_ps(maxZ, minZ), half);
+
+        __m128 outside = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(minX, maxX), _mm_cmpgt_ps(minY, maxY)), _mm_cmpgt_ps(minZ, maxZ));
+        for (int k = 0; k < Frustum::kMAX_PLANES; ++k)
+        {
+            __m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(frustum.a[k]), cx), _mm_mul_ps(_mm_set1_ps(frustum.b[k]), cy)),
+                                     _mm_add_ps(_mm_mul_ps(_mm_set1_ps(frustum.c[k]), cz), _mm_set1_ps(frustum.d[k])));
+            __m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::abs(frustum.a[k])), ex), _mm_mul_ps(_mm_set1_ps(std::abs(frustum.b[k])), ey)),
+                                       _mm_mul_ps(_mm_set1_ps(std::abs(frustum.c[k])), ez));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(dist, radius), _mm_setzero_ps()));
+        }
+
+        int mask = _mm_movemask_ps(outside);
+        for (int k = 0; k < 4; ++k)
+        {
+            visible[i + k] = (mask >> k) & 1 ? 0 : 1;
+            numVisible += visible[i + k];
+        }
+    }
+#endif
+    for (; i < count; ++i)
+    {
+        visible[i] = frustum.isVisible(boxes[i]) ? 1 : 0;
+        numVisible += visible[i];
+    }
+    return numVisible;
+}
+
+} // namespace kame::squirtle
@@ -66,4 +66,9 @@ void CameraOrbit::update(kame::sdl::State& state)
     projMtx = kame::math::Matrix::createPerspectiveFieldOfView_NO(verticalFov, float(state.drawableSizeX) / float(state.drawableSizeY), 0.1f, 100.0f);
 }
 
+Frustum CameraOrbit::getFrustum() const
+{
+    return Frustum::fromMatrix(modelMtx * viewMtx * projMtx);
+}
+
 } // namespace kame::squirtle
@@ -16,42 +16,15 @@ InstanceAttributes importInstanceAttributes(const kame::gltf::Gltf* gltf)
         {
             if (item.first == "TRANSLATION")
             {
-                auto& acc = gltf->accessors[item.second];
-                auto& bv = gltf->bufferViews[acc.bufferView];
-                auto& b = gltf->buffers[bv.buffer];
-                instance.tranlations.reserve(acc.count);
-                assert(acc.componentType == GL_FLOAT);
-                for (unsigned int i = 0; i < acc.count; ++i)
-                {
-                    auto v = ((kame::math::Vector3*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                    instance.tranlations.emplace_back(v);
-                }
+                instance.tranlations = kame::gltf::AccessorView<kame::math::Vector3>(gltf, item.second).toVector();
             }
             else if (item.first == "ROTATION")
             {
-                auto& acc = gltf->accessors[item.second];
-                auto& bv = gltf->bufferViews[acc.bufferView];
-                auto& b = gltf->buffers[bv.buffer];
-                instance.rotations.reserve(acc.count);
-                assert(acc.componentType == GL_FLOAT);
-                for (unsigned int i = 0; i < acc.count; ++i)
-                {
-                    auto v = ((kame::math::Vector4*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                    instance.rotations.emplace_back(v);
-                }
+                instance.rotations = kame::gltf::AccessorView<kame::math::Vector4>(gltf, item.second).toVector();
             }
             else if (item.first == "SCALE")
             {
-                auto& acc = gltf->accessors[item.second];
-                auto& bv = gltf->bufferViews[acc.bufferView];
-                auto& b = gltf->buffers[bv.buffer];
-                instance.scales.reserve(acc.count);
-                assert(acc.componentType == GL_FLOAT);
-                for (unsigned int i = 0; i < acc.count; ++i)
-                {
-                    auto v = ((kame::math::Vector3*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                    instance.scales.emplace_back(v);
-                }
+                instance.scales = kame::gltf::AccessorView<kame::math::Vector3>(gltf, item.second).toVector();
             }
         }
         break;
@@ -63,17 +36,12 @@ InstanceAttributes importInstanceAttributes(const kame::gltf::Gltf* gltf)
 
 std::vector<kame::math::Matrix> toInstanceMatrices(const InstanceAttributes& attributes)
 {
-    std::vector<kame::math::Matrix> instances;
     assert(attributes.tranlations.size() == attributes.rotations.size() && attributes.tranlations.size() == attributes.scales.size());
-    instances.reserve(attributes.tranlations.size());
-    for (size_t i = 0; i < attributes.tranlations.size(); ++i)
-    {
-        auto pos = attributes.tranlations[i];
-        auto rot = attributes.rotations[i];
-        auto scale = attributes.scales[i];
-        auto mtx = kame::math::Matrix::createScale(scale) * kame::math::Matrix::createFromQuaternion(rot) * kame::math::Matrix::createTranslation(pos);
-        instances.emplace_back(mtx);
-    }
+    std::vector<kame::math::Matrix> instances(attributes.tranlations.size());
+    // the accessor reads rotations as Vector4, same layout as Quaternion
+    static_assert(sizeof(kame::math::Vector4) == sizeof(kame::math::Quaternion));
+    std::span<const kame::math::Quaternion> rotations((const kame::math::Quaternion*)attributes.rotations.data(), attributes.rotations.size());
+    kame::math::composeTRS(attributes.tranlations, rotations, attributes.scales, instances);
     return instances;
 }
 
@@ -0,0 +1,511 @@
+#include <all.hpp>
+
+namespace kame::squirtle {
+
+namespace {
+
+using kame::math::Vector3;
+
+struct Quadric {
+    double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+    double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+    double c = 0.0;
+    double w = 0.0;
+
+    // plane n.p + d = 0
+    void addPlane(const Vector3& n, float d, float weight)
+    {
+        a00 += weight * n.x * n.x;
+        a01 += weight * n.x * n.y;
+        a02 += weight * n.x * n.z;
+        a11 += weight * n.y * n.y;
+        a12 += weight * n.y * n.z;
+        a22 += weight * n.z * n.z;
+        b0 += weight * n.x * d;
+        b1 += weight * n.y * d;
+        b2 += weight * n.z * d;
+        c += weight * d * d;
+        w += weight;
+    }
+
+    void add(const Quadric& q)
+    {
+        a00 += q.a00;
+        a01 += q.a01;
+        a02 += q.a02;
+        a11 += q.a11;
+        a12 += q.a12;
+        a22 += q.a22;
+        b0 += q.b0;
+        b1 += q.b1;
+        b2 += q.b2;
+        c += q.c;
+        w += q.w;
+    }
+
+    // weighted mean of the squared distances to the planes
+    double error(const Vector3& p) const
+    {
+        double x = p.x, y = p.y, z = p.z;
+        double e = a00 * x * x + a11 * y * y + a22 * z * z + 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) + 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return w > 0.0 ? std::max(e, 0.0) / w : 0.0;
+    }
+};
+
+enum VertexKind {
+    kVERTEX_KIND_MANIFOLD,
+    kVERTEX_KIND_BORDER,
+    kVERTEX_KIND_SEAM,
+    kVERTEX_KIND_LOCKED
+};
+
+struct Collapse {
+    unsigned int v;
+    unsigned int u;
+    float cost;
+};
+
+// border planes weigh more than the surface so open edges keep their shape
+constexpr float kBorderWeight = 10.0f;
+
+uint64_t edgeKey(unsigned int a, unsigned int b)
+{
+    return uint64_t(a) << 32 | b;
+}
+
+// half of the L1 distance between the joint influences of two vertices, 0 for identical and 1 for disjoint
+float skinDifference(const Primitive& p, unsigned int v, unsigned int u)
+{
+    if (p.joints.size() != p.positions.size() || p.weights.size() != p.positions.size())
+    {
+        return 0.0f;
+    }
+
+    uint16_t joints[8];
+    float weights[2][8] = {};
+    int n = 0;
+    const float wv[4] = {p.weights[v].x, p.weights[v].y, p.weights[v].z, p.weights[v].w};
+    const float wu[4] = {p.weights[u].x, p.weights[u].y, p.weights[u].z, p.weights[u].w};
+    auto insert = [&](uint16_t joint, float weight, int side) {
+        for (int i = 0; i < n; ++i)
+        {
+            if (joints[i] == joint)
+            {
+                weights[side][i] += weight;
+                return;
+            }
+        }
+        joints[n] = joint;
+        weights[side][n++] = weight;
+    };
+    for (int i = 0; i < 4; ++i)
+    {
+        insert(p.joints[v][i], wv[i], 0);
+        insert(p.joints[u][i], wu[i], 1);
+    }
+
+    float diff = 0.0f;
+    for (int i = 0; i < n; ++i)
+    {
+        diff += std::abs(weights[0][i] - weights[1][i]);
+    }
+    return 0.5f * diff;
+}
+
+} // namespace
+
+std::vector<unsigned int> simplify(const Primitive& primitive, const std::vector<unsigned int>& indices, size_t targetIndexCount, float targetError, float* resultError, const SimplifyOptions& options)
+{
+    const auto& positions = primitive.positions;
+    const size_t numVertices = positions.size();
+    const bool hasNormals = primitive.normals.size() == numVertices;
+
+    std::vector<unsigned int> result = indices;
+    double maxError = 0.0;
+    if (resultError)
+    {
+        *resultError = 0.0f;
+    }
+    if (result.size() <= targetIndexCount || numVertices == 0)
+    {
+        return result;
+    }
+
+    // vertices sharing a position. welded[v] is the first of them and twin[v] the other one of a pair
+    std::vector<unsigned int> welded(numVertices);
+    std::vector<unsigned int> twin(numVertices);
+    std::vector<unsigned int> groupSize(numVertices);
+    {
+        std::vector<unsigned int> order(numVertices);
+        std::iota(order.begin(), order.end(), 0u);
+        auto less = [&](unsigned int a, unsigned int b) {
+            const Vector3& pa = positions[a];
+            const Vector3& pb = positions[b];
+            return std::tie(pa.x, pa.y, pa.z, a) < std::tie(pb.x, pb.y, pb.z, b);
+        };
+        std::sort(order.begin(), order.end(), less);
+        for (size_t i = 0; i < numVertices;)
+        {
+            size_t j = i + 1;
+            const Vector3& p = positions[order[i]];
+            while (j < numVertices && positions[order[j]].x == p.x && positions[order[j]].y == p.y && positions[order[j]].z == p.z)
+            {
+                ++j;
+            }
+            for (size_t k = i; k < j; ++k)
+            {
+                welded[order[k]] = order[i];
+                groupSize[order[k]] = unsigned(j - i);
+                twin[order[k]] = j - i == 2 ? order[i + (k == i ? 1 : 0)] : order[k];
+            }
+            i = j;
+        }
+    }
+
+    std::vector<Quadric> quadrics(numVertices);
+    {
+        std::unordered_set<uint64_t> edges;
+        for (size_t t = 0; t < result.size(); t += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                edges.insert(edgeKey(welded[result[t + k]], welded[result[t + (k + 1) % 3]]));
+            }
+        }
+
+        for (size_t t = 0; t < result.size(); t += 3)
+        {
+            const Vector3& p0 = positions[result[t]];
+            Vector3 n = Vector3::cross(positions[result[t + 1]] - p0, positions[result[t + 2]] - p0);
+            float len = Vector3::length(n);
+            if (len <= 0.0f)
+            {
+                continue;
+            }
+            n = n / len;
+            for (int k = 0; k < 3; ++k)
+            {
+                quadrics[welded[result[t + k]]].addPlane(n, -Vector3::dot(n, p0), len * 0.5f);
+            }
+
+            // a plane through each open edge, perpendicular to the triangle
+            for (int k = 0; k < 3; ++k)
+            {
+                unsigned int a = welded[result[t + k]];
+                unsigned int b = welded[result[t + (k + 1) % 3]];
+                if (edges.count(edgeKey(b, a)))
+                {
+                    continue;
+                }
+                Vector3 e = positions[b] - positions[a];
+                Vector3 m = Vector3::cross(e, n);
+                float mlen = Vector3::length(m);
+                if (mlen <= 0.0f)
+                {
+                    continue;
+                }
+                m = m / mlen;
+                float weight = Vector3::lengthSquared(e) * kBorderWeight;
+                quadrics[a].addPlane(m, -Vector3::dot(m, positions[a]), weight);
+                quadrics[b].addPlane(m, -Vector3::dot(m, positions[a]), weight);
+            }
+        }
+    }
+
+    const double errorLimit = double(targetError) * double(targetError);
+    std::vector<unsigned int> remap(numVertices);
+    std::vector<uint8_t> isLocked(numVertices);
+    std::vector<uint8_t> isBorder(numVertices);
+    std::vector<unsigned int> adjacencyOffsets(numVertices + 1);
+    std::vector<unsigned int> adjacency;
+    std::vector<Collapse> collapses;
+
+    while (result.size() > targetIndexCount)
+    {
+        std::unordered_set<uint64_t> weldedEdges;
+        std::unordered_set<uint64_t> indexEdges;
+        for (size_t t = 0; t < result.size(); t += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                unsigned int a = result[t + k];
+                unsigned int b = result[t + (k + 1) % 3];
+                weldedEdges.insert(edgeKey(welded[a], welded[b]));
+                indexEdges.insert(edgeKey(a, b));
+            }
+        }
+        auto isBorderEdge = [&](unsigned int wa, unsigned int wb) {
+            return weldedEdges.count(edgeKey(wa, wb)) != weldedEdges.count(edgeKey(wb, wa));
+        };
+
+        std::fill(isBorder.begin(), isBorder.end(), 0);
+        for (uint64_t e : weldedEdges)
+        {
+            unsigned int a = unsigned(e >> 32);
+            unsigned int b = unsigned(e);
+            if (!weldedEdges.count(edgeKey(b, a)))
+            {
+                isBorder[a] = 1;
+                isBorder[b] = 1;
+            }
+        }
+        auto kindOf = [&](unsigned int v) {
+            if (groupSize[v] == 1)
+            {
+                return isBorder[welded[v]] ? kVERTEX_KIND_BORDER : kVERTEX_KIND_MANIFOLD;
+            }
+            if (groupSize[v] == 2 && !isBorder[welded[v]])
+            {
+                return kVERTEX_KIND_SEAM;
+            }
+            return kVERTEX_KIND_LOCKED;
+        };
+
+        // triangles around each vertex
+        std::fill(adjacencyOffsets.begin(), adjacencyOffsets.end(), 0);
+        for (unsigned int i : result)
+        {
+            adjacencyOffsets[i + 1]++;
+        }
+        for (size_t v = 0; v < numVertices; ++v)
+        {
+            adjacencyOffsets[v + 1] += adjacencyOffsets[v];
+        }
+        adjacency.resize(result.size());
+        {
+            std::vector<unsigned int> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+            for (size_t i = 0; i < result.size(); ++i)
+            {
+                adjacency[fill[result[i]]++] = unsigned(i / 3);
+            }
+        }
+
+        collapses.clear();
+        auto tryCollapse = [&](unsigned int v, unsigned int u) {
+            if (welded[v] == welded[u])
+            {
+                return;
+            }
+            switch (kindOf(v))
+            {
+                case kVERTEX_KIND_LOCKED:
+                    return;
+                case kVERTEX_KIND_BORDER:
+                    if (!isBorderEdge(welded[v], welded[u]))
+                    {
+                        return;
+                    }
+                    break;
+                case kVERTEX_KIND_SEAM:
+                    if (kindOf(u) != kVERTEX_KIND_SEAM || (!indexEdges.count(edgeKey(twin[v], twin[u])) && !indexEdges.count(edgeKey(twin[u], twin[v]))))
+                    {
+                        return;
+                    }
+                    break;
+                case kVERTEX_KIND_MANIFOLD:
+                    break;
+            }
+
+            Quadric q = quadrics[welded[v]];
+            q.add(quadrics[welded[u]]);
+            float penalty = 0.0f;
+            if (hasNormals)
+            {
+                penalty += options.normalWeight * (1.0f - Vector3::dot(primitive.normals[v], primitive.normals[u]));
+            }
+            penalty += options.skinWeight * skinDifference(primitive, v, u);
+            double cost = q.error(positions[u]) + double(penalty) * Vector3::lengthSquared(positions[u] - positions[v]);
+            collapses.push_back({v, u, float(cost)});
+        };
+        for (size_t t = 0; t < result.size(); t += 3)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                unsigned int a = result[t + k];
+                unsigned int b = result[t + (k + 1) % 3];
+                tryCollapse(a, b);
+                tryCollapse(b, a);
+            }
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        // v's triangles must not flip or refer to a vertex that already moved in this pass
+        auto canCollapse = [&](unsigned int v, unsigned int u) {
+            for (unsigned int i = adjacencyOffsets[v]; i < adjacencyOffsets[v + 1]; ++i)
+            {
+                const unsigned int* tri = result.data() + adjacency[i] * 3;
+                if (remap[tri[0]] != tri[0] || remap[tri[1]] != tri[1] || remap[tri[2]] != tri[2])
+                {
+                    return false;
+                }
+                if (tri[0] == u || tri[1] == u || tri[2] == u)
+                {
+                    continue;
+                }
+                Vector3 p[3] = {positions[tri[0]], positions[tri[1]], positions[tri[2]]};
+                Vector3 before = Vector3::cross(p[1] - p[0], p[2] - p[0]);
+                for (int k = 0; k < 3; ++k)
+                {
+                    if (tri[k] == v)
+                    {
+                        p[k] = positions[u];
+                    }
+                }
+                Vector3 after = Vector3::cross(p[1] - p[0], p[2] - p[0]);
+                if (Vector3::dot(before, after) <= 0.0f)
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+        size_t numRemoved = 0;
+        auto applyCollapse = [&](unsigned int v, unsigned int u) {
+            remap[v] = u;
+            for (unsigned int i = adjacencyOffsets[v]; i < adjacencyOffsets[v + 1]; ++i)
+            {
+                const unsigned int* tri = result.data() + adjacency[i] * 3;
+                for (int k = 0; k < 3; ++k)
+                {
+                    isLocked[welded[tri[k]]] = 1;
+                }
+                numRemoved += (tri[0] == u || tri[1] == u || tri[2] == u) ? 1 : 0;
+            }
+        };
+
+        std::iota(remap.begin(), remap.end(), 0u);
+        std::fill(isLocked.begin(), isLocked.end(), 0);
+        const size_t numToRemove = (result.size() - targetIndexCount + 2) / 3;
+        size_t numApplied = 0;
+        bool isErrorLimited = false;
+        for (const Collapse& c : collapses)
+        {
+            if (numRemoved >= numToRemove)
+            {
+                break;
+            }
+            if (c.cost > errorLimit)
+            {
+                isErrorLimited = true;
+                break;
+            }
+            if (isLocked[welded[c.v]] || isLocked[welded[c.u]])
+            {
+                continue;
+            }
+
+            const bool isSeam = kindOf(c.v) == kVERTEX_KIND_SEAM;
+            if (!canCollapse(c.v, c.u) || (isSeam && !canCollapse(twin[c.v], twin[c.u])))
+            {
+                continue;
+            }
+
+            quadrics[welded[c.u]].add(quadrics[welded[c.v]]);
+            applyCollapse(c.v, c.u);
+            if (isSeam)
+            {
+                applyCollapse(twin[c.v], twin[c.u]);
+            }
+            maxError = std::max(maxError, double(c.cost));
+            ++numApplied;
+        }
+
+        if (numApplied == 0)
+        {
+            break;
+        }
+
+        size_t numIndices = 0;
+        for (size_t t = 0; t < result.size(); t += 3)
+        {
+            unsigned int a = remap[result[t]];
+            unsigned int b = remap[result[t + 1]];
+            unsigned int c = remap[result[t + 2]];
+            if (welded[a] == welded[b] || welded[b] == welded[c] || welded[c] == welded[a])
+            {
+                continue;
+            }
+            result[numIndices++] = a;
+            result[numIndices++] = b;
+            result[numIndices++] = c;
+        }
+        result.resize(numIndices);
+
+        if (isErrorLimited)
+        {
+            break;
+        }
+    }
+
+    if (resultError)
+    {
+        *resultError = float(std::sqrt(maxError));
+    }
+    return result;
+}
+
+void generateLODs(Primitive& primitive, const LODOptions& options)
+{
+    primitive.lods.clear();
+    if (options.numLevels <= 0 || primitive.mode != GL_TRIANGLES || primitive.indices.size() < 3 || primitive.positions.empty())
+    {
+        return;
+    }
+
+    Vector3 lo = primitive.positions[0];
+    Vector3 hi = primitive.positions[0];
+    for (const auto& p : primitive.positions)
+    {
+        lo = Vector3(std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z));
+        hi = Vector3(std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z));
+    }
+    const float extent = std::max({hi.x - lo.x, hi.y - lo.y, hi.z - lo.z});
+
+    size_t prevCount = primitive.indices.size();
+    float prevError = 0.0f;
+    float target = float(primitive.indices.size());
+    for (int level = 0; level < options.numLevels; ++level)
+    {
+        target *= options.reduction;
+        PrimitiveLOD lod;
+        lod.indices = simplify(primitive, primitive.indices, size_t(target) / 3 * 3, options.maxError * extent, &lod.error, options.simplify);
+        // not worth a level
+        if (lod.indices.empty() || lod.indices.size() * 20 > prevCount * 19)
+        {
+            break;
+        }
+        optimizeVertexCache(lod.indices, primitive.positions.size());
+        lod.error = std::max(lod.error, prevError);
+        prevCount = lod.indices.size();
+        prevError = lod.error;
+        primitive.lods.emplace_back(std::move(lod));
+    }
+}
+
+int LODSelector::select(const Primitive& primitive, const kame::math::Matrix& world) const
+{
+    if (primitive.lods.empty() || projectionScale <= 0.0f)
+    {
+        return 0;
+    }
+
+    // the largest axis scale bounds how much the object space error grows
+    float scale = std::sqrt(std::max({world.m11 * world.m11 + world.m12 * world.m12 + world.m13 * world.m13,
+                                      world.m21 * world.m21 + world.m22 * world.m22 + world.m23 * world.m23,
+                                      world.m31 * world.m31 + world.m32 * world.m32 + world.m33 * world.m33}));
+    float distance = std::max(Vector3::length(Vector3(world.m41, world.m42, world.m43) - viewPosition), 1e-4f);
+    float pixelsPerUnit = scale * projectionScale / distance;
+
+    int lod = 0;
+    for (size_t i = 0; i < primitive.lods.size(); ++i)
+    {
+        if (primitive.lods[i].error * pixelsPerUnit > pixelThreshold)
+        {
+            break;
+        }
+        lod = int(i + 1);
+    }
+    return lod;
+}
+
+} // namespace kame::squirtle
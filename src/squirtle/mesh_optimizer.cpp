@@ -0,0 +1,360 @@
+#include <all.hpp>
+
+namespace kame::squirtle {
+
+VertexCacheStatistics analyzeVertexCache(const std::vector<unsigned int>& indices, size_t numVertices, unsigned int cacheSize)
+{
+    VertexCacheStatistics stats;
+    if (indices.empty() || numVertices == 0)
+    {
+        return stats;
+    }
+
+    // a vertex is cached while fewer than cacheSize vertices were pushed after it
+    std::vector<size_t> pushedAt(numVertices, 0);
+    size_t numPushed = 0;
+    for (unsigned int i : indices)
+    {
+        assert(i < numVertices);
+        if (pushedAt[i] == 0 || numPushed - (pushedAt[i] - 1) > cacheSize)
+        {
+            pushedAt[i] = ++numPushed;
+        }
+    }
+
+    stats.verticesTransformed = numPushed;
+    stats.acmr = float(numPushed) / float(indices.size() / 3);
+    stats.atvr = float(numPushed) / float(numVertices);
+    return stats;
+}
+
+namespace {
+
+constexpr int kForsythCacheSize = 32;
+
+float forsythScore(int cachePos, unsigned int remaining)
+{
+    if (remaining == 0)
+    {
+        return -1.0f;
+    }
+
+    float score = 0.0f;
+    if (cachePos >= 0)
+    {
+        // the last triangle's vertices get a fixed score so the next one does not just reuse its edge
+        if (cachePos < 3)
+        {
+            score = 0.75f;
+        }
+        else
+        {
+            score = std::pow(1.0f - float(cachePos - 3) / float(kForsythCacheSize - 3), 1.5f);
+        }
+    }
+    // boost vertices with few triangles left so they are not stranded
+    return score + 2.0f / std::sqrt(float(remaining));
+}
+
+} // namespace
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t numVertices)
+{
+    const size_t numTris = indices.size() / 3;
+    if (numTris == 0)
+    {
+        return;
+    }
+
+    // triangles around each vertex, the live ones are [offsets[v], offsets[v] + remaining[v])
+    std::vector<unsigned int> remaining(numVertices, 0);
+    for (unsigned int i : indices)
+    {
+        assert(i < numVertices);
+        remaining[i]++;
+    }
+    std::vector<unsigned int> offsets(numVertices + 1, 0);
+    for (size_t v = 0; v < numVertices; ++v)
+    {
+        offsets[v + 1] = offsets[v] + remaining[v];
+    }
+    std::vector<unsigned int> adjacency(indices.size());
+    {
+        std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t t = 0; t < numTris; ++t)
+        {
+            for (int k = 0; k < 3; ++k)
+            {
+                adjacency[fill[indices[t * 3 + k]]++] = unsigned(t);
+            }
+        }
+    }
+
+    std::vector<int> cachePos(numVertices, -1);
+    std::vector<float> vertexScores(numVertices);
+    for (size_t v = 0; v < numVertices; ++v)
+    {
+        vertexScores[v] = forsythScore(-1, remaining[v]);
+    }
+
+    std::vector<float> triScores(numTris);
+    std::vector<uint8_t> isEmitted(numTris, 0);
+    size_t best = 0;
+    for (size_t t = 0; t < numTris; ++t)
+    {
+        triScores[t] = vertexScores[indices[t * 3]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+        if (triScores[t] > triScores[best])
+        {
+            best = t;
+        }
+    }
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    std::vector<unsigned int> cache;
+    std::vector<unsigned int> newCache;
+    cache.reserve(kForsythCacheSize + 3);
+    newCache.reserve(kForsythCacheSize + 3);
+    size_t cursor = 0;
+
+    while (result.size() < indices.size())
+    {
+        if (best == numTris)
+        {
+            // nothing in the cache touches a live triangle, continue with the next one in the input
+            while (isEmitted[cursor])
+            {
+                ++cursor;
+            }
+            best = cursor;
+        }
+
+        isEmitted[best] = 1;
+        newCache.clear();
+        for (int k = 0; k < 3; ++k)
+        {
+            unsigned int v = indices[best * 3 + k];
+            result.push_back(v);
+
+            unsigned int* live = adjacency.data() + offsets[v];
+            for (unsigned int i = 0; i < remaining[v]; ++i)
+            {
+                if (live[i] == best)
+                {
+                    std::swap(live[i], live[remaining[v] - 1]);
+                    break;
+                }
+            }
+            remaining[v]--;
+
+            if (std::find(newCache.begin(), newCache.end(), v) == newCache.end())
+            {
+                newCache.push_back(v);
+            }
+        }
+        const size_t numFresh = newCache.size();
+        for (unsigned int v : cache)
+        {
+            if (std::find(newCache.begin(), newCache.begin() + numFresh, v) == newCache.begin() + numFresh)
+            {
+                newCache.push_back(v);
+            }
+        }
+
+        for (size_t i = 0; i < newCache.size(); ++i)
+        {
+            cachePos[newCache[i]] = i < kForsythCacheSize ? int(i) : -1;
+        }
+
+        // refresh the scores of everything that moved in or out of the cache, and pick the best triangle among them
+        best = numTris;
+        float bestScore = -1.0f;
+        for (unsigned int v : newCache)
+        {
+            float score = forsythScore(cachePos[v], remaining[v]);
+            float delta = score - vertexScores[v];
+            vertexScores[v] = score;
+            const unsigned int* live = adjacency.data() + offsets[v];
+            for (unsigned int i = 0; i < remaining[v]; ++i)
+            {
+                triScores[live[i]] += delta;
+            }
+        }
+        for (size_t i = 0; i < newCache.size() && i < kForsythCacheSize; ++i)
+        {
+            unsigned int v = newCache[i];
+            const unsigned int* live = adjacency.data() + offsets[v];
+            for (unsigned int j = 0; j < remaining[v]; ++j)
+            {
+                if (triScores[live[j]] > bestScore)
+                {
+                    bestScore = triScores[live[j]];
+                    best = live[j];
+                }
+            }
+        }
+
+        if (newCache.size() > kForsythCacheSize)
+        {
+            newCache.resize(kForsythCacheSize);
+        }
+        cache.swap(newCache);
+    }
+
+    indices.swap(result);
+}
+
+void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<kame::math::Vector3>& positions)
+{
+    using kame::math::Vector3;
+
+    const size_t numTris = indices.size() / 3;
+    if (numTris < 2)
+    {
+        return;
+    }
+
+    // a cluster starts wherever the cache order starts over, i.e. a triangle misses on all of its vertices
+    std::vector<size_t> clusters;
+    {
+        const unsigned int cacheSize = 16;
+        std::vector<size_t> pushedAt(positions.size(), 0);
+        size_t numPushed = 0;
+        for (size_t t = 0; t < numTris; ++t)
+        {
+            int misses = 0;
+            for (int k = 0; k < 3; ++k)
+            {
+                unsigned int i = indices[t * 3 + k];
+                if (pushedAt[i] == 0 || numPushed - (pushedAt[i] - 1) > cacheSize)
+                {
+                    pushedAt[i] = ++numPushed;
+                    ++misses;
+                }
+            }
+            if (t == 0 || misses == 3)
+            {
+                clusters.push_back(t);
+            }
+        }
+    }
+    if (clusters.size() < 2)
+    {
+        return;
+    }
+    clusters.push_back(numTris);
+
+    Vector3 meshCentre = Vector3::zero();
+    for (const auto& p : positions)
+    {
+        meshCentre += p;
+    }
+    meshCentre = meshCentre / float(positions.size());
+
+    // clusters facing away from the centre are drawn first as they are the most likely occluders
+    std::vector<std::pair<float, size_t>> keys(clusters.size() - 1);
+    for (size_t c = 0; c + 1 < clusters.size(); ++c)
+    {
+        Vector3 centroid = Vector3::zero();
+        Vector3 normal = Vector3::zero();
+        float area = 0.0f;
+        for (size_t t = clusters[c]; t < clusters[c + 1]; ++t)
+        {
+            const Vector3& a = positions[indices[t * 3]];
+            const Vector3& b = positions[indices[t * 3 + 1]];
+            const Vector3& d = positions[indices[t * 3 + 2]];
+            Vector3 n = Vector3::cross(b - a, d - a);
+            float w = Vector3::length(n);
+            centroid += (a + b + d) * (w / 3.0f);
+            normal += n;
+            area += w;
+        }
+        if (area > 0.0f)
+        {
+            centroid = centroid / area;
+        }
+        float len = Vector3::length(normal);
+        float key = len > 0.0f ? Vector3::dot(centroid - meshCentre, normal / len) : 0.0f;
+        keys[c] = {-key, c};
+    }
+    std::stable_sort(keys.begin(), keys.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (const auto& k : keys)
+    {
+        result.insert(result.end(), indices.begin() + clusters[k.second] * 3, indices.begin() + clusters[k.second + 1] * 3);
+    }
+    indices.swap(result);
+}
+
+std::vector<unsigned int> optimizeVertexFetch(std::vector<unsigned int>& indices, size_t numVertices)
+{
+    const unsigned int kUnused = ~0u;
+    std::vector<unsigned int> remap(numVertices, kUnused);
+    unsigned int next = 0;
+    for (unsigned int& i : indices)
+    {
+        assert(i < numVertices);
+        if (remap[i] == kUnused)
+        {
+            remap[i] = next++;
+        }
+        i = remap[i];
+    }
+    for (auto& r : remap)
+    {
+        if (r == kUnused)
+        {
+            r = next++;
+        }
+    }
+    return remap;
+}
+
+template <typename T>
+static void remapVertices(std::vector<T>& v, const std::vector<unsigned int>& remap)
+{
+    if (v.size() != remap.size())
+    {
+        return;
+    }
+    std::vector<T> result(v.size());
+    for (size_t i = 0; i < v.size(); ++i)
+    {
+        result[remap[i]] = v[i];
+    }
+    v.swap(result);
+}
+
+MeshOptimizationReport optimizePrimitive(Primitive& primitive)
+{
+    MeshOptimizationReport report;
+    const size_t numVertices = primitive.positions.size();
+    if (primitive.mode != GL_TRIANGLES || primitive.indices.size() < 3 || numVertices == 0)
+    {
+        return report;
+    }
+
+    report.before = analyzeVertexCache(primitive.indices, numVertices);
+
+    optimizeVertexCache(primitive.indices, numVertices);
+    optimizeOverdraw(primitive.indices, primitive.positions);
+
+    std::vector<unsigned int> remap = optimizeVertexFetch(primitive.indices, numVertices);
+    remapVertices(primitive.positions, remap);
+    remapVertices(primitive.normals, remap);
+    remapVertices(primitive.tangents, remap);
+    for (auto& uv : primitive.uvSets)
+    {
+        remapVertices(uv, remap);
+    }
+    remapVertices(primitive.joints, remap);
+    remapVertices(primitive.weights, remap);
+
+    report.after = analyzeVertexCache(primitive.indices, numVertices);
+    report.isOptimized = true;
+    return report;
+}
+
+} // namespace kame::squirtle
@@ -0,0 +1,208 @@
+#include <all.hpp>
+
+namespace kame::squirtle {
+
+using kame::math::Vector3;
+
+static MeshletBounds computeMeshletBounds(const Primitive& primitive, const MeshletData& data, const Meshlet& meshlet)
+{
+    const auto& positions = primitive.positions;
+    const uint32_t* vertices = data.vertices.data() + meshlet.vertexOffset;
+    const uint8_t* triangles = data.triangles.data() + meshlet.triangleOffset;
+
+    MeshletBounds bounds;
+    Vector3 lo = positions[vertices[0]];
+    Vector3 hi = lo;
+    for (uint32_t i = 1; i < meshlet.vertexCount; ++i)
+    {
+        const Vector3& p = positions[vertices[i]];
+        lo = Vector3(std::min(lo.x, p.x), std::min(lo.y, p.y), std::min(lo.z, p.z));
+        hi = Vector3(std::max(hi.x, p.x), std::max(hi.y, p.y), std::max(hi.z, p.z));
+    }
+    bounds.center = (lo + hi) * 0.5f;
+    bounds.radius = 0.0f;
+    for (uint32_t i = 0; i < meshlet.vertexCount; ++i)
+    {
+        bounds.radius = std::max(bounds.radius, Vector3::length(positions[vertices[i]] - bounds.center));
+    }
+
+    std::vector<Vector3> normals;
+    std::vector<Vector3> corners;
+    normals.reserve(meshlet.triangleCount);
+    corners.reserve(meshlet.triangleCount);
+    Vector3 axis = Vector3::zero();
+    for (uint32_t t = 0; t < meshlet.triangleCount; ++t)
+    {
+        const Vector3& p0 = positions[vertices[triangles[t * 3]]];
+        Vector3 n = Vector3::cross(positions[vertices[triangles[t * 3 + 1]]] - p0, positions[vertices[triangles[t * 3 + 2]]] - p0);
+        float len = Vector3::length(n);
+        if (len > 0.0f)
+        {
+            normals.emplace_back(n / len);
+            corners.emplace_back(p0);
+            axis += n / len;
+        }
+    }
+
+    // a degenerate cone never culls
+    bounds.coneApex = bounds.center;
+    bounds.coneAxis = Vector3::zero();
+    bounds.coneCutoff = 1.0f;
+    bounds.pad = 0.0f;
+
+    float axisLength = Vector3::length(axis);
+    if (axisLength <= 0.0f)
+    {
+        return bounds;
+    }
+    axis = axis / axisLength;
+
+    float minDot = 1.0f;
+    for (const auto& n : normals)
+    {
+        minDot = std::min(minDot, Vector3::dot(n, axis));
+    }
+    // wider than ~84 degrees is not worth testing
+    if (minDot <= 0.1f)
+    {
+        return bounds;
+    }
+
+    // move the apex back along the axis until every triangle plane faces away from it
+    float maxT = 0.0f;
+    for (size_t i = 0; i < normals.size(); ++i)
+    {
+        float t = Vector3::dot(bounds.center - corners[i], normals[i]) / Vector3::dot(axis, normals[i]);
+        maxT = std::max(maxT, t);
+    }
+    bounds.coneApex = bounds.center - axis * maxT;
+    bounds.coneAxis = axis;
+    bounds.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+    return bounds;
+}
+
+MeshletData buildMeshlets(const Primitive& primitive, size_t maxVertices, size_t maxTriangles)
+{
+    assert(maxVertices >= 3 && maxVertices <= 256);
+    assert(maxTriangles >= 1);
+
+    MeshletData data;
+    if (primitive.mode != GL_TRIANGLES || primitive.indices.size() < 3)
+    {
+        return data;
+    }
+
+    const uint32_t kNone = ~0u;
+    const auto& indices = primitive.indices;
+    std::vector<uint32_t> local(primitive.positions.size(), kNone);
+    data.vertices.reserve(indices.size() / 3);
+    data.triangles.reserve(indices.size() + indices.size() / 3);
+
+    Meshlet meshlet;
+    auto finish = [&]() {
+        if (meshlet.triangleCount == 0)
+        {
+            return;
+        }
+        for (size_t i = meshlet.vertexOffset; i < data.vertices.size(); ++i)
+        {
+            local[data.vertices[i]] = kNone;
+        }
+        while (data.triangles.size() % 4 != 0)
+        {
+            data.triangles.push_back(0);
+        }
+        data.meshlets.push_back(meshlet);
+        data.bounds.push_back(computeMeshletBounds(primitive, data, meshlet));
+
+        meshlet = Meshlet();
+        meshlet.vertexOffset = uint32_t(data.vertices.size());
+        meshlet.triangleOffset = uint32_t(data.triangles.size());
+    };
+
+    for (size_t t = 0; t + 2 < indices.size(); t += 3)
+    {
+        const unsigned int tri[3] = {indices[t], indices[t + 1], indices[t + 2]};
+        size_t numNew = 0;
+        for (int k = 0; k < 3; ++k)
+        {
+            bool isRepeated = (k > 0 && tri[k] == tri[0]) || (k > 1 && tri[k] == tri[1]);
+            numNew += (local[tri[k]] == kNone && !isRepeated) ? 1 : 0;
+        }
+        if (meshlet.vertexCount + numNew > maxVertices || meshlet.triangleCount + 1 > maxTriangles)
+        {
+            finish();
+        }
+
+        for (int k = 0; k < 3; ++k)
+        {
+            if (local[tri[k]] == kNone)
+            {
+                local[tri[k]] = meshlet.vertexCount++;
+                data.vertices.push_back(tri[k]);
+            }
+            data.triangles.push_back(uint8_t(local[tri[k]]));
+        }
+        meshlet.triangleCount++;
+    }
+    finish();
+
+    return data;
+}
+
+bool isMeshletBackfacing(const MeshletBounds& bounds, const kame::math::Vector3& cameraPosition)
+{
+    if (bounds.coneCutoff >= 1.0f)
+    {
+        return false;
+    }
+    Vector3 d = bounds.coneApex - cameraPosition;
+    return Vector3::dot(d, bounds.coneAxis) >= bounds.coneCutoff * Vector3::length(d);
+}
+
+void appendMeshletIndices(const MeshletData& data, size_t meshlet, std::vector<unsigned int>& indices)
+{
+    const Meshlet& m = data.meshlets[meshlet];
+    const uint32_t* vertices = data.vertices.data() + m.vertexOffset;
+    const uint8_t* triangles = data.triangles.data() + m.triangleOffset;
+    for (uint32_t i = 0; i < m.triangleCount * 3; ++i)
+    {
+        indices.push_back(vertices[triangles[i]]);
+    }
+}
+
+template <typename T>
+static kame::ogl::ShaderStorageBuffer* createStorage(const std::vector<T>& v)
+{
+    if (v.empty())
+    {
+        return nullptr;
+    }
+    kame::ogl::ShaderStorageBuffer* ssbo = kame::ogl::createShaderStorageBuffer(sizeof(T) * v.size(), GL_STATIC_DRAW);
+    ssbo->setBuffer(v.data());
+    return ssbo;
+}
+
+MeshletBuffers createMeshletBuffers(const MeshletData& data)
+{
+    MeshletBuffers buffers;
+    buffers.meshlets = createStorage(data.meshlets);
+    buffers.bounds = createStorage(data.bounds);
+    buffers.vertices = createStorage(data.vertices);
+    buffers.triangles = createStorage(data.triangles);
+    return buffers;
+}
+
+void deleteMeshletBuffers(MeshletBuffers& buffers)
+{
+    for (auto** b : {&buffers.meshlets, &buffers.bounds, &buffers.vertices, &buffers.triangles})
+    {
+        if (*b)
+        {
+            kame::ogl::deleteShaderStorageBuffer(*b);
+            *b = nullptr;
+        }
+    }
+}
+
+} // namespace kame::squirtle
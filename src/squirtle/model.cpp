@@ -37,6 +37,12 @@ const std::vector<unsigned int>& Primitive::getIndices() const
     return indices;
 }
 
+const std::vector<unsigned int>& Primitive::getIndices(int lod) const
+{
+    assert(lod >= 0 && lod <= int(lods.size()));
+    return lod == 0 ? indices : lods[lod - 1].indices;
+}
+
 size_t Primitive::getBytesOfPositions() const
 {
     return sizeof(float) * 3 * positions.size();
@@ -62,6 +68,31 @@ size_t Primitive::getBytesOfIndices() const
     return sizeof(unsigned int) * indices.size();
 }
 
+GLenum Primitive::getIndexType() const
+{
+    return positions.size() <= 65536 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+}
+
+size_t Primitive::getBytesOfIndexData() const
+{
+    return getIndexType() == GL_UNSIGNED_SHORT ? sizeof(uint16_t) * indices.size() : getBytesOfIndices();
+}
+
+void Primitive::copyIndexData(void* dst) const
+{
+    if (getIndexType() == GL_UNSIGNED_INT)
+    {
+        std::memcpy(dst, indices.data(), getBytesOfIndices());
+        return;
+    }
+    uint16_t* out = (uint16_t*)dst;
+    for (size_t i = 0; i < indices.size(); ++i)
+    {
+        assert(indices[i] < positions.size());
+        out[i] = uint16_t(indices[i]);
+    }
+}
+
 std::vector<kame::math::Vector3> toVertexPositions(const kame::gltf::Gltf* gltf, const kame::gltf::Mesh::Primitive& pri)
 {
     std::vector<kame::math::Vector3> positions;
@@ -70,16 +101,7 @@ std::vector<kame::math::Vector3> toVertexPositions(const kame::gltf::Gltf* gltf,
     {
         if (item.first == "POSITION")
         {
-            auto& acc = gltf->accessors[item.second];
-            auto& bv = gltf->bufferViews[acc.bufferView];
-            auto& b = gltf->buffers[bv.buffer];
-            positions.reserve(acc.count);
-            assert(acc.componentType == GL_FLOAT);
-            for (unsigned int i = 0; i < acc.count; ++i)
-            {
-                auto v = ((kame::math::Vector3*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                positions.emplace_back(v);
-            }
+            positions = kame::gltf::AccessorView<kame::math::Vector3>(gltf, item.second).toVector();
         }
     }
 
@@ -94,16 +116,7 @@ std::vector<kame::math::Vector3> toVertexNormals(const kame::gltf::Gltf* gltf, c
     {
         if (item.first == "NORMAL")
         {
-            auto& acc = gltf->accessors[item.second];
-            auto& bv = gltf->bufferViews[acc.bufferView];
-            auto& b = gltf->buffers[bv.buffer];
-            normals.reserve(acc.count);
-            assert(acc.componentType == GL_FLOAT);
-            for (unsigned int i = 0; i < acc.count; ++i)
-            {
-                auto v = ((kame::math::Vector3*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                normals.emplace_back(v);
-            }
+            normals = kame::gltf::AccessorView<kame::math::Vector3>(gltf, item.second).toVector();
         }
     }
 
@@ -118,16 +131,7 @@ std::vector<kame::math::Vector4> toVertexTangents(const kame::gltf::Gltf* gltf,
     {
         if (item.first == "TANGENT")
         {
-            auto& acc = gltf->accessors[item.second];
-            auto& bv = gltf->bufferViews[acc.bufferView];
-            auto& b = gltf->buffers[bv.buffer];
-            tangents.reserve(acc.count);
-            assert(acc.componentType == GL_FLOAT);
-            for (unsigned int i = 0; i < acc.count; ++i)
-            {
-                auto v = ((kame::math::Vector4*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                tangents.emplace_back(v);
-            }
+            tangents = kame::gltf::AccessorView<kame::math::Vector4>(gltf, item.second).toVector();
         }
     }
 
@@ -147,31 +151,9 @@ std::vector<std::vector<kame::math::Vector2>> toVertexUVSets(const kame::gltf::G
             assert(uvid >= 0);
             assert(size_t(uvid) < uvSets.size());
 
-            auto& acc = gltf->accessors[item.second];
-            auto& bv = gltf->bufferViews[acc.bufferView];
-            auto& b = gltf->buffers[bv.buffer];
-            uvSets[uvid].reserve(acc.count);
-            assert(acc.componentType == GL_FLOAT || acc.componentType == GL_UNSIGNED_BYTE || acc.componentType == GL_UNSIGNED_SHORT);
-            for (unsigned int i = 0; i < acc.count; ++i)
-            {
-                if (acc.componentType == GL_FLOAT)
-                {
-                    auto v = ((kame::math::Vector2*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                    uvSets[uvid].emplace_back(v);
-                }
-                else if (acc.componentType == GL_UNSIGNED_BYTE)
-                {
-                    auto s = ((unsigned char*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                    auto t = ((unsigned char*)(b.data() + bv.byteOffset + acc.byteOffset))[++i];
-                    uvSets[uvid].emplace_back(s / 255.0f, t / 255.0f);
-                }
-                else if (acc.componentType == GL_UNSIGNED_SHORT)
-                {
-                    auto s = ((unsigned short*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                    auto t = ((unsigned short*)(b.data() + bv.byteOffset + acc.byteOffset))[++i];
-                    uvSets[uvid].emplace_back(s / 65535.0f, t / 65535.0f);
-                }
-            }
+            kame::gltf::AccessorView<kame::math::Vector2> view(gltf, item.second);
+            assert(view.componentType == GL_FLOAT || view.componentType == GL_UNSIGNED_BYTE || view.componentType == GL_UNSIGNED_SHORT);
+            uvSets[uvid] = view.toVector();
         }
     }
 
@@ -180,35 +162,15 @@ std::vector<std::vector<kame::math::Vector2>> toVertexUVSets(const kame::gltf::G
 
 std::vector<u16Array4> toVertexJoints(const kame::gltf::Gltf* gltf, const kame::gltf::Mesh::Primitive& pri)
 {
-    std::vector<std::array<uint16_t, 4>> joints;
+    std::vector<u16Array4> joints;
 
     for (auto& item : pri.attributes)
     {
         if (item.first == "JOINTS_0")
         {
-            auto& acc = gltf->accessors[item.second];
-            auto& bv = gltf->bufferViews[acc.bufferView];
-            auto& b = gltf->buffers[bv.buffer];
-            joints.reserve(acc.count);
-            assert(acc.componentType == GL_UNSIGNED_BYTE || acc.componentType == GL_UNSIGNED_SHORT);
-            for (unsigned int i = 0; i < acc.count; ++i)
-            {
-                if (acc.componentType == GL_UNSIGNED_BYTE)
-                {
-                    auto e = ((u8Array4*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                    u16Array4 v;
-                    v[0] = e[0];
-                    v[1] = e[1];
-                    v[2] = e[2];
-                    v[3] = e[3];
-                    joints.emplace_back(v);
-                }
-                else if (acc.componentType == GL_UNSIGNED_SHORT)
-                {
-                    auto v = ((u16Array4*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                    joints.emplace_back(v);
-                }
-            }
+            kame::gltf::AccessorView<u16Array4> view(gltf, item.second);
+            assert(view.componentType == GL_UNSIGNED_BYTE || view.componentType == GL_UNSIGNED_SHORT);
+            joints = view.toVector();
         }
     }
 
@@ -223,39 +185,9 @@ std::vector<kame::math::Vector4> toVertexWeights(const kame::gltf::Gltf* gltf, c
     {
         if (item.first == "WEIGHTS_0")
         {
-            auto& acc = gltf->accessors[item.second];
-            auto& bv = gltf->bufferViews[acc.bufferView];
-            auto& b = gltf->buffers[bv.buffer];
-            weights.reserve(acc.count);
-            assert(acc.componentType == GL_FLOAT || acc.componentType == GL_UNSIGNED_BYTE || acc.componentType == GL_UNSIGNED_SHORT);
-            for (unsigned int i = 0; i < acc.count; ++i)
-            {
-                if (acc.componentType == GL_FLOAT)
-                {
-                    auto v = ((kame::math::Vector4*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                    weights.emplace_back(v);
-                }
-                else if (acc.componentType == GL_UNSIGNED_BYTE)
-                {
-                    auto e = ((u8Array4*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                    kame::math::Vector4 v;
-                    v.x = e[0] / 255.0f;
-                    v.y = e[1] / 255.0f;
-                    v.z = e[2] / 255.0f;
-                    v.w = e[3] / 255.0f;
-                    weights.emplace_back(v);
-                }
-                else if (acc.componentType == GL_UNSIGNED_SHORT)
-                {
-                    auto e = ((u16Array4*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                    kame::math::Vector4 v;
-                    v.x = e[0] / 65535.0f;
-                    v.y = e[1] / 65535.0f;
-                    v.z = e[2] / 65535.0f;
-                    v.w = e[3] / 65535.0f;
-                    weights.emplace_back(v);
-                }
-            }
+            kame::gltf::AccessorView<kame::math::Vector4> view(gltf, item.second);
+            assert(view.componentType == GL_FLOAT || view.componentType == GL_UNSIGNED_BYTE || view.componentType == GL_UNSIGNED_SHORT);
+            weights = view.toVector();
         }
     }
 
@@ -268,50 +200,92 @@ std::vector<unsigned int> toVertexIndices(const kame::gltf::Gltf* gltf, const ka
 
     if (pri.hasIndices)
     {
-        auto& acc = gltf->accessors[pri.indices];
-        auto& bv = gltf->bufferViews[acc.bufferView];
-        auto& b = gltf->buffers[bv.buffer];
-        indices.reserve(acc.count);
-        assert(acc.componentType == GL_UNSIGNED_INT || acc.componentType == GL_UNSIGNED_BYTE || acc.componentType == GL_UNSIGNED_SHORT);
-        for (unsigned int i = 0; i < acc.count; ++i)
-        {
-            if (acc.componentType == GL_UNSIGNED_BYTE)
+        kame::gltf::AccessorView<unsigned int> view(gltf, pri.indices);
+        assert(view.componentType == GL_UNSIGNED_INT || view.componentType == GL_UNSIGNED_BYTE || view.componentType == GL_UNSIGNED_SHORT);
+        indices = view.toVector();
+    }
+
+    return indices;
+}
+
+AABB toVertexBounds(const kame::gltf::Gltf* gltf, const kame::gltf::Mesh::Primitive& pri)
+{
+    AABB bounds;
+
+    for (auto& item : pri.attributes)
+    {
+        if (item.first == "POSITION")
+        {
+            // min/max are in component units, only float positions can be taken as is
+            const auto& acc = gltf->accessors[item.second];
+            if (acc.componentType == GL_FLOAT && acc.min.size() == 3 && acc.max.size() == 3)
             {
-                auto e = ((unsigned char*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                indices.emplace_back(e);
+                bounds.min = kame::math::Vector3(float(acc.min[0]), float(acc.min[1]), float(acc.min[2]));
+                bounds.max = kame::math::Vector3(float(acc.max[0]), float(acc.max[1]), float(acc.max[2]));
             }
-            else if (acc.componentType == GL_UNSIGNED_SHORT)
+        }
+    }
+
+    return bounds;
+}
+
+// a skinned vertex is a weighted blend of its joints' transforms, so it stays inside the
+// union of the boxes of every joint it references
+static std::vector<AABB> computeJointBounds(const Primitive& pri)
+{
+    std::vector<AABB> bounds;
+    if (pri.joints.size() != pri.positions.size() || pri.weights.size() != pri.positions.size())
+    {
+        return bounds;
+    }
+
+    for (size_t i = 0; i < pri.positions.size(); ++i)
+    {
+        const float w[4] = {pri.weights[i].x, pri.weights[i].y, pri.weights[i].z, pri.weights[i].w};
+        for (int k = 0; k < 4; ++k)
+        {
+            if (w[k] <= 0.0f)
             {
-                auto e = ((unsigned short*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                indices.emplace_back(e);
+                continue;
             }
-            else if (acc.componentType == GL_UNSIGNED_INT)
+            uint16_t j = pri.joints[i][k];
+            if (bounds.size() <= j)
             {
-                auto e = ((unsigned int*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-                indices.emplace_back(e);
+                bounds.resize(j + 1);
             }
+            bounds[j].merge(pri.positions[i]);
         }
     }
 
-    return indices;
+    return bounds;
 }
 
-Model* importModel(const kame::gltf::Gltf* gltf)
+Model* importModel(const kame::gltf::Gltf* gltf, const ImportOptions& options)
 {
     Model* model = new Model();
     assert(model);
+
+    // slots are laid out up front so primitives land in the same place whatever thread decodes them
+    std::vector<std::pair<size_t, size_t>> jobs;
     int primIdx = 0;
-    model->meshes.reserve(gltf->meshes.size());
-    for (auto& m : gltf->meshes)
+    model->meshes.resize(gltf->meshes.size());
+    for (size_t i = 0; i < gltf->meshes.size(); ++i)
     {
-        model->meshes.emplace_back();
-        auto& mesh = model->meshes.back();
+        auto& mesh = model->meshes[i];
+        mesh.primitives.resize(gltf->meshes[i].primitives.size());
+        for (size_t j = 0; j < mesh.primitives.size(); ++j)
+        {
+            mesh.primitives[j].id = primIdx++;
+            jobs.emplace_back(i, j);
+        }
+    }
 
-        mesh.primitives.reserve(m.primitives.size());
-        for (auto& p : m.primitives)
+    std::vector<MeshOptimizationReport> reports(options.optimizeMeshes ? jobs.size() : 0);
+    auto decode = [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k)
         {
-            mesh.primitives.emplace_back();
-            auto& pri = mesh.primitives.back();
+            auto& p = gltf->meshes[jobs[k].first].primitives[jobs[k].second];
+            auto& pri = model->meshes[jobs[k].first].primitives[jobs[k].second];
             pri.positions = toVertexPositions(gltf, p);
             pri.normals = toVertexNormals(gltf, p);
             pri.tangents = toVertexTangents(gltf, p);
@@ -319,6 +293,13 @@ Model* importModel(const kame::gltf::Gltf* gltf)
             pri.joints = toVertexJoints(gltf, p);
             pri.weights = toVertexWeights(gltf, p);
             pri.indices = toVertexIndices(gltf, p);
+            pri.bounds = toVertexBounds(gltf, p);
+            if (pri.bounds.isEmpty())
+            {
+                pri.bounds = computeAABB(pri.positions);
+            }
+            pri.sphere = computeBoundingSphere(pri.positions, pri.bounds);
+            pri.jointBounds = computeJointBounds(pri);
             if (p.hasMaterial)
             {
                 // assert(p.material >= 0);
@@ -326,7 +307,57 @@ Model* importModel(const kame::gltf::Gltf* gltf)
             }
             assert(p.mode == GL_POINTS || p.mode == GL_LINES || p.mode == GL_LINE_LOOP || p.mode == GL_LINE_STRIP || p.mode == GL_TRIANGLES || p.mode == GL_TRIANGLE_STRIP || p.mode == GL_TRIANGLE_FAN);
             pri.mode = p.mode;
-            pri.id = primIdx++;
+            if (options.optimizeMeshes)
+            {
+                reports[k] = optimizePrimitive(pri);
+            }
+            generateLODs(pri, options.lod);
+            if (options.generateMeshlets)
+            {
+                pri.meshlets = buildMeshlets(pri);
+            }
+            if (options.packedAttributes)
+            {
+                pri.packed = packVertices(pri, options.packedAttributes);
+            }
+        }
+    };
+
+    if (options.numThreads == 1 || jobs.size() < 2)
+    {
+        decode(0, jobs.size());
+    }
+    else
+    {
+        ThreadPool pool(options.numThreads);
+        pool.parallelFor(jobs.size(), 1, decode);
+    }
+
+    if (options.optimizeMeshes)
+    {
+        size_t transformedBefore = 0;
+        size_t transformedAfter = 0;
+        size_t numTris = 0;
+        size_t numVertices = 0;
+        for (size_t k = 0; k < jobs.size(); ++k)
+        {
+            if (reports[k].isOptimized)
+            {
+                const auto& pri = model->meshes[jobs[k].first].primitives[jobs[k].second];
+                transformedBefore += reports[k].before.verticesTransformed;
+                transformedAfter += reports[k].after.verticesTransformed;
+                numTris += pri.indices.size() / 3;
+                numVertices += pri.positions.size();
+            }
+        }
+        if (numTris > 0)
+        {
+            SPDLOG_INFO("optimized {} triangles, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+                        numTris,
+                        float(transformedBefore) / numTris,
+                        float(transformedAfter) / numTris,
+                        float(transformedBefore) / numVertices,
+                        float(transformedAfter) / numVertices);
         }
     }
 
@@ -466,16 +497,9 @@ Model* importModel(const kame::gltf::Gltf* gltf)
         model->skins.emplace_back();
         auto& skin = model->skins.back();
         assert(s.hasInverseBindMatrices);
-        auto& acc = gltf->accessors[s.inverseBindMatrices];
-        auto& bv = gltf->bufferViews[acc.bufferView];
-        auto& b = gltf->buffers[bv.buffer];
-        skin.inverseBindMatrices.reserve(acc.count);
-        assert(acc.componentType == GL_FLOAT);
-        for (unsigned int i = 0; i < acc.count; ++i)
-        {
-            auto v = ((kame::math::Matrix*)(b.data() + bv.byteOffset + acc.byteOffset))[i];
-            skin.inverseBindMatrices.emplace_back(v);
-        }
+        kame::gltf::AccessorView<kame::math::Matrix> view(gltf, s.inverseBindMatrices);
+        assert(view.componentType == GL_FLOAT);
+        skin.inverseBindMatrices = view.toVector();
         skin.joints.reserve(s.joints.size());
         for (auto& jID : s.joints)
         {
@@ -487,28 +511,97 @@ Model* importModel(const kame::gltf::Gltf* gltf)
     return model;
 }
 
-void updateGlobalXForm(Model* model, int id)
+void updateWorldBounds(Model* model, Node& node)
 {
-    Node& node = model->nodes[id];
-    auto local = node.updateLocalXForm();
-    auto global = kame::math::Matrix::identity();
+    const Mesh& mesh = model->meshes[node.meshID];
+    node.worldBounds = AABB();
+    node.primitiveWorldBounds.resize(mesh.primitives.size());
+    for (size_t i = 0; i < mesh.primitives.size(); ++i)
+    {
+        node.primitiveWorldBounds[i] = AABB::transform(mesh.primitives[i].bounds, node.globalXForm);
+        node.worldBounds.merge(node.primitiveWorldBounds[i]);
+    }
+}
 
-    if (node.parent >= 0 && node.skinID < 0)
+void updateSkinnedWorldBounds(Model* model, Node& node, const std::vector<kame::math::Matrix>& skinMatrices)
+{
+    const Mesh& mesh = model->meshes[node.meshID];
+    node.worldBounds = AABB();
+    node.primitiveWorldBounds.resize(mesh.primitives.size());
+    for (size_t i = 0; i < mesh.primitives.size(); ++i)
     {
-        global = model->nodes[node.parent].globalXForm;
+        const auto& jointBounds = mesh.primitives[i].jointBounds;
+        AABB& bounds = node.primitiveWorldBounds[i];
+        // without joints the primitive is rigid in the node's space
+        bounds = jointBounds.empty() ? mesh.primitives[i].bounds : AABB();
+        for (size_t j = 0; j < jointBounds.size() && j < skinMatrices.size(); ++j)
+        {
+            bounds.merge(AABB::transform(jointBounds[j], skinMatrices[j]));
+        }
+        node.worldBounds.merge(bounds);
     }
+}
 
-    node.globalXForm = local * global;
-    for (auto c : node.children)
+void updateGlobalXForms(Model* model)
+{
+    TransformHierarchy& h = model->transforms;
+    if (h.size() != model->nodes.size())
+    {
+        h.build(model->nodes);
+    }
+    else
     {
-        updateGlobalXForm(model, c);
+        // TRS written straight into Model::nodes, e.g. by the std::vector<Node> overloads of animate() or
+        // applyPose(), is found against the hierarchy's copy. only the changed subtrees are recomputed
+        for (uint32_t i = 0; i < h.size(); ++i)
+        {
+            const Node& node = model->nodes[h.nodeIDs[i]];
+            const auto& p = h.positions[i];
+            const auto& r = h.rotations[i];
+            const auto& s = h.scales[i];
+            if (p.x != node.position.x || p.y != node.position.y || p.z != node.position.z ||
+                r.x != node.rotation.x || r.y != node.rotation.y || r.z != node.rotation.z || r.w != node.rotation.w ||
+                s.x != node.scale.x || s.y != node.scale.y || s.z != node.scale.z)
+            {
+                h.positions[i] = node.position;
+                h.rotations[i] = node.rotation;
+                h.scales[i] = node.scale;
+                h.markDirty(i);
+            }
+        }
+    }
+    h.update();
+
+    for (uint32_t i = h.updatedBegin; i < h.updatedEnd; ++i)
+    {
+        if (!h.changed[i])
+        {
+            continue;
+        }
+        Node& node = model->nodes[h.nodeIDs[i]];
+        node.localXForm = h.locals[i].toMatrix();
+        node.globalXForm = h.worlds[i].toMatrix();
+        if (node.meshID >= 0 && node.skinID < 0)
+        {
+            updateWorldBounds(model, node);
+        }
     }
 }
 
 void updateSkinMatrices(Model* model)
 {
+    const TransformHierarchy& h = model->transforms;
     for (auto& skin : model->skins)
     {
+        skin._changed = false;
+        for (int joint : skin.joints)
+        {
+            skin._changed |= h.changed[h.indices[joint]] != 0;
+        }
+        if (!skin._changed)
+        {
+            continue;
+        }
         for (uint32_t i = 0; i < skin.joints.size(); ++i)
         {
             Node& joint = model->nodes[skin.joints[i]];
@@ -519,50 +612,67 @@ void updateSkinMatrices(Model* model)
 
 void updateSkinnedMesh(Model* model, std::vector<kame::math::Vector3>& positions, UpdateCB& fn)
 {
-    for (auto& n : model->nodes)
+    const TransformHierarchy& h = model->transforms;
+    for (size_t id = 0; id < model->nodes.size(); ++id)
     {
+        Node& n = model->nodes[id];
         if (n.meshID < 0 || n.skinID < 0)
         {
             continue;
         }
 
-        auto invertMtx = kame::math::Matrix::invert(n.globalXForm);
-
+        // neither the joints nor the skinned node moved, the joint matrices and bounds still hold
         Skin& s = model->skins[n.skinID];
-        static std::vector<kame::math::Matrix> skinMatrices;
-        skinMatrices.resize(s.matrices.size());
-        for (size_t i = 0; i < s.matrices.size(); ++i)
+        if (s._changed || h.changed[h.indices[id]] || n.jointMatrices.size() != s.matrices.size())
         {
-            skinMatrices[i] = s.matrices[i] * invertMtx;
+            auto invertMtx = kame::math::Matrix::invert(n.globalXForm);
+            n.jointMatrices.resize(s.matrices.size());
+            kame::math::multiplyMatrices(s.matrices, invertMtx, n.jointMatrices);
+            updateSkinnedWorldBounds(model, n, n.jointMatrices);
+        }
+        if (!model->frustum.isVisible(n.worldBounds))
+        {
+            continue;
+        }
+
+        bool isGPU = model->skinningMode == kSKINNING_GPU && n.jointMatrices.size() <= size_t(kMAX_GPU_JOINTS);
+        if (!isGPU)
+        {
+            model->skinner.setJoints(n.jointMatrices);
         }
 
         Mesh& srcMesh = model->meshes[n.meshID];
-        for (Primitive& pri : srcMesh.primitives)
+        auto& visible = model->_visible;
+        visible.resize(srcMesh.primitives.size());
+        cullAABBs(model->frustum, n.primitiveWorldBounds.data(), visible.size(), visible.data());
+        for (size_t k = 0; k < srcMesh.primitives.size(); ++k)
         {
+            if (!visible[k])
+            {
+                continue;
+            }
+            Primitive& pri = srcMesh.primitives[k];
+            int lod = model->lodSelector.select(pri, n.globalXForm);
+            const auto& indices = pri.getIndices(lod);
             const auto& priPositions = pri.getPositions();
-            const auto& priJoints = pri.getJoints();
-            const auto& priWeights = pri.getWeights();
-            if (positions.size() < priPositions.size())
+            // a primitive without JOINTS or WEIGHTS is already in the node's space the skinned vertices end up in
+            if (pri.joints.empty() || pri.weights.empty())
             {
-                positions.resize(priPositions.size());
+                fn({priPositions, *model, pri, indices, lod, n.primitiveWorldBounds[k]});
+                continue;
+            }
+            if (isGPU)
+            {
+                fn({priPositions, *model, pri, indices, lod, n.primitiveWorldBounds[k], n.jointMatrices});
+                continue;
             }
-            for (auto i : pri.getIndices())
+
+            if (positions.size() < priPositions.size())
             {
-                auto vPos = priPositions[i];
-                auto vJoint = priJoints[i];
-                auto vWeight = priWeights[i];
-
-                // clang-format off
-                auto skinMtx =
-                    skinMatrices[vJoint[0]] * vWeight.x
-                  + skinMatrices[vJoint[1]] * vWeight.y
-                  + skinMatrices[vJoint[2]] * vWeight.z
-                  + skinMatrices[vJoint[3]] * vWeight.w;
-                // clang-format on
-
-                positions[i] = kame::math::Vector3::transform(vPos, skinMtx);
+                positions.resize(priPositions.size());
             }
-            fn({positions, *model, pri});
+            model->skinner.skin({priPositions.data(), pri.joints.data(), pri.weights.data(), priPositions.size()}, positions.data());
+            fn({positions, *model, pri, indices, lod, n.primitiveWorldBounds[k]});
         }
     }
 }
@@ -576,90 +686,70 @@ void updateMesh(Model* model, std::vector<kame::math::Vector3>& positions, Updat
             continue;
         }
 
+        if (!model->frustum.isVisible(n.worldBounds))
+        {
+            continue;
+        }
+
         Mesh& srcMesh = model->meshes[n.meshID];
-        for (Primitive& pri : srcMesh.primitives)
+        auto& visible = model->_visible;
+        visible.resize(srcMesh.primitives.size());
+        cullAABBs(model->frustum, n.primitiveWorldBounds.data(), visible.size(), visible.data());
+        for (size_t k = 0; k < srcMesh.primitives.size(); ++k)
         {
+            if (!visible[k])
+            {
+                continue;
+            }
+            Primitive& pri = srcMesh.primitives[k];
             const auto& priPositions = pri.getPositions();
             positions.resize(priPositions.size());
-            for (auto i : pri.getIndices())
+            int lod = model->lodSelector.select(pri, n.globalXForm);
+            const auto& indices = pri.getIndices(lod);
+            // every vertex once when the indices reference them all anyway, only the listed ones for coarse lods
+            if (indices.size() >= priPositions.size())
+            {
+                kame::math::transformPoints(priPositions, n.globalXForm, positions);
+            }
+            else
             {
-                auto vPos = priPositions[i];
-                positions[i] = kame::math::Vector3::transform(vPos, n.globalXForm);
+                kame::math::transformPoints(priPositions, indices, n.globalXForm, positions);
             }
-            fn({positions, *model, pri});
+            fn({positions, *model, pri, indices, lod, n.primitiveWorldBounds[k]});
         }
     }
 }
 
-float animate(AnimationClip& clip, std::vector<Node>& nodes, float playTime)
+void Model::setLocalTransform(int nodeID, kame::math::Vector3 position, kame::math::Quaternion rotation, kame::math::Vector3 scale)
 {
-    if (playTime > clip.endTime)
+    Node& node = nodes[nodeID];
+    node.position = position;
+    node.rotation = rotation;
+    node.scale = scale;
+    markDirty(nodeID);
+}
+
+void Model::markDirty(int nodeID)
+{
+    // before the first update() the hierarchy is built from every node anyway
+    if (transforms.size() != nodes.size())
     {
-        playTime = clip.startTime + (clip.endTime - playTime);
+        return;
     }
+    transforms.markDirty(transforms.indices[nodeID]);
+}
 
-    float time = playTime;
-
-    for (auto& c : clip.channels)
+void Model::markAllDirty()
+{
+    for (size_t i = 0; i < nodes.size(); ++i)
     {
-        if (c.targetID < 0)
-        {
-            continue;
-        }
-
-        Node& node = nodes[c.targetID];
-
-        auto& s = clip.samplers[c.samplerID];
-        if (s.inputs.size() > s.outputsVec4.size())
-        {
-            continue;
-        }
-
-        for (size_t i = 0; i < s.outputsVec4.size() - 1; ++i)
-        {
-            if ((time >= s.inputs[i]) && (time <= s.inputs[i + 1]))
-            {
-                float u = std::max(0.0f, time - s.inputs[i]) / (s.inputs[i + 1] - s.inputs[i]);
-                if (u <= 1.0f)
-                {
-                    // TODO: STEP and CUBICSPLINE interp
-                    switch (c.path)
-                    {
-                        case AnimationClip::Channel::PathType::kTRANSLATION: {
-                            auto trans = kame::math::Vector4::lerp(s.outputsVec4[i], s.outputsVec4[i + 1], u);
-                            node.position = kame::math::Vector3(trans.x, trans.y, trans.z);
-                            break;
-                        }
-                        case AnimationClip::Channel::PathType::kSCALE: {
-                            auto scale = kame::math::Vector4::lerp(s.outputsVec4[i], s.outputsVec4[i + 1], u);
-                            node.scale = kame::math::Vector3(scale.x, scale.y, scale.z);
-                            break;
-                        }
-                        case AnimationClip::Channel::PathType::kROTATION: {
-                            auto rot = kame::math::Quaternion::slerp(s.outputsVec4[i], s.outputsVec4[i + 1], u);
-                            node.rotation = kame::math::Quaternion::normalize(rot);
-                            break;
-                        }
-                    }
-                }
-            }
-        }
+        markDirty(int(i));
     }
-
-    return time;
 }
 
 void Model::update(std::vector<kame::math::Vector3>& positions, UpdateCB fn)
 {
-    int i = 0;
-    for (auto& n : nodes)
-    {
-        if (n.parent < 0)
-        {
-            updateGlobalXForm(this, i);
-        }
-        ++i;
-    }
+    updateGlobalXForms(this);
 
     if (isSkinnedMesh())
     {
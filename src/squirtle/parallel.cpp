@@ -0,0 +1,142 @@
+#include <all.hpp>
+
+namespace kame::squirtle {
+
+ThreadPool::ThreadPool(int numThreads)
+{
+    if (numThreads <= 0)
+    {
+        numThreads = std::max(1, int(std::thread::hardware_concurrency()));
+    }
+
+    queues.reserve(numThreads);
+    for (int i = 0; i < numThreads; ++i)
+    {
+        queues.emplace_back(std::make_unique<Queue>());
+    }
+
+    workers.reserve(numThreads - 1);
+    for (int i = 1; i < numThreads; ++i)
+    {
+        workers.emplace_back(&ThreadPool::workerMain, this, size_t(i));
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        isShutdown = true;
+    }
+    wakeCV.notify_all();
+    for (auto& t : workers)
+    {
+        t.join();
+    }
+}
+
+bool ThreadPool::runOne(size_t self)
+{
+    std::pair<size_t, size_t> range;
+    bool found = false;
+
+    {
+        Queue& q = *queues[self];
+        std::lock_guard<std::mutex> lk(q.mutex);
+        if (!q.ranges.empty())
+        {
+            range = q.ranges.front();
+            q.ranges.pop_front();
+            found = true;
+        }
+    }
+
+    // steal from the back of the other queues
+    for (size_t i = 1; !found && i < queues.size(); ++i)
+    {
+        Queue& q = *queues[(self + i) % queues.size()];
+        std::lock_guard<std::mutex> lk(q.mutex);
+        if (!q.ranges.empty())
+        {
+            range = q.ranges.back();
+            q.ranges.pop_back();
+            found = true;
+        }
+    }
+
+    if (!found)
+    {
+        return false;
+    }
+
+    (*job)(range.first, range.second);
+
+    if (pending.fetch_sub(1) == 1)
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        doneCV.notify_all();
+    }
+    return true;
+}
+
+void ThreadPool::workerMain(size_t self)
+{
+    uint64_t seen = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+            wakeCV.wait(lk, [&] { return isShutdown || generation != seen; });
+            if (isShutdown)
+            {
+                return;
+            }
+            seen = generation;
+        }
+
+        while (runOne(self))
+        {
+        }
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& fn)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    grainSize = std::max<size_t>(1, grainSize);
+    if (queues.size() == 1 || count <= grainSize)
+    {
+        fn(0, count);
+        return;
+    }
+
+    size_t numRanges = (count + grainSize - 1) / grainSize;
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+        // job and pending must be visible before any range can be taken
+        job = &fn;
+        pending = numRanges;
+        for (size_t r = 0; r < numRanges; ++r)
+        {
+            Queue& q = *queues[r % queues.size()];
+            std::lock_guard<std::mutex> qlk(q.mutex);
+            q.ranges.emplace_back(r * grainSize, std::min(count, (r + 1) * grainSize));
+        }
+        ++generation;
+    }
+    wakeCV.notify_all();
+
+    while (runOne(0))
+    {
+    }
+
+    std::unique_lock<std::mutex> lk(mutex);
+    doneCV.wait(lk, [&] { return pending == 0; });
+    job = nullptr;
+}
+
+} // namespace kame::squirtle
@@ -0,0 +1,221 @@
+#include <all.hpp>
+
+namespace kame::squirtle {
+
+using kame::math::Quaternion;
+using kame::math::Vector3;
+
+void Pose::resize(size_t numNodes)
+{
+    positions.resize(numNodes, Vector3::zero());
+    rotations.resize(numNodes, Quaternion::identity());
+    scales.resize(numNodes, Vector3::one());
+}
+
+void readPose(const std::vector<Node>& nodes, Pose& pose)
+{
+    pose.resize(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        pose.positions[i] = nodes[i].position;
+        pose.rotations[i] = nodes[i].rotation;
+        pose.scales[i] = nodes[i].scale;
+    }
+}
+
+void applyPose(const Pose& pose, std::vector<Node>& nodes)
+{
+    assert(pose.size() == nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        nodes[i].position = pose.positions[i];
+        nodes[i].rotation = pose.rotations[i];
+        nodes[i].scale = pose.scales[i];
+    }
+}
+
+void applyPose(const Pose& pose, Model& model)
+{
+    assert(pose.size() == model.nodes.size());
+    for (size_t i = 0; i < model.nodes.size(); ++i)
+    {
+        Node& node = model.nodes[i];
+        const Vector3& p = pose.positions[i];
+        const Quaternion& r = pose.rotations[i];
+        const Vector3& s = pose.scales[i];
+        if (p.x != node.position.x || p.y != node.position.y || p.z != node.position.z ||
+            r.x != node.rotation.x || r.y != node.rotation.y || r.z != node.rotation.z || r.w != node.rotation.w ||
+            s.x != node.scale.x || s.y != node.scale.y || s.z != node.scale.z)
+        {
+            model.setLocalTransform(int(i), p, r, s);
+        }
+    }
+}
+
+void blendPose(const Pose& a, const Pose& b, float weight, Pose& out, std::span<const float> mask)
+{
+    assert(a.size() == b.size());
+    assert(mask.empty() || mask.size() == a.size());
+    out.resize(a.size());
+
+    const size_t n = a.size();
+    for (size_t i = 0; i < n; ++i)
+    {
+        float w = mask.empty() ? weight : weight * mask[i];
+        out.positions[i] = a.positions[i] + (b.positions[i] - a.positions[i]) * w;
+        out.scales[i] = a.scales[i] + (b.scales[i] - a.scales[i]) * w;
+
+        // nlerp along the shorter arc, close enough to slerp between poses and much cheaper
+        Quaternion qa = a.rotations[i];
+        Quaternion qb = b.rotations[i];
+        float sign = Quaternion::dot(qa, qb) < 0.0f ? -1.0f : 1.0f;
+        out.rotations[i] = Quaternion::normalize(qa * (1.0f - w) + qb * (w * sign));
+    }
+}
+
+void addPose(const Pose& base, const Pose& pose, const Pose& reference, float weight, Pose& out, std::span<const float> mask)
+{
+    assert(base.size() == pose.size() && base.size() == reference.size());
+    assert(mask.empty() || mask.size() == base.size());
+    out.resize(base.size());
+
+    const size_t n = base.size();
+    for (size_t i = 0; i < n; ++i)
+    {
+        float w = mask.empty() ? weight : weight * mask[i];
+        out.positions[i] = base.positions[i] + (pose.positions[i] - reference.positions[i]) * w;
+        Vector3 s = pose.scales[i] / reference.scales[i];
+        out.scales[i] = base.scales[i] * (Vector3::one() + (s - Vector3::one()) * w);
+
+        // pose = reference * delta, the weighted delta is applied on top of base
+        Quaternion r = reference.rotations[i];
+        Quaternion delta = Quaternion(-r.x, -r.y, -r.z, r.w) * pose.rotations[i];
+        float sign = delta.w < 0.0f ? -1.0f : 1.0f;
+        Quaternion partial = Quaternion::normalize(Quaternion::identity() * (1.0f - w) + delta * (w * sign));
+        out.rotations[i] = Quaternion::normalize(base.rotations[i] * partial);
+    }
+}
+
+namespace {
+
+void advance(Animator::Layer& layer, float dt)
+{
+    const AnimationClip& clip = *layer.clip;
+    layer.time += dt * layer.speed;
+    float duration = clip.endTime - clip.startTime;
+    if (layer.loop && duration > 0.0f)
+    {
+        layer.time = clip.startTime + std::fmod(layer.time - clip.startTime, duration);
+        if (layer.time < clip.startTime)
+        {
+            layer.time += duration;
+        }
+    }
+    else
+    {
+        layer.time = std::clamp(layer.time, clip.startTime, std::max(clip.startTime, clip.endTime));
+    }
+}
+
+} // namespace
+
+void Animator::init(const std::vector<Node>& nodes)
+{
+    readPose(nodes, restPose);
+    pose = restPose;
+    basePose = restPose;
+    fadePose = restPose;
+    layerPose = restPose;
+}
+
+void Animator::play(AnimationClip& clip, float fadeTime, bool loop)
+{
+    fadingOut = Layer();
+    if (base.clip && fadeTime > 0.0f)
+    {
+        fadingOut = std::move(base);
+        fadeDuration = fadeTime;
+        fadeElapsed = 0.0f;
+    }
+    base = Layer();
+    base.clip = &clip;
+    base.time = clip.startTime;
+    base.loop = loop;
+}
+
+size_t Animator::addLayer(AnimationClip& clip, float weight, bool additive, std::vector<float> mask)
+{
+    Layer& layer = layers.emplace_back();
+    layer.clip = &clip;
+    layer.time = clip.startTime;
+    layer.weight = weight;
+    layer.additive = additive;
+    layer.mask = std::move(mask);
+    if (layer.mask.empty())
+    {
+        // only the nodes the clip animates, the rest would be pulled towards the rest pose
+        layer.mask.assign(restPose.size(), 0.0f);
+        for (auto& c : clip.channels)
+        {
+            if (c.targetID >= 0 && size_t(c.targetID) < layer.mask.size())
+            {
+                layer.mask[c.targetID] = 1.0f;
+            }
+        }
+    }
+    if (additive)
+    {
+        layer.reference = restPose;
+        samplePose(clip, clip.startTime, layer.reference);
+    }
+    return layers.size() - 1;
+}
+
+void Animator::update(float dt)
+{
+    basePose = restPose;
+    if (base.clip)
+    {
+        advance(base, dt);
+        samplePose(*base.clip, base.time, basePose);
+    }
+
+    if (fadingOut.clip)
+    {
+        advance(fadingOut, dt);
+        fadeElapsed += dt;
+        float w = fadeDuration > 0.0f ? fadeElapsed / fadeDuration : 1.0f;
+        if (w >= 1.0f)
+        {
+            fadingOut.clip = nullptr;
+        }
+        else
+        {
+            fadePose = restPose;
+            samplePose(*fadingOut.clip, fadingOut.time, fadePose);
+            blendPose(fadePose, basePose, w, basePose);
+        }
+    }
+
+    pose = basePose;
+    for (auto& layer : layers)
+    {
+        if (!layer.clip || layer.weight <= 0.0f)
+        {
+            continue;
+        }
+        advance(layer, dt);
+        layerPose = restPose;
+        samplePose(*layer.clip, layer.time, layerPose);
+        if (layer.additive)
+        {
+            addPose(pose, layerPose, layer.reference, layer.weight, pose, layer.mask);
+        }
+        else
+        {
+            blendPose(pose, layerPose, layer.weight, pose, layer.mask);
+        }
+    }
+}
+
+} // namespace kame::squirtle
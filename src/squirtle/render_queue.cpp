@@ -0,0 +1,155 @@
+#include <all.hpp>
+
+namespace kame::squirtle {
+
+namespace {
+
+constexpr int kDEPTH_SHIFT = 0;
+constexpr int kTEXTURE_SHIFT = kDEPTH_SHIFT + kSORT_KEY_DEPTH_BITS;
+constexpr int kMATERIAL_SHIFT = kTEXTURE_SHIFT + kSORT_KEY_TEXTURE_BITS;
+constexpr int kSHADER_SHIFT = kMATERIAL_SHIFT + kSORT_KEY_MATERIAL_BITS;
+constexpr int kPASS_SHIFT = kSHADER_SHIFT + kSORT_KEY_SHADER_BITS;
+static_assert(kPASS_SHIFT + kSORT_KEY_PASS_BITS == 64);
+
+constexpr uint64_t mask(int bits)
+{
+    return (uint64_t(1) << bits) - 1;
+}
+
+uint32_t getField(uint64_t key, int shift, int bits)
+{
+    return uint32_t((key >> shift) & mask(bits));
+}
+
+} // namespace
+
+uint64_t makeSortKey(uint32_t pass, uint32_t shader, uint32_t material, uint32_t texture, uint32_t depth)
+{
+    return ((pass & mask(kSORT_KEY_PASS_BITS)) << kPASS_SHIFT) |
+           ((shader & mask(kSORT_KEY_SHADER_BITS)) << kSHADER_SHIFT) |
+           ((material & mask(kSORT_KEY_MATERIAL_BITS)) << kMATERIAL_SHIFT) |
+           ((texture & mask(kSORT_KEY_TEXTURE_BITS)) << kTEXTURE_SHIFT) |
+           ((depth & mask(kSORT_KEY_DEPTH_BITS)) << kDEPTH_SHIFT);
+}
+
+uint32_t getSortKeyPass(uint64_t key)
+{
+    return getField(key, kPASS_SHIFT, kSORT_KEY_PASS_BITS);
+}
+
+uint32_t getSortKeyShader(uint64_t key)
+{
+    return getField(key, kSHADER_SHIFT, kSORT_KEY_SHADER_BITS);
+}
+
+uint32_t getSortKeyMaterial(uint64_t key)
+{
+    return getField(key, kMATERIAL_SHIFT, kSORT_KEY_MATERIAL_BITS);
+}
+
+uint32_t getSortKeyTexture(uint64_t key)
+{
+    return getField(key, kTEXTURE_SHIFT, kSORT_KEY_TEXTURE_BITS);
+}
+
+uint32_t getSortKeyDepth(uint64_t key)
+{
+    return getField(key, kDEPTH_SHIFT, kSORT_KEY_DEPTH_BITS);
+}
+
+uint32_t quantizeSortDepth(float depth, float nearZ, float farZ, bool backToFront)
+{
+    assert(farZ > nearZ);
+    float t = std::clamp((depth - nearZ) / (farZ - nearZ), 0.0f, 1.0f);
+    if (backToFront)
+    {
+        t = 1.0f - t;
+    }
+    return uint32_t(t * float(mask(kSORT_KEY_DEPTH_BITS)));
+}
+
+void RenderQueue::sort()
+{
+    const size_t n = packets.size();
+    if (n < 2)
+    {
+        return;
+    }
+
+    // LSD radix sort on bytes, every histogram from one read of the keys
+    std::array<std::array<uint32_t, 256>, 8> histograms = {};
+    for (const auto& p : packets)
+    {
+        for (int b = 0; b < 8; ++b)
+        {
+            ++histograms[b][(p.key >> (8 * b)) & 0xff];
+        }
+    }
+
+    _scratch.resize(n);
+    DrawPacket* src = packets.data();
+    DrawPacket* dst = _scratch.data();
+    for (int b = 0; b < 8; ++b)
+    {
+        auto& h = histograms[b];
+        // every key has the same byte here, e.g. the unused high bits of small ids
+        if (h[(src[0].key >> (8 * b)) & 0xff] == n)
+        {
+            continue;
+        }
+
+        uint32_t offset = 0;
+        for (auto& count : h)
+        {
+            uint32_t c = count;
+            count = offset;
+            offset += c;
+        }
+        for (size_t i = 0; i < n; ++i)
+        {
+            dst[h[(src[i].key >> (8 * b)) & 0xff]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+
+    if (src != packets.data())
+    {
+        packets.swap(_scratch);
+    }
+}
+
+void RenderQueue::submit(const SubmitCB& fn)
+{
+    uint64_t prev = 0;
+    bool isFirst = true;
+    for (const auto& p : packets)
+    {
+        uint32_t changes = 0;
+        if (isFirst || getSortKeyPass(p.key) != getSortKeyPass(prev))
+        {
+            changes |= kRENDER_CHANGE_PASS;
+            ++stats.passChanges;
+        }
+        if (isFirst || getSortKeyShader(p.key) != getSortKeyShader(prev))
+        {
+            changes |= kRENDER_CHANGE_SHADER;
+            ++stats.shaderChanges;
+        }
+        if (isFirst || getSortKeyMaterial(p.key) != getSortKeyMaterial(prev))
+        {
+            changes |= kRENDER_CHANGE_MATERIAL;
+            ++stats.materialChanges;
+        }
+        if (isFirst || getSortKeyTexture(p.key) != getSortKeyTexture(prev))
+        {
+            changes |= kRENDER_CHANGE_TEXTURE;
+            ++stats.textureChanges;
+        }
+        ++stats.draws;
+        fn(p, changes);
+        prev = p.key;
+        isFirst = false;
+    }
+}
+
+} // namespace kame::squirtle
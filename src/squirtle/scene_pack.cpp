@@ -0,0 +1,83 @@
+#include <all.hpp>
+
+namespace kame::squirtle {
+
+ScenePack packScene(const Model& model)
+{
+    ScenePack pack;
+
+    // vertex and index ranges of every packed primitive, per mesh so instanced meshes are stored once
+    struct Range {
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+        int32_t baseVertex = -1;
+    };
+    std::vector<std::vector<Range>> ranges(model.meshes.size());
+
+    for (size_t id = 0; id < model.nodes.size(); ++id)
+    {
+        const Node& n = model.nodes[id];
+        if (n.meshID < 0)
+        {
+            continue;
+        }
+        const Mesh& mesh = model.meshes[n.meshID];
+        if (n.skinID >= 0)
+        {
+            pack.numSkipped += mesh.primitives.size();
+            continue;
+        }
+
+        auto& meshRanges = ranges[n.meshID];
+        meshRanges.resize(mesh.primitives.size());
+        for (size_t k = 0; k < mesh.primitives.size(); ++k)
+        {
+            const Primitive& pri = mesh.primitives[k];
+            const auto& positions = pri.getPositions();
+            const auto& indices = pri.getIndices();
+            if (pri.mode != GL_TRIANGLES || positions.empty() || indices.empty())
+            {
+                ++pack.numSkipped;
+                continue;
+            }
+
+            // a texture sampled at zero texcoords would draw one texel, leave such primitives unpacked
+            const bool isTextured = pri.material >= 0 && model.materials[pri.material].baseColorTextureIndex >= 0;
+            const int uvSet = isTextured ? model.materials[pri.material].baseColorTexCoord : 0;
+            const auto& uvSets = pri.getUvSets();
+            const bool hasUVs = uvSet >= 0 && size_t(uvSet) < uvSets.size() && uvSets[uvSet].size() == positions.size();
+            if (isTextured && !hasUVs)
+            {
+                ++pack.numSkipped;
+                continue;
+            }
+
+            Range& range = meshRanges[k];
+            if (range.baseVertex < 0)
+            {
+                range.firstIndex = uint32_t(pack.indices.size());
+                range.indexCount = uint32_t(indices.size());
+                range.baseVertex = int32_t(pack.positions.size());
+                pack.positions.insert(pack.positions.end(), positions.begin(), positions.end());
+                pack.indices.insert(pack.indices.end(), indices.begin(), indices.end());
+                if (hasUVs)
+                {
+                    pack.uvs.insert(pack.uvs.end(), uvSets[uvSet].begin(), uvSets[uvSet].end());
+                }
+                else
+                {
+                    pack.uvs.resize(pack.positions.size(), kame::math::Vector2::zero());
+                }
+            }
+
+            pack.draws.push_back({range.firstIndex, range.indexCount, range.baseVertex, int(id), int(k), pri.material});
+        }
+    }
+
+    std::stable_sort(pack.draws.begin(), pack.draws.end(), [](const ScenePack::Draw& a, const ScenePack::Draw& b) {
+        return a.material < b.material;
+    });
+    return pack;
+}
+
+} // namespace kame::squirtle
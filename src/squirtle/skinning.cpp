@@ -0,0 +1,366 @@
+#include <all.hpp>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define KAME_SKINNING_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define KAME_TARGET(x)
+#else
+#define KAME_TARGET(x) __attribute__((target(x)))
+#endif
+#endif
+
+namespace kame::squirtle {
+
+using kame::math::Matrix;
+using kame::math::Vector3;
+
+JointMatrix3x4 toJointMatrix3x4(const Matrix& m)
+{
+    // clang-format off
+    return {{{m.m11, m.m21, m.m31, m.m41},
+             {m.m12, m.m22, m.m32, m.m42},
+             {m.m13, m.m23, m.m33, m.m43}}};
+    // clang-format on
+}
+
+JointDualQuaternion toJointDualQuaternion(const Matrix& m)
+{
+    // rotation of the scale free rows, same decomposition as importModel()
+    float s1 = 1.0f / std::sqrt(m.m11 * m.m11 + m.m12 * m.m12 + m.m13 * m.m13);
+    float s2 = 1.0f / std::sqrt(m.m21 * m.m21 + m.m22 * m.m22 + m.m23 * m.m23);
+    float s3 = 1.0f / std::sqrt(m.m31 * m.m31 + m.m32 * m.m32 + m.m33 * m.m33);
+    float r11 = m.m11 * s1, r12 = m.m12 * s1, r13 = m.m13 * s1;
+    float r21 = m.m21 * s2, r22 = m.m22 * s2, r23 = m.m23 * s2;
+    float r31 = m.m31 * s3, r32 = m.m32 * s3, r33 = m.m33 * s3;
+
+    float x, y, z, w;
+    float trace = r11 + r22 + r33;
+    if (trace > 0.0f)
+    {
+        float S = std::sqrt(trace + 1.0f) * 2.0f;
+        w = 0.25f * S;
+        x = (r23 - r32) / S;
+        y = (r31 - r13) / S;
+        z = (r12 - r21) / S;
+    }
+    else if (r11 > r22 && r11 > r33)
+    {
+        float S = std::sqrt(1.0f + r11 - r22 - r33) * 2.0f;
+        w = (r23 - r32) / S;
+        x = 0.25f * S;
+        y = (r12 + r21) / S;
+        z = (r31 + r13) / S;
+    }
+    else if (r22 > r33)
+    {
+        float S = std::sqrt(1.0f + r22 - r11 - r33) * 2.0f;
+        w = (r31 - r13) / S;
+        x = (r12 + r21) / S;
+        y = 0.25f * S;
+        z = (r23 + r32) / S;
+    }
+    else
+    {
+        float S = std::sqrt(1.0f + r33 - r11 - r22) * 2.0f;
+        w = (r12 - r21) / S;
+        x = (r31 + r13) / S;
+        y = (r23 + r32) / S;
+        z = 0.25f * S;
+    }
+
+    // dual = 0.5 * (t, 0) * real
+    float tx = m.m41, ty = m.m42, tz = m.m43;
+    JointDualQuaternion dq;
+    dq.real[0] = x;
+    dq.real[1] = y;
+    dq.real[2] = z;
+    dq.real[3] = w;
+    dq.dual[0] = 0.5f * (tx * w + ty * z - tz * y);
+    dq.dual[1] = 0.5f * (ty * w + tz * x - tx * z);
+    dq.dual[2] = 0.5f * (tz * w + tx * y - ty * x);
+    dq.dual[3] = -0.5f * (tx * x + ty * y + tz * z);
+    return dq;
+}
+
+namespace {
+
+// normalizes the blended dual quaternion and moves p with it
+inline Vector3 transformDualQuaternion(const float* real, const float* dual, Vector3 p)
+{
+    float invLen = 1.0f / std::sqrt(real[0] * real[0] + real[1] * real[1] + real[2] * real[2] + real[3] * real[3]);
+    Vector3 r(real[0] * invLen, real[1] * invLen, real[2] * invLen);
+    float rw = real[3] * invLen;
+    Vector3 d(dual[0] * invLen, dual[1] * invLen, dual[2] * invLen);
+    float dw = dual[3] * invLen;
+
+    Vector3 rotated = p + Vector3::cross(r, Vector3::cross(r, p) + p * rw) * 2.0f;
+    Vector3 translation = (d * rw - r * dw + Vector3::cross(r, d)) * 2.0f;
+    return rotated + translation;
+}
+
+#ifndef KAME_SKINNING_X86
+
+void skinLinearBlendScalar(const SkinnedVertices& v, const JointMatrix3x4* joints, size_t begin, size_t end, Vector3* out)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        const auto& j = v.joints[i];
+        const float w[4] = {v.weights[i].x, v.weights[i].y, v.weights[i].z, v.weights[i].w};
+        const float p[4] = {v.positions[i].x, v.positions[i].y, v.positions[i].z, 1.0f};
+        float r[3] = {};
+        for (int k = 0; k < 3; ++k)
+        {
+            for (int n = 0; n < 4; ++n)
+            {
+                const float* c = joints[j[n]].c[k];
+                r[k] += w[n] * (c[0] * p[0] + c[1] * p[1] + c[2] * p[2] + c[3]);
+            }
+        }
+        out[i] = Vector3(r[0], r[1], r[2]);
+    }
+}
+
+void skinDualQuaternionScalar(const SkinnedVertices& v, const JointDualQuaternion* joints, size_t begin, size_t end, Vector3* out)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        const auto& j = v.joints[i];
+        const float w[4] = {v.weights[i].x, v.weights[i].y, v.weights[i].z, v.weights[i].w};
+        const float* pivot = joints[j[0]].real;
+
+        float r[4] = {};
+        float d[4] = {};
+        for (int n = 0; n < 4; ++n)
+        {
+            const JointDualQuaternion& q = joints[j[n]];
+            float dot = q.real[0] * pivot[0] + q.real[1] * pivot[1] + q.real[2] * pivot[2] + q.real[3] * pivot[3];
+            float wn = dot < 0.0f ? -w[n] : w[n];
+            for (int c = 0; c < 4; ++c)
+            {
+                r[c] += wn * q.real[c];
+                d[c] += wn * q.dual[c];
+            }
+        }
+        out[i] = transformDualQuaternion(r, d, v.positions[i]);
+    }
+}
+
+#else
+
+// (dot(r0, 1), dot(r1, 1), dot(r2, 1), 0) of already multiplied columns
+inline __m128 sumColumns(__m128 r0, __m128 r1, __m128 r2)
+{
+    __m128 zero = _mm_setzero_ps();
+    __m128 s = _mm_add_ps(_mm_unpacklo_ps(r0, r1), _mm_unpackhi_ps(r0, r1));
+    __m128 u = _mm_add_ps(_mm_unpacklo_ps(r2, zero), _mm_unpackhi_ps(r2, zero));
+    return _mm_add_ps(_mm_movelh_ps(s, u), _mm_movehl_ps(u, s));
+}
+
+inline void storeVector3(Vector3* dst, __m128 v)
+{
+    alignas(16) float tmp[4];
+    _mm_store_ps(tmp, v);
+    *dst = Vector3(tmp[0], tmp[1], tmp[2]);
+}
+
+void skinLinearBlendSSE(const SkinnedVertices& v, const JointMatrix3x4* joints, size_t begin, size_t end, Vector3* out)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        const auto& j = v.joints[i];
+        __m128 w = _mm_loadu_ps(&v.weights[i].x);
+        __m128 w0 = _mm_shuffle_ps(w, w, _MM_SHUFFLE(0, 0, 0, 0));
+        __m128 w1 = _mm_shuffle_ps(w, w, _MM_SHUFFLE(1, 1, 1, 1));
+        __m128 w2 = _mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 2, 2));
+        __m128 w3 = _mm_shuffle_ps(w, w, _MM_SHUFFLE(3, 3, 3, 3));
+        const JointMatrix3x4& a = joints[j[0]];
+        const JointMatrix3x4& b = joints[j[1]];
+        const JointMatrix3x4& c = joints[j[2]];
+        const JointMatrix3x4& d = joints[j[3]];
+
+        __m128 col[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            col[k] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(w0, _mm_load_ps(a.c[k])), _mm_mul_ps(w1, _mm_load_ps(b.c[k]))),
+                                _mm_add_ps(_mm_mul_ps(w2, _mm_load_ps(c.c[k])), _mm_mul_ps(w3, _mm_load_ps(d.c[k]))));
+        }
+        __m128 p = _mm_setr_ps(v.positions[i].x, v.positions[i].y, v.positions[i].z, 1.0f);
+        storeVector3(out + i, sumColumns(_mm_mul_ps(col[0], p), _mm_mul_ps(col[1], p), _mm_mul_ps(col[2], p)));
+    }
+}
+
+// two vertices per iteration, one in each 128 bit lane
+KAME_TARGET("avx2,fma")
+size_t skinLinearBlendAVX2(const SkinnedVertices& v, const JointMatrix3x4* joints, size_t begin, size_t end, Vector3* out)
+{
+    size_t i = begin;
+    for (; i + 2 <= end; i += 2)
+    {
+        const auto& ja = v.joints[i];
+        const auto& jb = v.joints[i + 1];
+        __m256 w = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&v.weights[i].x)), _mm_loadu_ps(&v.weights[i + 1].x), 1);
+
+        __m256 col[3];
+        for (int k = 0; k < 3; ++k)
+        {
+            col[k] = _mm256_setzero_ps();
+        }
+        for (int n = 0; n < 4; ++n)
+        {
+            __m256 wn = _mm256_permutevar_ps(w, _mm256_set1_epi32(n));
+            const JointMatrix3x4& a = joints[ja[n]];
+            const JointMatrix3x4& b = joints[jb[n]];
+            for (int k = 0; k < 3; ++k)
+            {
+                __m256 c = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_load_ps(a.c[k])), _mm_load_ps(b.c[k]), 1);
+                col[k] = _mm256_fmadd_ps(wn, c, col[k]);
+            }
+        }
+
+        __m256 p = _mm256_setr_ps(v.positions[i].x, v.positions[i].y, v.positions[i].z, 1.0f,
+                                  v.positions[i + 1].x, v.positions[i + 1].y, v.positions[i + 1].z, 1.0f);
+        __m256 r0 = _mm256_mul_ps(col[0], p);
+        __m256 r1 = _mm256_mul_ps(col[1], p);
+        __m256 r2 = _mm256_mul_ps(col[2], p);
+        __m256 zero = _mm256_setzero_ps();
+        __m256 s = _mm256_add_ps(_mm256_unpacklo_ps(r0, r1), _mm256_unpackhi_ps(r0, r1));
+        __m256 u = _mm256_add_ps(_mm256_unpacklo_ps(r2, zero), _mm256_unpackhi_ps(r2, zero));
+        __m256 sum = _mm256_add_ps(_mm256_shuffle_ps(s, u, _MM_SHUFFLE(1, 0, 1, 0)), _mm256_shuffle_ps(s, u, _MM_SHUFFLE(3, 2, 3, 2)));
+
+        alignas(32) float tmp[8];
+        _mm256_store_ps(tmp, sum);
+        out[i] = Vector3(tmp[0], tmp[1], tmp[2]);
+        out[i + 1] = Vector3(tmp[4], tmp[5], tmp[6]);
+    }
+    return i;
+}
+
+void skinDualQuaternionSSE(const SkinnedVertices& v, const JointDualQuaternion* joints, size_t begin, size_t end, Vector3* out)
+{
+    for (size_t i = begin; i < end; ++i)
+    {
+        const auto& j = v.joints[i];
+        const float w[4] = {v.weights[i].x, v.weights[i].y, v.weights[i].z, v.weights[i].w};
+        const __m128 pivot = _mm_load_ps(joints[j[0]].real);
+        const __m128 signMask = _mm_set1_ps(-0.0f);
+
+        __m128 real = _mm_setzero_ps();
+        __m128 dual = _mm_setzero_ps();
+        for (int n = 0; n < 4; ++n)
+        {
+            const JointDualQuaternion& q = joints[j[n]];
+            __m128 qr = _mm_load_ps(q.real);
+            // q and -q are the same rotation, blend along the shorter arc without branching
+            __m128 dot = _mm_mul_ps(qr, pivot);
+            dot = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, _MM_SHUFFLE(2, 3, 0, 1)));
+            dot = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, _MM_SHUFFLE(1, 0, 3, 2)));
+            __m128 wn = _mm_xor_ps(_mm_set1_ps(w[n]), _mm_and_ps(dot, signMask));
+            real = _mm_add_ps(real, _mm_mul_ps(wn, qr));
+            dual = _mm_add_ps(dual, _mm_mul_ps(wn, _mm_load_ps(q.dual)));
+        }
+
+        alignas(16) float r[4];
+        alignas(16) float d[4];
+        _mm_store_ps(r, real);
+        _mm_store_ps(d, dual);
+        out[i] = transformDualQuaternion(r, d, v.positions[i]);
+    }
+}
+
+bool hasAVX2FMA()
+{
+    static const bool supported = [] {
+#if defined(_MSC_VER) && !defined(__clang__)
+        int info[4];
+        __cpuid(info, 0);
+        if (info[0] < 7)
+        {
+            return false;
+        }
+        __cpuid(info, 1);
+        bool fma = (info[2] & (1 << 12)) != 0;
+        bool ymm = (info[2] & (1 << 27)) != 0 && (_xgetbv(0) & 0x6) == 0x6;
+        __cpuidex(info, 7, 0);
+        return fma && ymm && (info[1] & (1 << 5)) != 0;
+#else
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#endif
+    }();
+    return supported;
+}
+
+#endif
+
+} // namespace
+
+void skinLinearBlend(const SkinnedVertices& vertices, const JointMatrix3x4* joints, size_t begin, size_t end, Vector3* out)
+{
+#ifdef KAME_SKINNING_X86
+    if (hasAVX2FMA())
+    {
+        begin = skinLinearBlendAVX2(vertices, joints, begin, end, out);
+    }
+    skinLinearBlendSSE(vertices, joints, begin, end, out);
+#else
+    skinLinearBlendScalar(vertices, joints, begin, end, out);
+#endif
+}
+
+void skinDualQuaternion(const SkinnedVertices& vertices, const JointDualQuaternion* joints, size_t begin, size_t end, Vector3* out)
+{
+#ifdef KAME_SKINNING_X86
+    skinDualQuaternionSSE(vertices, joints, begin, end, out);
+#else
+    skinDualQuaternionScalar(vertices, joints, begin, end, out);
+#endif
+}
+
+void Skinner::setJoints(std::span<const Matrix> jointMatrices)
+{
+    if (method == kSKINNING_METHOD_DUAL_QUATERNION)
+    {
+        dualQuaternions.resize(jointMatrices.size());
+        for (size_t i = 0; i < jointMatrices.size(); ++i)
+        {
+            dualQuaternions[i] = toJointDualQuaternion(jointMatrices[i]);
+        }
+    }
+    else
+    {
+        matrices.resize(jointMatrices.size());
+        for (size_t i = 0; i < jointMatrices.size(); ++i)
+        {
+            matrices[i] = toJointMatrix3x4(jointMatrices[i]);
+        }
+    }
+}
+
+void Skinner::skin(const SkinnedVertices& vertices, Vector3* out)
+{
+    auto job = [&](size_t begin, size_t end) {
+        if (method == kSKINNING_METHOD_DUAL_QUATERNION)
+        {
+            skinDualQuaternion(vertices, dualQuaternions.data(), begin, end, out);
+        }
+        else
+        {
+            skinLinearBlend(vertices, matrices.data(), begin, end, out);
+        }
+    };
+
+    if (numThreads == 1 || vertices.numVertices <= grainSize)
+    {
+        job(0, vertices.numVertices);
+        return;
+    }
+    if (!pool)
+    {
+        pool = std::make_unique<ThreadPool>(numThreads);
+    }
+    pool->parallelFor(vertices.numVertices, grainSize, job);
+}
+
+} // namespace kame::squirtle
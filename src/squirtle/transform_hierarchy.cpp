@@ -0,0 +1,185 @@
+#include <all.hpp>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define KAME_SQUIRTLE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace kame::squirtle {
+
+using kame::math::Matrix;
+using kame::math::Quaternion;
+using kame::math::Vector3;
+
+Affine3x4 Affine3x4::identity()
+{
+    return {{{1.0f, 0.0f, 0.0f, 0.0f},
+             {0.0f, 1.0f, 0.0f, 0.0f},
+             {0.0f, 0.0f, 1.0f, 0.0f}}};
+}
+
+Affine3x4 Affine3x4::fromMatrix(const Matrix& m)
+{
+    return {{{m.m11, m.m21, m.m31, m.m41},
+             {m.m12, m.m22, m.m32, m.m42},
+             {m.m13, m.m23, m.m33, m.m43}}};
+}
+
+Matrix Affine3x4::toMatrix() const
+{
+    return {c[0][0], c[1][0], c[2][0], 0.0f,
+            c[0][1], c[1][1], c[2][1], 0.0f,
+            c[0][2], c[1][2], c[2][2], 0.0f,
+            c[0][3], c[1][3], c[2][3], 1.0f};
+}
+
+Affine3x4 Affine3x4::compose(Vector3 t, Quaternion r, Vector3 s)
+{
+    // rows of the rotation are the rotated axes, the general form matches Vector3::transform() for any length
+    float xx = r.x * r.x, yy = r.y * r.y, zz = r.z * r.z, ww = r.w * r.w;
+    float xy = r.x * r.y, xz = r.x * r.z, yz = r.y * r.z;
+    float wx = r.w * r.x, wy = r.w * r.y, wz = r.w * r.z;
+
+    // row i of S * R is the rotation row scaled by s[i], the translation row is t
+    return {{{s.x * (ww + xx - yy - zz), s.y * 2.0f * (xy - wz), s.z * 2.0f * (xz + wy), t.x},
+             {s.x * 2.0f * (xy + wz), s.y * (ww - xx + yy - zz), s.z * 2.0f * (yz - wx), t.y},
+             {s.x * 2.0f * (xz - wy), s.y * 2.0f * (yz + wx), s.z * (ww - xx - yy + zz), t.z}}};
+}
+
+Affine3x4 Affine3x4::multiply(const Affine3x4& a, const Affine3x4& b)
+{
+    // (a * b)[i][j] = sum_k a[i][k] * b[k][j], column j of the product is a's columns weighted by b's column j
+    Affine3x4 out;
+#ifdef KAME_SQUIRTLE_SSE2
+    const __m128 a0 = _mm_load_ps(a.c[0]);
+    const __m128 a1 = _mm_load_ps(a.c[1]);
+    const __m128 a2 = _mm_load_ps(a.c[2]);
+    const __m128 a3 = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+    for (int j = 0; j < 3; ++j)
+    {
+        __m128 bj = _mm_load_ps(b.c[j]);
+        __m128 r = _mm_mul_ps(a0, _mm_shuffle_ps(bj, bj, _MM_SHUFFLE(0, 0, 0, 0)));
+        r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_shuffle_ps(bj, bj, _MM_SHUFFLE(1, 1, 1, 1))));
+        r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_shuffle_ps(bj, bj, _MM_SHUFFLE(2, 2, 2, 2))));
+        r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_shuffle_ps(bj, bj, _MM_SHUFFLE(3, 3, 3, 3))));
+        _mm_store_ps(out.c[j], r);
+    }
+#else
+    for (int j = 0; j < 3; ++j)
+    {
+        for (int i = 0; i < 4; ++i)
+        {
+            out.c[j][i] = a.c[0][i] * b.c[j][0] + a.c[1][i] * b.c[j][1] + a.c[2][i] * b.c[j][2] + (i == 3 ? b.c[j][3] : 0.0f);
+        }
+    }
+#endif
+    return out;
+}
+
+void TransformHierarchy::build(const std::vector<Node>& nodes)
+{
+    const size_t n = nodes.size();
+    nodeIDs.clear();
+    nodeIDs.reserve(n);
+    indices.assign(n, 0);
+    parents.assign(n, -1);
+    subtreeEnds.assign(n, 0);
+
+    // depth first from every root, an explicit stack keeps deep chains off the call stack
+    std::vector<std::pair<int, int>> stack; // node id, parent hierarchy index
+    for (size_t r = 0; r < n; ++r)
+    {
+        if (nodes[r].parent >= 0)
+        {
+            continue;
+        }
+        stack.emplace_back(int(r), -1);
+        while (!stack.empty())
+        {
+            auto [id, parent] = stack.back();
+            stack.pop_back();
+            uint32_t index = uint32_t(nodeIDs.size());
+            nodeIDs.emplace_back(id);
+            indices[id] = index;
+            parents[index] = nodes[id].skinID < 0 ? parent : -1;
+            const auto& children = nodes[id].children;
+            for (auto it = children.rbegin(); it != children.rend(); ++it)
+            {
+                stack.emplace_back(*it, int(index));
+            }
+        }
+    }
+    assert(nodeIDs.size() == n);
+
+    // descendants follow their ancestor, so a backward pass knows every subtree's end
+    for (size_t i = n; i-- > 0;)
+    {
+        subtreeEnds[i] = std::max(subtreeEnds[i], uint32_t(i + 1));
+        int parent = nodes[nodeIDs[i]].parent;
+        if (parent >= 0)
+        {
+            uint32_t p = indices[parent];
+            subtreeEnds[p] = std::max(subtreeEnds[p], subtreeEnds[i]);
+        }
+    }
+
+    positions.resize(n);
+    rotations.resize(n);
+    scales.resize(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        const Node& node = nodes[nodeIDs[i]];
+        positions[i] = node.position;
+        rotations[i] = node.rotation;
+        scales[i] = node.scale;
+    }
+    locals.assign(n, Affine3x4::identity());
+    worlds.assign(n, Affine3x4::identity());
+    dirty.assign(n, 1);
+    changed.assign(n, 0);
+    dirtyBegin = 0;
+    dirtyEnd = uint32_t(n);
+    updatedBegin = 0;
+    updatedEnd = 0;
+}
+
+void TransformHierarchy::setLocal(int nodeID, Vector3 position, Quaternion rotation, Vector3 scale)
+{
+    uint32_t i = indices[nodeID];
+    positions[i] = position;
+    rotations[i] = rotation;
+    scales[i] = scale;
+    markDirty(i);
+}
+
+size_t TransformHierarchy::update()
+{
+    std::fill(changed.begin() + updatedBegin, changed.begin() + updatedEnd, uint8_t(0));
+    updatedBegin = dirtyBegin;
+    updatedEnd = std::max(dirtyBegin, dirtyEnd);
+
+    // nothing before dirtyBegin moved, so parents outside the range read as unchanged
+    size_t numUpdated = 0;
+    for (uint32_t i = updatedBegin; i < updatedEnd; ++i)
+    {
+        const int parent = parents[i];
+        if (!dirty[i] && (parent < 0 || !changed[parent]))
+        {
+            continue;
+        }
+        if (dirty[i])
+        {
+            locals[i] = Affine3x4::compose(positions[i], rotations[i], scales[i]);
+            dirty[i] = 0;
+        }
+        worlds[i] = parent >= 0 ? Affine3x4::multiply(locals[i], worlds[parent]) : locals[i];
+        changed[i] = 1;
+        ++numUpdated;
+    }
+
+    dirtyBegin = uint32_t(size());
+    dirtyEnd = 0;
+    return numUpdated;
+}
+
+} // namespace kame::squirtle
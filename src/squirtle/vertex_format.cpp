@@ -0,0 +1,252 @@
+#include <all.hpp>
+
+namespace kame::squirtle {
+
+uint16_t packHalf(float v)
+{
+    uint32_t x;
+    std::memcpy(&x, &v, sizeof(x));
+
+    uint32_t sign = (x >> 16) & 0x8000;
+    uint32_t absx = x & 0x7fffffff;
+
+    // NaN, Inf and overflow
+    if (absx >= 0x47800000)
+    {
+        return uint16_t(sign | (absx > 0x7f800000 ? 0x7e00 : 0x7c00));
+    }
+    // subnormal or zero, rounded to nearest even
+    if (absx < 0x38800000)
+    {
+        uint32_t shift = 126 - (absx >> 23);
+        if (shift > 25)
+        {
+            return uint16_t(sign);
+        }
+        uint32_t mant = (absx & 0x7fffff) | 0x800000;
+        uint32_t h = mant >> shift;
+        uint32_t rest = mant & ((1u << shift) - 1);
+        uint32_t half = 1u << (shift - 1);
+        if (rest > half || (rest == half && (h & 1)))
+        {
+            ++h;
+        }
+        return uint16_t(sign | h);
+    }
+    // normal, rounded to nearest even. a carry into the exponent is still correct
+    uint32_t h = ((absx - 0x38000000) >> 13);
+    uint32_t rest = absx & 0x1fff;
+    if (rest > 0x1000 || (rest == 0x1000 && (h & 1)))
+    {
+        ++h;
+    }
+    return uint16_t(sign | h);
+}
+
+float unpackHalf(uint16_t h)
+{
+    uint32_t sign = uint32_t(h & 0x8000) << 16;
+    uint32_t exp = (h >> 10) & 0x1f;
+    uint32_t mant = h & 0x3ff;
+    uint32_t x;
+    if (exp == 0x1f)
+    {
+        x = sign | 0x7f800000 | (mant << 13);
+    }
+    else if (exp != 0)
+    {
+        x = sign | ((exp + 112) << 23) | (mant << 13);
+    }
+    else if (mant == 0)
+    {
+        x = sign;
+    }
+    else
+    {
+        // renormalize subnormals
+        exp = 113;
+        while ((mant & 0x400) == 0)
+        {
+            mant <<= 1;
+            --exp;
+        }
+        x = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+    }
+    float v;
+    std::memcpy(&v, &x, sizeof(v));
+    return v;
+}
+
+static int16_t toSnorm16(float v)
+{
+    return int16_t(std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f));
+}
+
+static int8_t toSnorm8(float v)
+{
+    return int8_t(std::lround(std::clamp(v, -1.0f, 1.0f) * 127.0f));
+}
+
+std::array<int16_t, 2> packOctahedral(const kame::math::Vector3& n)
+{
+    float l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+    if (l1 == 0.0f)
+    {
+        return {0, 0};
+    }
+    float x = n.x / l1;
+    float y = n.y / l1;
+    if (n.z < 0.0f)
+    {
+        float ox = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float oy = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = ox;
+        y = oy;
+    }
+    return {toSnorm16(x), toSnorm16(y)};
+}
+
+kame::math::Vector3 unpackOctahedral(const std::array<int16_t, 2>& e)
+{
+    float x = std::max(e[0] / 32767.0f, -1.0f);
+    float y = std::max(e[1] / 32767.0f, -1.0f);
+    float z = 1.0f - std::abs(x) - std::abs(y);
+    if (z < 0.0f)
+    {
+        float ox = (1.0f - std::abs(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+        float oy = (1.0f - std::abs(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+        x = ox;
+        y = oy;
+    }
+    return kame::math::Vector3::normalize(kame::math::Vector3(x, y, z));
+}
+
+// rounds to unorm8 keeping the sum at 255 when the weights sum to 1
+static std::array<uint8_t, 4> toUnorm8Weights(const kame::math::Vector4& w)
+{
+    float f[4] = {w.x, w.y, w.z, w.w};
+    std::array<uint8_t, 4> q;
+    int sum = 0;
+    int largest = 0;
+    for (int i = 0; i < 4; ++i)
+    {
+        q[i] = uint8_t(std::lround(std::clamp(f[i], 0.0f, 1.0f) * 255.0f));
+        sum += q[i];
+        if (f[i] > f[largest])
+        {
+            largest = i;
+        }
+    }
+    if (sum > 0 && std::abs(f[0] + f[1] + f[2] + f[3] - 1.0f) < 1e-3f)
+    {
+        q[largest] = uint8_t(std::clamp(q[largest] + 255 - sum, 0, 255));
+    }
+    return q;
+}
+
+PackedVertices packVertices(const Primitive& primitive, uint32_t attributes)
+{
+    PackedVertices packed;
+    packed.numVertices = primitive.positions.size();
+
+    auto add = [&](VertexAttribute a, bool available, GLuint componentSize, GLenum type, GLboolean normalized, uint32_t size) {
+        if ((attributes & vertexAttributeBit(a)) == 0 || !available)
+        {
+            return;
+        }
+        packed.attributes |= vertexAttributeBit(a);
+        packed.layout[a] = PackedAttribute{componentSize, type, normalized, packed.stride};
+        packed.stride += size;
+    };
+
+    bool wideJoints = false;
+    for (const auto& j : primitive.joints)
+    {
+        wideJoints |= j[0] > 255 || j[1] > 255 || j[2] > 255 || j[3] > 255;
+    }
+
+    // every attribute size is a multiple of 4, keeping all of them aligned
+    const size_t n = packed.numVertices;
+    add(kVERTEX_ATTRIBUTE_POSITION, true, 3, GL_FLOAT, GL_FALSE, 12);
+    add(kVERTEX_ATTRIBUTE_NORMAL, primitive.normals.size() == n, 2, GL_SHORT, GL_TRUE, 4);
+    add(kVERTEX_ATTRIBUTE_TANGENT, primitive.tangents.size() == n, 4, GL_BYTE, GL_TRUE, 4);
+    add(kVERTEX_ATTRIBUTE_UV0, primitive.uvSets.size() > 0 && primitive.uvSets[0].size() == n, 2, GL_HALF_FLOAT, GL_FALSE, 4);
+    add(kVERTEX_ATTRIBUTE_UV1, primitive.uvSets.size() > 1 && primitive.uvSets[1].size() == n, 2, GL_HALF_FLOAT, GL_FALSE, 4);
+    add(kVERTEX_ATTRIBUTE_JOINTS, primitive.joints.size() == n, 4, wideJoints ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE, GL_FALSE, wideJoints ? 8 : 4);
+    add(kVERTEX_ATTRIBUTE_WEIGHTS, primitive.weights.size() == n, 4, GL_UNSIGNED_BYTE, GL_TRUE, 4);
+    packed.layout[kVERTEX_ATTRIBUTE_JOINTS].isInteger = true;
+
+    packed.data.resize(packed.stride * n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint8_t* v = packed.data.data() + i * packed.stride;
+        if (packed.hasAttribute(kVERTEX_ATTRIBUTE_POSITION))
+        {
+            std::memcpy(v + packed.layout[kVERTEX_ATTRIBUTE_POSITION].offset, &primitive.positions[i], 12);
+        }
+        if (packed.hasAttribute(kVERTEX_ATTRIBUTE_NORMAL))
+        {
+            auto e = packOctahedral(primitive.normals[i]);
+            std::memcpy(v + packed.layout[kVERTEX_ATTRIBUTE_NORMAL].offset, e.data(), 4);
+        }
+        if (packed.hasAttribute(kVERTEX_ATTRIBUTE_TANGENT))
+        {
+            const auto& t = primitive.tangents[i];
+            int8_t e[4] = {toSnorm8(t.x), toSnorm8(t.y), toSnorm8(t.z), int8_t(t.w < 0.0f ? -127 : 127)};
+            std::memcpy(v + packed.layout[kVERTEX_ATTRIBUTE_TANGENT].offset, e, 4);
+        }
+        for (int set = 0; set < 2; ++set)
+        {
+            VertexAttribute a = set == 0 ? kVERTEX_ATTRIBUTE_UV0 : kVERTEX_ATTRIBUTE_UV1;
+            if (packed.hasAttribute(a))
+            {
+                const auto& uv = primitive.uvSets[set][i];
+                uint16_t e[2] = {packHalf(uv.x), packHalf(uv.y)};
+                std::memcpy(v + packed.layout[a].offset, e, 4);
+            }
+        }
+        if (packed.hasAttribute(kVERTEX_ATTRIBUTE_JOINTS))
+        {
+            const auto& j = primitive.joints[i];
+            if (wideJoints)
+            {
+                std::memcpy(v + packed.layout[kVERTEX_ATTRIBUTE_JOINTS].offset, j.data(), 8);
+            }
+            else
+            {
+                uint8_t e[4] = {uint8_t(j[0]), uint8_t(j[1]), uint8_t(j[2]), uint8_t(j[3])};
+                std::memcpy(v + packed.layout[kVERTEX_ATTRIBUTE_JOINTS].offset, e, 4);
+            }
+        }
+        if (packed.hasAttribute(kVERTEX_ATTRIBUTE_WEIGHTS))
+        {
+            auto e = toUnorm8Weights(primitive.weights[i]);
+            std::memcpy(v + packed.layout[kVERTEX_ATTRIBUTE_WEIGHTS].offset, e.data(), 4);
+        }
+    }
+
+    return packed;
+}
+
+kame::ogl::VertexArrayObject& bindPackedVertices(kame::ogl::VertexArrayObject& vao, const kame::ogl::VertexBuffer* vbo, const PackedVertices& packed, const std::array<GLint, kVERTEX_ATTRIBUTE_COUNT>& locations)
+{
+    for (int a = 0; a < kVERTEX_ATTRIBUTE_COUNT; ++a)
+    {
+        if (!packed.hasAttribute(VertexAttribute(a)) || locations[a] < 0)
+        {
+            continue;
+        }
+        const PackedAttribute& attr = packed.layout[a];
+        if (attr.isInteger)
+        {
+            vao.bindIntegerAttribute(vbo, locations[a], attr.componentSize, attr.type, packed.stride, attr.offset);
+        }
+        else
+        {
+            vao.bindAttribute(vbo, locations[a], attr.componentSize, attr.type, attr.normalized, packed.stride, attr.offset);
+        }
+    }
+    return vao;
+}
+
+} // namespace kame::squirtle
@@ -125,6 +125,61 @@ TEST(Matrix4x4, Transpose)
     }
 }
 
+TEST(Matrix4x4, Multiply)
+{
+    uint32_t seed = 7;
+    auto random = [&] {
+        seed = seed * 1664525u + 1013904223u;
+        return float(seed >> 8) / float(1 << 24) * 2.0f - 1.0f;
+    };
+
+    for (int n = 0; n < 100; ++n)
+    {
+        Matrix a, b;
+        for (int i = 0; i < 16; ++i)
+        {
+            ((float*)&a)[i] = random();
+            ((float*)&b)[i] = random();
+        }
+        glm::mat4 glmA = glm::make_mat4((float*)&a);
+        glm::mat4 glmB = glm::make_mat4((float*)&b);
+
+        // row vectors, a * b here is b * a on glm's column vectors
+        Matrix ab = a * b;
+        Matrix ab2 = Matrix::multiply(a, b);
+        glm::mat4 glmAB = glmB * glmA;
+        for (int i = 0; i < 16; ++i)
+        {
+            EXPECT_NEAR(((float*)&ab)[i], glm::value_ptr(glmAB)[i], 1e-5f);
+            EXPECT_EQ(((float*)&ab)[i], ((float*)&ab2)[i]);
+        }
+
+        Matrix sum = a + b * 0.5f;
+        glm::mat4 glmSum = glmA + glmB * 0.5f;
+        Matrix t = Matrix::transpose(a);
+        glm::mat4 glmT = glm::transpose(glmA);
+        for (int i = 0; i < 16; ++i)
+        {
+            EXPECT_FLOAT_EQ(((float*)&sum)[i], glm::value_ptr(glmSum)[i]);
+            EXPECT_EQ(((float*)&t)[i], glm::value_ptr(glmT)[i]);
+        }
+
+        Vector4 v(random(), random(), random(), random());
+        Vector4 tv = Vector4::transform(v, a);
+        glm::vec4 glmTV = glmA * glm::vec4(v.x, v.y, v.z, v.w);
+        EXPECT_NEAR(tv.x, glmTV.x, 1e-5f);
+        EXPECT_NEAR(tv.y, glmTV.y, 1e-5f);
+        EXPECT_NEAR(tv.z, glmTV.z, 1e-5f);
+        EXPECT_NEAR(tv.w, glmTV.w, 1e-5f);
+
+        Vector3 p = Vector3::transform(Vector3(v.x, v.y, v.z), a);
+        glm::vec4 glmP = glmA * glm::vec4(v.x, v.y, v.z, 1.0f);
+        EXPECT_NEAR(p.x, glmP.x, 1e-5f);
+        EXPECT_NEAR(p.y, glmP.y, 1e-5f);
+        EXPECT_NEAR(p.z, glmP.z, 1e-5f);
+    }
+}
+
 TEST(Matrix4x4, Inverse)
 {
     Matrix invIdent = Matrix::invert(Matrix::identity());
@@ -167,6 +222,81 @@ TEST(Vector3, Transform)
     EXPECT_FLOAT_EQ(pos.z, glmPos.z);
 }
 
+TEST(Vector3, Batch)
+{
+    uint32_t seed = 11;
+    auto random = [&] {
+        seed = seed * 1664525u + 1013904223u;
+        return float(seed >> 8) / float(1 << 24) * 2.0f - 1.0f;
+    };
+
+    // not a multiple of the SIMD width so the tails run too
+    const size_t n = 67;
+    std::vector<Vector3> points(n), translations(n), scales(n);
+    std::vector<Quaternion> rotations(n);
+    std::vector<Matrix> matrices(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        points[i] = Vector3(random(), random(), random());
+        translations[i] = Vector3(random(), random(), random());
+        scales[i] = Vector3(random() + 2.0f, random() + 2.0f, random() + 2.0f);
+        rotations[i] = Quaternion::normalize(Quaternion(random(), random(), random(), random()));
+        for (int j = 0; j < 16; ++j)
+        {
+            ((float*)&matrices[i])[j] = random();
+        }
+    }
+    Matrix m = Matrix::createScale(1.0f, 2.0f, 3.0f) * Matrix::createRotationY(toRadians(30.0f)) * Matrix::createTranslation(4.0f, 5.0f, 6.0f);
+
+    std::vector<Vector3> out(n);
+    transformPoints(points, m, out);
+    for (size_t i = 0; i < n; ++i)
+    {
+        Vector3 expected = Vector3::transform(points[i], m);
+        EXPECT_FLOAT_EQ(out[i].x, expected.x);
+        EXPECT_FLOAT_EQ(out[i].y, expected.y);
+        EXPECT_FLOAT_EQ(out[i].z, expected.z);
+    }
+
+    // only the indexed points are written
+    std::vector<uint32_t> indices = {3, 1, 3, 60};
+    std::vector<Vector3> indexed(n, Vector3::zero());
+    transformPoints(points, indices, m, indexed);
+    EXPECT_FLOAT_EQ(indexed[60].z, out[60].z);
+    EXPECT_FLOAT_EQ(indexed[3].x, out[3].x);
+    EXPECT_EQ(indexed[2].x, 0.0f);
+
+    std::vector<Matrix> trs(n);
+    composeTRS(translations, rotations, scales, trs);
+    std::vector<Matrix> products(n);
+    multiplyMatrices(matrices, trs, products);
+    for (size_t i = 0; i < n; ++i)
+    {
+        Matrix expected = Matrix::createScale(scales[i]) * Matrix::createFromQuaternion(rotations[i]) * Matrix::createTranslation(translations[i]);
+        Matrix product = matrices[i] * trs[i];
+        for (int j = 0; j < 16; ++j)
+        {
+            EXPECT_FLOAT_EQ(((float*)&trs[i])[j], ((float*)&expected)[j]);
+            EXPECT_FLOAT_EQ(((float*)&products[i])[j], ((float*)&product)[j]);
+        }
+    }
+
+    // in place, a single right hand side
+    std::vector<Matrix> expected(n);
+    for (size_t i = 0; i < n; ++i)
+    {
+        expected[i] = matrices[i] * m;
+    }
+    multiplyMatrices(matrices, m, matrices);
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (int j = 0; j < 16; ++j)
+        {
+            EXPECT_FLOAT_EQ(((float*)&matrices[i])[j], ((float*)&expected[i])[j]);
+        }
+    }
+}
+
 TEST(Quaternion, AddSub)
 {
     Quaternion q0 = Quaternion(1.0f, 2.0f, 3.0f, 1.0f);
@@ -192,6 +322,31 @@ TEST(Quaternion, AddSub)
     EXPECT_FLOAT_EQ(q2.w, glmQ2.z);
 }
 
+TEST(Quaternion, Multiply)
+{
+    Quaternion q0 = Quaternion::normalize(Quaternion(1.0f, 2.0f, 3.0f, 1.0f));
+    Quaternion q1 = Quaternion::normalize(Quaternion(-4.0f, 5.0f, 0.5f, 2.0f));
+
+    glm::quat glmQ0 = glm::quat(q0.w, q0.x, q0.y, q0.z);
+    glm::quat glmQ1 = glm::quat(q1.w, q1.x, q1.y, q1.z);
+
+    // q0 rotates first, like the matrices
+    Quaternion q2 = q0 * q1;
+    glm::quat glmQ2 = glmQ1 * glmQ0;
+
+    EXPECT_FLOAT_EQ(q2.x, glmQ2.x);
+    EXPECT_FLOAT_EQ(q2.y, glmQ2.y);
+    EXPECT_FLOAT_EQ(q2.z, glmQ2.z);
+    EXPECT_FLOAT_EQ(q2.w, glmQ2.w);
+
+    Matrix m = Matrix::createFromQuaternion(q0) * Matrix::createFromQuaternion(q1);
+    Matrix m2 = Matrix::createFromQuaternion(q2);
+    for (int i = 0; i < 16; ++i)
+    {
+        EXPECT_NEAR(((float*)&m)[i], ((float*)&m2)[i], 1e-5f);
+    }
+}
+
 #include <kame/gltf/gltf.hpp>
 
 TEST(Gltf, base64)
@@ -211,3 +366,1409 @@ TEST(Gltf, base64)
     EXPECT_EQ('M', d[0]);
     EXPECT_EQ(1, d.size());
 }
+
+TEST(Gltf, base64Invalid)
+{
+    std::vector<uint8_t> d;
+    EXPECT_TRUE(kame::gltf::decodeBase64("", 0, d));
+    EXPECT_TRUE(d.empty());
+    EXPECT_FALSE(kame::gltf::decodeBase64("TWF", 3, d));
+    EXPECT_FALSE(kame::gltf::decodeBase64("TW=u", 4, d));
+    EXPECT_FALSE(kame::gltf::decodeBase64("T===", 4, d));
+    EXPECT_FALSE(kame::gltf::decodeBase64("TW-u", 4, d));
+    EXPECT_TRUE(d.empty());
+}
+
+TEST(Gltf, base64Long)
+{
+    // long enough for the SIMD paths, with every offset of the tail and a bad character at every position
+    const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    for (size_t n = 0; n < 300; n += 7)
+    {
+        std::vector<uint8_t> bytes(n);
+        for (size_t i = 0; i < n; ++i)
+        {
+            bytes[i] = uint8_t(i * 131 + n);
+        }
+
+        std::string str;
+        for (size_t i = 0; i < n; i += 3)
+        {
+            uint32_t v = bytes[i] << 16 | (i + 1 < n ? bytes[i + 1] << 8 : 0) | (i + 2 < n ? bytes[i + 2] : 0);
+            str += alphabet[(v >> 18) & 63];
+            str += alphabet[(v >> 12) & 63];
+            str += i + 1 < n ? alphabet[(v >> 6) & 63] : '=';
+            str += i + 2 < n ? alphabet[v & 63] : '=';
+        }
+
+        std::vector<uint8_t> d;
+        ASSERT_TRUE(kame::gltf::decodeBase64(str.data(), str.size(), d));
+        EXPECT_EQ(bytes, d);
+
+        for (size_t i = 0; i < str.size(); i += 5)
+        {
+            std::string bad = str;
+            bad[i] = '*';
+            EXPECT_FALSE(kame::gltf::decodeBase64(bad.data(), bad.size(), d));
+        }
+    }
+}
+
+TEST(Gltf, GLB)
+{
+    const char* json = R"({"asset":{"version":"2.0"},"buffers":[{"byteLength":6}]})";
+    std::vector<uint8_t> jsonChunk(json, json + strlen(json));
+    while (jsonChunk.size() % 4)
+    {
+        jsonChunk.push_back(' ');
+    }
+    std::vector<uint8_t> binChunk = {1, 2, 3, 4, 5, 6, 0, 0};
+
+    auto pushU32 = [](std::vector<uint8_t>& v, uint32_t x) {
+        for (int i = 0; i < 4; ++i)
+        {
+            v.push_back((x >> (8 * i)) & 0xFF);
+        }
+    };
+
+    std::vector<uint8_t> glb;
+    pushU32(glb, 0x46546C67);
+    pushU32(glb, 2);
+    pushU32(glb, 12 + 8 + jsonChunk.size() + 8 + binChunk.size());
+    pushU32(glb, jsonChunk.size());
+    pushU32(glb, 0x4E4F534A);
+    glb.insert(glb.end(), jsonChunk.begin(), jsonChunk.end());
+    pushU32(glb, binChunk.size());
+    pushU32(glb, 0x004E4942);
+    glb.insert(glb.end(), binChunk.begin(), binChunk.end());
+
+    EXPECT_TRUE(kame::gltf::isGLB(glb.data(), glb.size()));
+
+    kame::gltf::Gltf* gltf = kame::gltf::loadGLTFFromMemory(glb.data(), glb.size());
+    EXPECT_TRUE(gltf->isGLB);
+    EXPECT_EQ(1, gltf->buffers.size());
+    EXPECT_EQ(6, gltf->buffers[0].byteLength);
+    EXPECT_TRUE(gltf->buffers[0].binaryData.empty());
+    // zero-copy: points into the source image
+    EXPECT_EQ(glb.data() + glb.size() - binChunk.size(), gltf->buffers[0].data());
+    EXPECT_EQ(6, gltf->buffers[0].data()[5]);
+    kame::gltf::deleteGLTF(gltf);
+}
+
+#include <filesystem>
+#include <fstream>
+
+TEST(Gltf, MemoryMappedBuffer)
+{
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "kame_test_mmap";
+    std::filesystem::create_directories(dir);
+    {
+        std::ofstream bin(dir / "a.bin", std::ios::binary);
+        const char data[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+        bin.write(data, sizeof(data));
+        std::ofstream gltf(dir / "a.gltf");
+        gltf << R"({"asset":{"version":"2.0"},"buffers":[{"byteLength":8,"uri":"a.bin"}]})";
+    }
+
+    kame::gltf::LoadOptions options;
+    options.useMemoryMapping = true;
+    kame::gltf::Gltf* gltf = kame::gltf::loadGLTF((dir / "a.gltf").string().c_str(), options);
+    EXPECT_EQ(1, gltf->buffers.size());
+    EXPECT_TRUE(gltf->buffers[0].mapping);
+    EXPECT_TRUE(gltf->buffers[0].binaryData.empty());
+    EXPECT_EQ(gltf->buffers[0].mapping->data, gltf->buffers[0].data());
+    EXPECT_EQ(8, gltf->buffers[0].data()[7]);
+    kame::gltf::deleteGLTF(gltf);
+
+    std::filesystem::remove_all(dir);
+}
+
+#include <kame/gltf/gltf_accessor.hpp>
+
+TEST(Gltf, AccessorView)
+{
+    kame::gltf::Gltf gltf;
+
+    // interleaved: [float3 position][u8x4 normalized color] x 20
+    const size_t numVerts = 20;
+    const size_t stride = 16;
+    gltf.buffers.emplace_back();
+    auto& b = gltf.buffers.back();
+    b.binaryData.resize(stride * numVerts + sizeof(uint16_t) * numVerts);
+    b.byteLength = b.binaryData.size();
+    for (size_t i = 0; i < numVerts; ++i)
+    {
+        float p[3] = {float(i), float(i) * 2.0f, float(i) * 3.0f};
+        uint8_t c[4] = {uint8_t(i), 255, 0, uint8_t(i * 10)};
+        std::memcpy(&b.binaryData[i * stride], p, sizeof(p));
+        std::memcpy(&b.binaryData[i * stride + 12], c, sizeof(c));
+        uint16_t idx = uint16_t(numVerts - 1 - i);
+        std::memcpy(&b.binaryData[stride * numVerts + i * 2], &idx, sizeof(idx));
+    }
+
+    gltf.bufferViews.emplace_back();
+    gltf.bufferViews[0].buffer = 0;
+    gltf.bufferViews[0].byteLength = stride * numVerts;
+    gltf.bufferViews[0].byteStride = stride;
+    gltf.bufferViews[0].hasByteStride = true;
+    gltf.bufferViews.emplace_back();
+    gltf.bufferViews[1].buffer = 0;
+    gltf.bufferViews[1].byteOffset = stride * numVerts;
+    gltf.bufferViews[1].byteLength = sizeof(uint16_t) * numVerts;
+
+    auto addAccessor = [&](kame::gltf::integer bv, kame::gltf::integer offset, kame::gltf::integer componentType, const char* type, bool normalized) {
+        kame::gltf::Accessor acc;
+        acc.bufferView = bv;
+        acc.hasBufferView = true;
+        acc.byteOffset = offset;
+        acc.componentType = componentType;
+        acc.count = numVerts;
+        acc.type = type;
+        acc.normalized = normalized;
+        gltf.accessors.emplace_back(acc);
+    };
+    addAccessor(0, 0, kame::gltf::kCOMPONENT_TYPE_FLOAT, "VEC3", false);
+    addAccessor(0, 12, kame::gltf::kCOMPONENT_TYPE_UNSIGNED_BYTE, "VEC4", true);
+    addAccessor(1, 0, kame::gltf::kCOMPONENT_TYPE_UNSIGNED_SHORT, "SCALAR", false);
+
+    auto positions = kame::gltf::AccessorView<Vector3>(&gltf, 0).toVector();
+    ASSERT_EQ(numVerts, positions.size());
+    EXPECT_FLOAT_EQ(7.0f, positions[7].x);
+    EXPECT_FLOAT_EQ(21.0f, positions[7].z);
+
+    auto colors = kame::gltf::AccessorView<Vector4>(&gltf, 1).toVector();
+    EXPECT_FLOAT_EQ(7.0f / 255.0f, colors[7].x);
+    EXPECT_FLOAT_EQ(1.0f, colors[7].y);
+    EXPECT_FLOAT_EQ(70.0f / 255.0f, colors[7].w);
+
+    auto joints = kame::gltf::AccessorView<std::array<uint16_t, 4>>(&gltf, 1).toVector();
+    EXPECT_EQ(7, joints[7][0]);
+    EXPECT_EQ(255, joints[7][1]);
+
+    kame::gltf::AccessorView<unsigned int> indexView(&gltf, 2);
+    std::vector<unsigned int> indices = indexView.toVector();
+    for (size_t i = 0; i < numVerts; ++i)
+    {
+        EXPECT_EQ(numVerts - 1 - i, indices[i]);
+    }
+    EXPECT_EQ(numVerts - 1 - 5, indexView[5]);
+
+    std::vector<uint16_t> raw(numVerts);
+    kame::gltf::AccessorView<uint16_t>(&gltf, 2).copyTo(raw.data());
+    EXPECT_EQ(numVerts - 1, raw[0]);
+}
+
+TEST(Gltf, AccessorNormalizedFastPath)
+{
+    // every u8 and u16 value, tightly packed so the SIMD kernels and their scalar tails decode them
+    const size_t numBytes = 256 + 3;
+    const size_t numShorts = 65536 + 5;
+    kame::gltf::Gltf gltf;
+    gltf.buffers.emplace_back();
+    auto& b = gltf.buffers.back();
+    b.binaryData.resize(numBytes + 1 + numShorts * sizeof(uint16_t));
+    b.byteLength = b.binaryData.size();
+    for (size_t i = 0; i < numBytes; ++i)
+    {
+        b.binaryData[i] = uint8_t(i);
+    }
+    for (size_t i = 0; i < numShorts; ++i)
+    {
+        uint16_t v = uint16_t(i);
+        std::memcpy(&b.binaryData[numBytes + 1 + i * 2], &v, sizeof(v));
+    }
+
+    gltf.bufferViews.resize(2);
+    gltf.bufferViews[0].buffer = 0;
+    gltf.bufferViews[0].byteLength = numBytes;
+    gltf.bufferViews[1].buffer = 0;
+    gltf.bufferViews[1].byteOffset = numBytes + 1;
+    gltf.bufferViews[1].byteLength = numShorts * sizeof(uint16_t);
+    for (kame::gltf::integer i = 0; i < 2; ++i)
+    {
+        kame::gltf::Accessor acc;
+        acc.bufferView = i;
+        acc.hasBufferView = true;
+        acc.componentType = i == 0 ? kame::gltf::kCOMPONENT_TYPE_UNSIGNED_BYTE : kame::gltf::kCOMPONENT_TYPE_UNSIGNED_SHORT;
+        acc.count = i == 0 ? numBytes : numShorts;
+        acc.type = "SCALAR";
+        acc.normalized = true;
+        gltf.accessors.emplace_back(acc);
+    }
+
+    auto bytes = kame::gltf::AccessorView<float>(&gltf, 0).toVector();
+    ASSERT_EQ(numBytes, bytes.size());
+    for (size_t i = 0; i < numBytes; ++i)
+    {
+        float expected = kame::gltf::detail::convertComponent<float>(uint8_t(i), true);
+        EXPECT_EQ(0, std::memcmp(&expected, &bytes[i], sizeof(float))) << i;
+    }
+    EXPECT_EQ(1.0f, bytes[255]);
+
+    auto shorts = kame::gltf::AccessorView<float>(&gltf, 1).toVector();
+    ASSERT_EQ(numShorts, shorts.size());
+    for (size_t i = 0; i < numShorts; ++i)
+    {
+        float expected = kame::gltf::detail::convertComponent<float>(uint16_t(i), true);
+        EXPECT_EQ(0, std::memcmp(&expected, &shorts[i], sizeof(float))) << i;
+    }
+    EXPECT_EQ(1.0f, shorts[65535]);
+}
+
+#include <kame/squirtle/parallel.hpp>
+
+TEST(Squirtle, ThreadPool)
+{
+    kame::squirtle::ThreadPool pool(4);
+    EXPECT_EQ(4, pool.getNumThreads());
+
+    for (size_t count : {0, 1, 7, 1000})
+    {
+        std::vector<int> hits(count, 0);
+        pool.parallelFor(count, 3, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+            {
+                hits[i]++;
+            }
+        });
+        for (size_t i = 0; i < count; ++i)
+        {
+            EXPECT_EQ(1, hits[i]);
+        }
+    }
+}
+
+#include <kame/squirtle/model.hpp>
+
+TEST(Squirtle, PackedVertices)
+{
+    using namespace kame::squirtle;
+
+    EXPECT_EQ(0x3c00, packHalf(1.0f));
+    EXPECT_EQ(0xc000, packHalf(-2.0f));
+    EXPECT_EQ(0x7c00, packHalf(1e6f));
+    for (float f : {0.0f, 0.5f, 0.333f, 1.75f, -3.1f, 1e-6f, 65504.0f})
+    {
+        EXPECT_NEAR(f, unpackHalf(packHalf(f)), std::abs(f) / 1024.0f + 1e-7f);
+    }
+
+    Primitive pri;
+    for (int i = 0; i < 64; ++i)
+    {
+        float a = i * 0.3f;
+        float b = i * 0.17f - 4.0f;
+        Vector3 n = Vector3::normalize(Vector3(std::cos(a) * std::cos(b), std::sin(a) * std::cos(b), std::sin(b)));
+        pri.positions.emplace_back(float(i), 2.0f * i, -float(i));
+        pri.normals.emplace_back(n);
+        pri.tangents.emplace_back(n.y, -n.x, 0.0f, i % 2 ? 1.0f : -1.0f);
+        pri.weights.emplace_back(0.5f, 0.3f, 0.2f, 0.0f);
+        pri.joints.push_back({uint16_t(i), 1, 2, 3});
+    }
+    pri.uvSets.emplace_back();
+    for (int i = 0; i < 64; ++i)
+    {
+        pri.uvSets[0].emplace_back(i / 64.0f, 1.0f - i / 64.0f);
+    }
+
+    PackedVertices packed = packVertices(pri);
+    EXPECT_EQ(32, packed.stride); // 72 bytes unpacked
+    EXPECT_FALSE(packed.hasAttribute(kVERTEX_ATTRIBUTE_UV1));
+    EXPECT_EQ(GLenum(GL_UNSIGNED_BYTE), packed.layout[kVERTEX_ATTRIBUTE_JOINTS].type);
+    EXPECT_TRUE(packed.layout[kVERTEX_ATTRIBUTE_JOINTS].isInteger);
+    EXPECT_FALSE(packed.layout[kVERTEX_ATTRIBUTE_WEIGHTS].isInteger);
+
+    for (size_t i = 0; i < pri.positions.size(); ++i)
+    {
+        const uint8_t* v = packed.data.data() + i * packed.stride;
+
+        Vector3 p;
+        std::memcpy(&p, v + packed.layout[kVERTEX_ATTRIBUTE_POSITION].offset, sizeof(p));
+        EXPECT_EQ(pri.positions[i].x, p.x);
+
+        std::array<int16_t, 2> e;
+        std::memcpy(e.data(), v + packed.layout[kVERTEX_ATTRIBUTE_NORMAL].offset, 4);
+        EXPECT_GT(Vector3::dot(pri.normals[i], unpackOctahedral(e)), 0.9999f);
+
+        uint16_t uv[2];
+        std::memcpy(uv, v + packed.layout[kVERTEX_ATTRIBUTE_UV0].offset, 4);
+        EXPECT_NEAR(pri.uvSets[0][i].x, unpackHalf(uv[0]), 1e-3f);
+
+        const uint8_t* j = v + packed.layout[kVERTEX_ATTRIBUTE_JOINTS].offset;
+        EXPECT_EQ(pri.joints[i][0], j[0]);
+
+        const uint8_t* w = v + packed.layout[kVERTEX_ATTRIBUTE_WEIGHTS].offset;
+        EXPECT_EQ(255, w[0] + w[1] + w[2] + w[3]);
+
+        const int8_t* t = (const int8_t*)(v + packed.layout[kVERTEX_ATTRIBUTE_TANGENT].offset);
+        EXPECT_EQ(pri.tangents[i].w < 0.0f ? -127 : 127, t[3]);
+    }
+
+    pri.joints[0][1] = 300;
+    packed = packVertices(pri, vertexAttributeBit(kVERTEX_ATTRIBUTE_POSITION) | vertexAttributeBit(kVERTEX_ATTRIBUTE_JOINTS));
+    EXPECT_EQ(20, packed.stride);
+    EXPECT_EQ(GLenum(GL_UNSIGNED_SHORT), packed.layout[kVERTEX_ATTRIBUTE_JOINTS].type);
+}
+
+TEST(Squirtle, MeshOptimizer)
+{
+    using namespace kame::squirtle;
+
+    // 64x64 grid with its triangles shuffled
+    const unsigned int n = 64;
+    Primitive pri;
+    for (unsigned int y = 0; y <= n; ++y)
+    {
+        for (unsigned int x = 0; x <= n; ++x)
+        {
+            pri.positions.emplace_back(float(x), float(y), 0.0f);
+            pri.normals.emplace_back(0.0f, 0.0f, 1.0f);
+        }
+    }
+    std::vector<std::array<unsigned int, 3>> tris;
+    for (unsigned int y = 0; y < n; ++y)
+    {
+        for (unsigned int x = 0; x < n; ++x)
+        {
+            unsigned int i = y * (n + 1) + x;
+            tris.push_back({i, i + 1, i + n + 1});
+            tris.push_back({i + 1, i + n + 2, i + n + 1});
+        }
+    }
+    uint32_t seed = 7;
+    for (size_t i = tris.size() - 1; i > 0; --i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        std::swap(tris[i], tris[seed % (i + 1)]);
+    }
+    for (const auto& t : tris)
+    {
+        pri.indices.insert(pri.indices.end(), t.begin(), t.end());
+    }
+
+    auto triangleSet = [](const Primitive& p) {
+        std::vector<std::array<float, 9>> set;
+        for (size_t i = 0; i < p.indices.size(); i += 3)
+        {
+            std::array<float, 9> t;
+            for (int k = 0; k < 3; ++k)
+            {
+                const Vector3& v = p.positions[p.indices[i + k]];
+                t[k * 3 + 0] = v.x;
+                t[k * 3 + 1] = v.y;
+                t[k * 3 + 2] = v.z;
+            }
+            set.push_back(t);
+        }
+        std::sort(set.begin(), set.end());
+        return set;
+    };
+    auto expected = triangleSet(pri);
+
+    MeshOptimizationReport report = optimizePrimitive(pri);
+    EXPECT_TRUE(report.isOptimized);
+    EXPECT_GT(report.before.acmr, 1.5f);
+    EXPECT_LT(report.after.acmr, 0.8f);
+    EXPECT_LT(report.after.atvr, report.before.atvr);
+    EXPECT_EQ(expected, triangleSet(pri));
+
+    // vertices are numbered in order of first use
+    unsigned int next = 0;
+    for (unsigned int i : pri.indices)
+    {
+        EXPECT_LE(i, next);
+        next = std::max(next, i + 1);
+    }
+
+    EXPECT_EQ(GLenum(GL_UNSIGNED_SHORT), pri.getIndexType());
+    ASSERT_EQ(pri.indices.size() * sizeof(uint16_t), pri.getBytesOfIndexData());
+    std::vector<uint16_t> shortIndices(pri.indices.size());
+    pri.copyIndexData(shortIndices.data());
+    EXPECT_EQ(pri.indices.back(), shortIndices.back());
+
+    // rewriting indices afterwards, e.g. for a level of detail, is what gets uploaded
+    pri.indices.resize(3);
+    EXPECT_EQ(3 * sizeof(uint16_t), pri.getBytesOfIndexData());
+    pri.copyIndexData(shortIndices.data());
+    EXPECT_EQ(pri.indices[2], shortIndices[2]);
+}
+
+TEST(Squirtle, LOD)
+{
+    using namespace kame::squirtle;
+
+    // a closed, finely tessellated sphere
+    const int rings = 32;
+    const int segments = 64;
+    Primitive pri;
+    for (int r = 0; r <= rings; ++r)
+    {
+        for (int s = 0; s <= segments; ++s)
+        {
+            float theta = helper::Pi * r / rings;
+            float phi = 2.0f * helper::Pi * (s % segments) / segments;
+            Vector3 n(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+            pri.positions.emplace_back(n);
+            pri.normals.emplace_back(n);
+        }
+    }
+    for (int r = 0; r < rings; ++r)
+    {
+        for (int s = 0; s < segments; ++s)
+        {
+            unsigned int i = r * (segments + 1) + s;
+            pri.indices.insert(pri.indices.end(), {i, i + segments + 1, i + 1, i + 1, i + segments + 1, i + segments + 2});
+        }
+    }
+
+    LODOptions options;
+    options.numLevels = 3;
+    options.maxError = 0.1f;
+    generateLODs(pri, options);
+    ASSERT_FALSE(pri.lods.empty());
+
+    size_t prevCount = pri.indices.size();
+    float prevError = 0.0f;
+    for (const auto& lod : pri.lods)
+    {
+        EXPECT_LT(lod.indices.size(), prevCount);
+        EXPECT_GE(lod.error, prevError);
+        EXPECT_LE(lod.error, 0.2f);
+        prevCount = lod.indices.size();
+        prevError = lod.error;
+    }
+    EXPECT_LE(pri.lods[0].indices.size(), pri.indices.size() * 6 / 10);
+
+    // the coarse levels still cover the sphere
+    float area = 0.0f;
+    for (size_t i = 0; i < pri.lods.back().indices.size(); i += 3)
+    {
+        const auto& idx = pri.lods.back().indices;
+        area += 0.5f * Vector3::length(Vector3::cross(pri.positions[idx[i + 1]] - pri.positions[idx[i]], pri.positions[idx[i + 2]] - pri.positions[idx[i]]));
+    }
+    EXPECT_NEAR(4.0f * helper::Pi, area, 4.0f * helper::Pi * 0.15f);
+
+    LODSelector selector;
+    EXPECT_EQ(0, selector.select(pri, Matrix::identity()));
+    selector.projectionScale = 1000.0f;
+    selector.viewPosition = Vector3(0.0f, 0.0f, 1.5f);
+    EXPECT_EQ(0, selector.select(pri, Matrix::identity()));
+    selector.viewPosition = Vector3(0.0f, 0.0f, 1e6f);
+    EXPECT_EQ(int(pri.lods.size()), selector.select(pri, Matrix::identity()));
+}
+
+TEST(Squirtle, Meshlets)
+{
+    using namespace kame::squirtle;
+
+    // 40x40 grid facing +z
+    const unsigned int n = 40;
+    Primitive pri;
+    for (unsigned int y = 0; y <= n; ++y)
+    {
+        for (unsigned int x = 0; x <= n; ++x)
+        {
+            pri.positions.emplace_back(float(x), float(y), 0.0f);
+        }
+    }
+    for (unsigned int y = 0; y < n; ++y)
+    {
+        for (unsigned int x = 0; x < n; ++x)
+        {
+            unsigned int i = y * (n + 1) + x;
+            pri.indices.insert(pri.indices.end(), {i, i + 1, i + n + 1, i + 1, i + n + 2, i + n + 1});
+        }
+    }
+    optimizeVertexCache(pri.indices, pri.positions.size());
+
+    MeshletData data = buildMeshlets(pri);
+    ASSERT_FALSE(data.meshlets.empty());
+    ASSERT_EQ(data.meshlets.size(), data.bounds.size());
+
+    std::vector<unsigned int> indices;
+    for (size_t m = 0; m < data.meshlets.size(); ++m)
+    {
+        const Meshlet& meshlet = data.meshlets[m];
+        EXPECT_LE(meshlet.vertexCount, kMESHLET_MAX_VERTICES);
+        EXPECT_LE(meshlet.triangleCount, kMESHLET_MAX_TRIANGLES);
+        EXPECT_EQ(0, meshlet.triangleOffset % 4);
+
+        size_t before = indices.size();
+        appendMeshletIndices(data, m, indices);
+        const MeshletBounds& b = data.bounds[m];
+        for (size_t i = before; i < indices.size(); ++i)
+        {
+            EXPECT_LE(Vector3::length(pri.positions[indices[i]] - b.center), b.radius + 1e-4f);
+        }
+
+        // a flat patch is seen from the front only
+        EXPECT_FALSE(isMeshletBackfacing(b, b.center + Vector3(0.0f, 0.0f, 10.0f)));
+        EXPECT_TRUE(isMeshletBackfacing(b, b.center - Vector3(0.0f, 0.0f, 10.0f)));
+    }
+    EXPECT_EQ(pri.indices, indices);
+}
+
+TEST(Squirtle, FrustumCulling)
+{
+    using namespace kame::squirtle;
+
+    auto view = Matrix::createLookAt(Vector3(0.0f, 0.0f, 5.0f), Vector3::zero(), Vector3(0.0f, 1.0f, 0.0f));
+    auto proj = Matrix::createPerspectiveFieldOfView_NO(helper::toRadians(60.0f), 1.0f, 0.1f, 100.0f);
+    Frustum frustum = Frustum::fromMatrix(view * proj);
+
+    auto box = [](Vector3 center, float halfSize) {
+        AABB b;
+        b.merge(center - Vector3(halfSize, halfSize, halfSize));
+        b.merge(center + Vector3(halfSize, halfSize, halfSize));
+        return b;
+    };
+    std::vector<AABB> boxes = {
+        box(Vector3::zero(), 0.5f),                // in front of the camera
+        box(Vector3(0.0f, 0.0f, 10.0f), 0.5f),     // behind it
+        box(Vector3(-50.0f, 0.0f, 0.0f), 0.5f),    // far to the left
+        box(Vector3(0.0f, 0.0f, -200.0f), 0.5f),   // beyond the far plane
+        box(Vector3(-3.2f, 0.0f, 0.0f), 0.5f),     // straddles the left plane
+        AABB(),                                    // empty
+        box(Vector3(0.0f, 30.0f, -20.0f), 1.0f),   // above
+        box(Vector3(2.0f, -2.0f, -10.0f), 0.25f)}; // inside, off center
+    const uint8_t expected[] = {1, 0, 0, 0, 1, 0, 0, 1};
+
+    std::vector<uint8_t> visible(boxes.size());
+    EXPECT_EQ(3u, cullAABBs(frustum, boxes.data(), boxes.size(), visible.data()));
+    for (size_t i = 0; i < boxes.size(); ++i)
+    {
+        EXPECT_EQ(expected[i], visible[i]) << i;
+        EXPECT_EQ(expected[i] != 0, frustum.isVisible(boxes[i])) << i;
+    }
+    EXPECT_TRUE(Frustum().isVisible(boxes[1]));
+
+    // rotating a unit cube by 45 degrees widens it to sqrt(2)
+    AABB rotated = AABB::transform(box(Vector3::zero(), 1.0f), Matrix::createRotationY(helper::toRadians(45.0f)) * Matrix::createTranslation(1.0f, 0.0f, 0.0f));
+    EXPECT_NEAR(1.0f - std::sqrt(2.0f), rotated.min.x, 1e-5f);
+    EXPECT_NEAR(1.0f + std::sqrt(2.0f), rotated.max.x, 1e-5f);
+    EXPECT_NEAR(1.0f, rotated.max.y, 1e-5f);
+
+    // only the primitive in view reaches the callback
+    Model model;
+    model.meshes.resize(1);
+    for (float x : {0.0f, 50.0f})
+    {
+        Primitive pri;
+        pri.positions = {Vector3(x, 0.0f, 0.0f), Vector3(x + 1.0f, 0.0f, 0.0f), Vector3(x, 1.0f, 0.0f)};
+        pri.indices = {0, 1, 2};
+        pri.bounds = computeAABB(pri.positions);
+        pri.id = int(model.meshes[0].primitives.size());
+        model.meshes[0].primitives.emplace_back(pri);
+    }
+    model.nodes.resize(1);
+    model.nodes[0].meshID = 0;
+    model.frustum = frustum;
+
+    std::vector<Vector3> positions;
+    std::vector<int> updated;
+    model.update(positions, [&](const UpdateData& data) { updated.emplace_back(data.primitive.id); });
+    EXPECT_EQ(std::vector<int>{0}, updated);
+
+    updated.clear();
+    model.nodes[0].position = Vector3(-50.0f, 0.0f, 0.0f);
+    model.update(positions, [&](const UpdateData& data) { updated.emplace_back(data.primitive.id); });
+    EXPECT_EQ(std::vector<int>{1}, updated);
+}
+
+TEST(Squirtle, GPUSkinning)
+{
+    using namespace kame::squirtle;
+
+    // two joints blended 3:1 on every vertex
+    Model model;
+    model._isSkinnedMesh = true;
+    model.meshes.resize(1);
+    Primitive pri;
+    pri.positions = {Vector3(0.0f, 0.0f, 0.0f), Vector3(1.0f, 0.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f), Vector3(1.0f, 1.0f, 0.0f)};
+    pri.joints.assign(4, u16Array4{0, 1, 0, 0});
+    pri.weights.assign(4, Vector4(0.75f, 0.25f, 0.0f, 0.0f));
+    pri.indices = {0, 1, 2, 2, 1, 3};
+    pri.bounds = computeAABB(pri.positions);
+    pri.jointBounds = {pri.bounds, pri.bounds};
+    pri.id = 0;
+    model.meshes[0].primitives.emplace_back(pri);
+
+    model.nodes.resize(3);
+    model.nodes[0].meshID = 0;
+    model.nodes[0].skinID = 0;
+    model.nodes[1].position = Vector3(0.0f, 2.0f, 0.0f);
+    model.nodes[1].rotation = Quaternion(0.0f, 0.0f, std::sin(helper::toRadians(15.0f)), std::cos(helper::toRadians(15.0f)));
+    model.nodes[2].position = Vector3(-1.0f, 0.0f, 0.5f);
+    model.skins.resize(1);
+    model.skins[0].joints = {1, 2};
+    model.skins[0].inverseBindMatrices = {Matrix::identity(), Matrix::identity()};
+    model.skins[0].matrices.resize(2);
+
+    std::vector<Vector3> cpuPositions;
+    std::vector<Vector3> positions;
+    model.update(positions, [&](const UpdateData& data) {
+        EXPECT_TRUE(data.jointMatrices.empty());
+        cpuPositions = data.positions;
+    });
+    ASSERT_EQ(pri.positions.size(), cpuPositions.size());
+
+    int numUpdates = 0;
+    model.skinningMode = kSKINNING_GPU;
+    model.update(positions, [&](const UpdateData& data) {
+        ++numUpdates;
+        ASSERT_EQ(2u, data.jointMatrices.size());
+        EXPECT_EQ(&model.meshes[0].primitives[0].positions, &data.positions);
+        for (size_t i = 0; i < data.positions.size(); ++i)
+        {
+            // what the vertex shader does
+            auto skin = data.jointMatrices[0] * 0.75f + data.jointMatrices[1] * 0.25f;
+            auto p = Vector3::transform(data.positions[i], skin);
+            EXPECT_NEAR(cpuPositions[i].x, p.x, 1e-5f);
+            EXPECT_NEAR(cpuPositions[i].y, p.y, 1e-5f);
+            EXPECT_NEAR(cpuPositions[i].z, p.z, 1e-5f);
+        }
+    });
+    EXPECT_EQ(1, numUpdates);
+    EXPECT_NEAR(-0.25f, cpuPositions[0].x, 1e-5f);
+    EXPECT_NEAR(1.5f, cpuPositions[0].y, 1e-5f);
+    EXPECT_NEAR(0.125f, cpuPositions[0].z, 1e-5f);
+
+    // a primitive without joints next to the skinned one gets its own vertices, not the last skinned ones
+    Primitive rigid;
+    rigid.positions = {Vector3(5.0f, 0.0f, 0.0f), Vector3(6.0f, 0.0f, 0.0f), Vector3(5.0f, 1.0f, 0.0f)};
+    rigid.indices = {0, 1, 2};
+    rigid.bounds = computeAABB(rigid.positions);
+    rigid.id = 1;
+    model.meshes[0].primitives.emplace_back(rigid);
+    for (SkinningMode mode : {kSKINNING_CPU, kSKINNING_GPU})
+    {
+        model.skinningMode = mode;
+        model.markAllDirty();
+        std::vector<int> updated;
+        model.update(positions, [&](const UpdateData& data) {
+            updated.push_back(data.primitive.id);
+            if (data.primitive.id != 1)
+            {
+                return;
+            }
+            EXPECT_TRUE(data.jointMatrices.empty());
+            ASSERT_LE(rigid.positions.size(), data.positions.size());
+            for (size_t i = 0; i < rigid.positions.size(); ++i)
+            {
+                EXPECT_EQ(rigid.positions[i].x, data.positions[i].x);
+                EXPECT_EQ(rigid.positions[i].y, data.positions[i].y);
+            }
+            EXPECT_EQ(rigid.bounds.max.x, data.bounds.max.x);
+        });
+        EXPECT_EQ((std::vector<int>{0, 1}), updated) << mode;
+    }
+}
+
+#include <random>
+
+TEST(Squirtle, CPUSkinning)
+{
+    using namespace kame::squirtle;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<Matrix> jointMatrices;
+    for (int j = 0; j < 8; ++j)
+    {
+        auto q = Quaternion::normalize(Quaternion(dist(rng), dist(rng), dist(rng), dist(rng)));
+        jointMatrices.emplace_back(Matrix::createFromQuaternion(q) * Matrix::createTranslation(dist(rng), dist(rng), dist(rng)));
+    }
+
+    const size_t numVertices = 1001;
+    std::vector<Vector3> positions;
+    std::vector<u16Array4> joints;
+    std::vector<Vector4> weights;
+    for (size_t i = 0; i < numVertices; ++i)
+    {
+        positions.emplace_back(dist(rng), dist(rng), dist(rng));
+        joints.push_back({uint16_t(rng() % 8), uint16_t(rng() % 8), uint16_t(rng() % 8), uint16_t(rng() % 8)});
+        Vector4 w(std::abs(dist(rng)), std::abs(dist(rng)), std::abs(dist(rng)), std::abs(dist(rng)));
+        // every third vertex follows a single joint
+        if (i % 3 == 0)
+        {
+            w = Vector4(1.0f, 0.0f, 0.0f, 0.0f);
+        }
+        float sum = w.x + w.y + w.z + w.w;
+        weights.emplace_back(w.x / sum, w.y / sum, w.z / sum, w.w / sum);
+    }
+    SkinnedVertices vertices{positions.data(), joints.data(), weights.data(), numVertices};
+
+    std::vector<Vector3> reference(numVertices);
+    for (size_t i = 0; i < numVertices; ++i)
+    {
+        auto m = jointMatrices[joints[i][0]] * weights[i].x + jointMatrices[joints[i][1]] * weights[i].y + jointMatrices[joints[i][2]] * weights[i].z + jointMatrices[joints[i][3]] * weights[i].w;
+        reference[i] = Vector3::transform(positions[i], m);
+    }
+
+    Skinner skinner;
+    skinner.setJoints(jointMatrices);
+    std::vector<Vector3> serial(numVertices);
+    skinner.skin(vertices, serial.data());
+
+    skinner.numThreads = 4;
+    skinner.grainSize = 64;
+    std::vector<Vector3> threaded(numVertices);
+    skinner.skin(vertices, threaded.data());
+
+    Skinner dqSkinner;
+    dqSkinner.method = kSKINNING_METHOD_DUAL_QUATERNION;
+    dqSkinner.setJoints(jointMatrices);
+    std::vector<Vector3> dq(numVertices);
+    dqSkinner.skin(vertices, dq.data());
+
+    for (size_t i = 0; i < numVertices; ++i)
+    {
+        EXPECT_LT(Vector3::length(reference[i] - serial[i]), 1e-5f) << i;
+        EXPECT_EQ(serial[i].x, threaded[i].x);
+        EXPECT_EQ(serial[i].y, threaded[i].y);
+        EXPECT_EQ(serial[i].z, threaded[i].z);
+        if (i % 3 == 0)
+        {
+            // a rigid transform is the same either way
+            EXPECT_LT(Vector3::length(reference[i] - dq[i]), 1e-4f) << i;
+        }
+    }
+
+    // half way between no turn and a quarter turn, linear blending shrinks towards the axis
+    std::vector<Matrix> twist = {Matrix::identity(), Matrix::createRotationZ(helper::toRadians(90.0f))};
+    Vector3 p(1.0f, 0.0f, 0.0f);
+    u16Array4 j = {0, 1, 0, 0};
+    Vector4 w(0.5f, 0.5f, 0.0f, 0.0f);
+    SkinnedVertices one{&p, &j, &w, 1};
+    Vector3 linear, dual;
+    skinner.setJoints(twist);
+    skinner.skin(one, &linear);
+    dqSkinner.setJoints(twist);
+    dqSkinner.skin(one, &dual);
+    EXPECT_NEAR(std::sqrt(0.5f), Vector3::length(linear), 1e-5f);
+    EXPECT_NEAR(1.0f, Vector3::length(dual), 1e-5f);
+    EXPECT_NEAR(0.0f, dual.z, 1e-5f);
+}
+
+TEST(Squirtle, KeyframeLookup)
+{
+    using namespace kame::squirtle;
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> dist(0.01f, 0.1f);
+    AnimationClip::Sampler s;
+    s.inputs.emplace_back(0.5f);
+    for (int i = 0; i < 200; ++i)
+    {
+        s.inputs.emplace_back(s.inputs.back() + dist(rng));
+    }
+    s.analyzeInputs();
+    EXPECT_EQ(0.0f, s.keyInterval);
+
+    auto bruteForce = [&](float t) {
+        uint32_t i = 0;
+        while (i + 2 < s.inputs.size() && t >= s.inputs[i + 1])
+        {
+            ++i;
+        }
+        return i;
+    };
+
+    // forward playback, then random seeks
+    uint32_t cursor = 0;
+    for (float t = 0.0f; t < s.inputs.back() + 1.0f; t += 0.016f)
+    {
+        EXPECT_EQ(bruteForce(t), s.findKey(t, cursor)) << t;
+    }
+    std::uniform_real_distribution<float> seek(-1.0f, s.inputs.back() + 1.0f);
+    for (int n = 0; n < 500; ++n)
+    {
+        float t = seek(rng);
+        EXPECT_EQ(bruteForce(t), s.findKey(t, cursor)) << t;
+    }
+    EXPECT_EQ(bruteForce(s.inputs[17]), s.findKey(s.inputs[17], cursor));
+    EXPECT_EQ(17u, cursor);
+
+    // evenly spaced keys are indexed directly
+    s.inputs.clear();
+    for (int i = 0; i < 120; ++i)
+    {
+        s.inputs.emplace_back(float(i) / 30.0f);
+    }
+    s.analyzeInputs();
+    EXPECT_NEAR(1.0f / 30.0f, s.keyInterval, 1e-6f);
+    for (int n = 0; n < 500; ++n)
+    {
+        float t = seek(rng);
+        EXPECT_EQ(bruteForce(t), s.findKey(t, cursor)) << t;
+    }
+    for (int i = 0; i < 120; ++i)
+    {
+        EXPECT_EQ(bruteForce(s.inputs[i]), s.findKey(s.inputs[i], cursor)) << i;
+    }
+    EXPECT_EQ(118u, s.findKey(1e30f, cursor));
+    EXPECT_EQ(118u, s.findKey(std::numeric_limits<float>::infinity(), cursor));
+    EXPECT_EQ(0u, s.findKey(-1e30f, cursor));
+    EXPECT_EQ(0u, s.findKey(std::numeric_limits<float>::quiet_NaN(), cursor));
+
+    // animate() clamps outside the keys and interpolates inside
+    AnimationClip clip;
+    clip.channels.push_back({0, AnimationClip::Channel::kTRANSLATION, 0});
+    clip.samplers.emplace_back();
+    clip.samplers[0].interpolation = AnimationClip::Sampler::kLINEAR;
+    clip.samplers[0].inputs = {1.0f, 2.0f, 4.0f};
+    clip.samplers[0].outputsVec4 = {Vector4(0.0f, 0.0f, 0.0f, 0.0f), Vector4(1.0f, 0.0f, 0.0f, 0.0f), Vector4(1.0f, 2.0f, 0.0f, 0.0f)};
+    clip.startTime = 1.0f;
+    clip.endTime = 4.0f;
+    std::vector<Node> nodes(1);
+    animate(clip, nodes, 0.0f);
+    EXPECT_EQ(0.0f, nodes[0].position.x);
+    animate(clip, nodes, 1.5f);
+    EXPECT_NEAR(0.5f, nodes[0].position.x, 1e-6f);
+    animate(clip, nodes, 3.0f);
+    EXPECT_NEAR(1.0f, nodes[0].position.x, 1e-6f);
+    EXPECT_NEAR(1.0f, nodes[0].position.y, 1e-6f);
+    animate(clip, nodes, 4.0f);
+    EXPECT_NEAR(2.0f, nodes[0].position.y, 1e-6f);
+}
+
+TEST(Squirtle, AnimationInterpolation)
+{
+    using namespace kame::squirtle;
+
+    AnimationClip clip;
+    clip.startTime = 0.0f;
+    clip.endTime = 2.0f;
+    clip.samplers.resize(3);
+
+    // cubic spline through p(t) = t^3 / 8 with its exact tangents p'(t) = 3t^2 / 8
+    auto& cubic = clip.samplers[0];
+    cubic.interpolation = AnimationClip::Sampler::kCUBICSPLINE;
+    cubic.inputs = {0.0f, 2.0f};
+    cubic.outputsVec4 = {Vector4(0.0f, 0.0f, 0.0f, 0.0f), Vector4(0.0f, 0.0f, 0.0f, 0.0f), Vector4(0.0f, 0.0f, 0.0f, 0.0f),
+                         Vector4(1.5f, 0.0f, 0.0f, 0.0f), Vector4(1.0f, 0.0f, 0.0f, 0.0f), Vector4(1.5f, 0.0f, 0.0f, 0.0f)};
+
+    auto& step = clip.samplers[1];
+    step.interpolation = AnimationClip::Sampler::kSTEP;
+    step.inputs = {0.0f, 1.0f, 2.0f};
+    step.outputsVec4 = {Vector4(1.0f, 1.0f, 1.0f, 0.0f), Vector4(2.0f, 2.0f, 2.0f, 0.0f), Vector4(3.0f, 3.0f, 3.0f, 0.0f)};
+
+    // a quarter turn around z with flat tangents
+    const float s45 = std::sin(helper::toRadians(45.0f));
+    auto& rot = clip.samplers[2];
+    rot.interpolation = AnimationClip::Sampler::kCUBICSPLINE;
+    rot.inputs = {0.0f, 2.0f};
+    rot.outputsVec4 = {Vector4(0.0f, 0.0f, 0.0f, 0.0f), Vector4(0.0f, 0.0f, 0.0f, 1.0f), Vector4(0.0f, 0.0f, 0.0f, 0.0f),
+                       Vector4(0.0f, 0.0f, 0.0f, 0.0f), Vector4(0.0f, 0.0f, s45, s45), Vector4(0.0f, 0.0f, 0.0f, 0.0f)};
+
+    clip.channels.push_back({0, AnimationClip::Channel::kTRANSLATION, 0});
+    clip.channels.push_back({0, AnimationClip::Channel::kSCALE, 1});
+    clip.channels.push_back({1, AnimationClip::Channel::kROTATION, 2});
+    // not enough outputs for a cubic spline, skipped
+    clip.samplers.push_back(cubic);
+    clip.samplers.back().outputsVec4.resize(2);
+    clip.channels.push_back({1, AnimationClip::Channel::kTRANSLATION, 3});
+    clip.compile();
+    EXPECT_EQ(1u, clip.tracks[AnimationClip::Sampler::kCUBICSPLINE * 3 + AnimationClip::Channel::kTRANSLATION].size());
+
+    std::vector<Node> nodes(2);
+    for (float t : {0.0f, 0.5f, 1.0f, 1.7f, 2.0f})
+    {
+        animate(clip, nodes, t);
+        EXPECT_NEAR(t * t * t / 8.0f, nodes[0].position.x, 1e-5f) << t;
+        EXPECT_EQ(std::min(std::floor(t), 2.0f) + 1.0f, nodes[0].scale.x) << t;
+        EXPECT_EQ(0.0f, nodes[1].position.x);
+    }
+
+    animate(clip, nodes, 0.999f);
+    EXPECT_EQ(1.0f, nodes[0].scale.y);
+    animate(clip, nodes, 1.0f);
+    EXPECT_EQ(2.0f, nodes[0].scale.y);
+
+    // flat tangents meet the normalized halfway rotation in the middle
+    const float s22 = std::sin(helper::toRadians(22.5f));
+    animate(clip, nodes, 1.0f);
+    EXPECT_NEAR(s22, nodes[1].rotation.z, 1e-5f);
+    EXPECT_NEAR(std::cos(helper::toRadians(22.5f)), nodes[1].rotation.w, 1e-5f);
+    animate(clip, nodes, 0.5f);
+    EXPECT_NEAR(1.0f, Vector4::length(Vector4(nodes[1].rotation.x, nodes[1].rotation.y, nodes[1].rotation.z, nodes[1].rotation.w)), 1e-5f);
+    EXPECT_LT(nodes[1].rotation.z, s22);
+}
+
+TEST(Squirtle, AnimationCompression)
+{
+    using namespace kame::squirtle;
+
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    auto angle = [](Quaternion a, Quaternion b) {
+        Vector4 va(a.x, a.y, a.z, a.w);
+        Vector4 vb(b.x, b.y, b.z, b.w);
+        vb = Vector4::dot(va, vb) < 0.0f ? -vb : vb;
+        return 4.0f * std::atan2(Vector4::length(va - vb), Vector4::length(va + vb));
+    };
+    for (int i = 0; i < 1000; ++i)
+    {
+        Quaternion q = Quaternion::normalize(Quaternion(dist(rng), dist(rng), dist(rng), dist(rng)));
+        Quaternion r = unpackQuaternion(packQuaternion(q));
+        EXPECT_LT(angle(q, r), 2e-4f) << i;
+    }
+
+    AnimationClip clip;
+    clip.startTime = 0.0f;
+    clip.endTime = 10.0f;
+    auto addChannel = [&](int node, AnimationClip::Channel::PathType path, AnimationClip::Sampler::InterpolationType interpolation, auto fn) {
+        AnimationClip::Sampler s;
+        s.interpolation = interpolation;
+        for (int k = 0; k <= 300; ++k)
+        {
+            float t = float(k) / 30.0f;
+            s.inputs.emplace_back(t);
+            s.outputsVec4.emplace_back(fn(t));
+        }
+        clip.channels.push_back({node, path, uint32_t(clip.samplers.size())});
+        clip.samplers.emplace_back(std::move(s));
+    };
+    // a straight line, a constant turn rate and a constant scale reduce to their end keys
+    addChannel(0, AnimationClip::Channel::kTRANSLATION, AnimationClip::Sampler::kLINEAR, [](float t) { return Vector4(t, 2.0f * t, -t, 0.0f); });
+    addChannel(0, AnimationClip::Channel::kROTATION, AnimationClip::Sampler::kLINEAR, [](float t) { return Vector4(0.0f, 0.0f, std::sin(t * 0.1f), std::cos(t * 0.1f)); });
+    addChannel(0, AnimationClip::Channel::kSCALE, AnimationClip::Sampler::kLINEAR, [](float) { return Vector4(2.0f, 2.0f, 2.0f, 0.0f); });
+    // a curve, steps changing every second and mocap-like noise
+    addChannel(1, AnimationClip::Channel::kTRANSLATION, AnimationClip::Sampler::kLINEAR, [](float t) { return Vector4(std::sin(t), std::cos(t), 0.0f, 0.0f); });
+    addChannel(1, AnimationClip::Channel::kSCALE, AnimationClip::Sampler::kSTEP, [](float t) { return Vector4(std::floor(t), 1.0f, 1.0f, 0.0f); });
+    addChannel(2, AnimationClip::Channel::kROTATION, AnimationClip::Sampler::kLINEAR, [&](float) {
+        return Vector4::normalize(Vector4(dist(rng), dist(rng), dist(rng), dist(rng)));
+    });
+
+    AnimationCompressionOptions options;
+    AnimationCompressionStats stats;
+    CompressedAnimationClip compressed = compressAnimation(clip, options, &stats);
+
+    using Sampler = AnimationClip::Sampler;
+    using Channel = AnimationClip::Channel;
+    ASSERT_EQ(2u, compressed.tracks[Sampler::kLINEAR * 3 + Channel::kTRANSLATION].size());
+    EXPECT_EQ(2u, compressed.tracks[Sampler::kLINEAR * 3 + Channel::kTRANSLATION][0].numKeys);
+    EXPECT_EQ(2u, compressed.tracks[Sampler::kLINEAR * 3 + Channel::kROTATION][0].numKeys);
+    EXPECT_EQ(1u, compressed.tracks[Sampler::kLINEAR * 3 + Channel::kSCALE][0].numKeys);
+    EXPECT_EQ(11u, compressed.tracks[Sampler::kSTEP * 3 + Channel::kSCALE][0].numKeys);
+    EXPECT_EQ(301u, compressed.tracks[Sampler::kLINEAR * 3 + Channel::kROTATION][1].numKeys);
+    EXPECT_LT(compressed.tracks[Sampler::kLINEAR * 3 + Channel::kTRANSLATION][1].numKeys, 150u);
+
+    EXPECT_EQ(6u * 301u, stats.originalKeys);
+    EXPECT_EQ(compressed.times.size(), stats.compressedKeys);
+    EXPECT_EQ(compressed.getSizeInBytes(), stats.compressedBytes);
+    EXPECT_GT(stats.ratio, 2.0f);
+    EXPECT_LT(stats.maxTranslationError, options.translationError + 1e-4f);
+    EXPECT_LT(stats.maxRotationError, options.rotationError + 2e-4f);
+    EXPECT_LT(stats.maxScaleError, options.scaleError + 1e-4f);
+
+    // played back directly
+    std::vector<Node> original(3);
+    std::vector<Node> decoded(3);
+    for (float t = 0.0f; t < 10.0f; t += 0.37f)
+    {
+        animate(clip, original, t);
+        animate(compressed, decoded, t);
+        for (int n = 0; n < 3; ++n)
+        {
+            EXPECT_NEAR(original[n].position.x, decoded[n].position.x, 2e-3f) << t;
+            EXPECT_NEAR(original[n].position.y, decoded[n].position.y, 2e-3f) << t;
+            EXPECT_NEAR(original[n].scale.x, decoded[n].scale.x, 1e-3f) << t;
+            EXPECT_LT(angle(original[n].rotation, decoded[n].rotation), 2e-3f) << t;
+        }
+    }
+}
+
+TEST(Squirtle, PoseBlending)
+{
+    using namespace kame::squirtle;
+
+    auto makeClip = [](int node, AnimationClip::Channel::PathType path, std::vector<Vector4> outputs) {
+        AnimationClip clip;
+        clip.startTime = 0.0f;
+        clip.endTime = 2.0f;
+        clip.channels.push_back({node, path, 0});
+        clip.samplers.emplace_back();
+        clip.samplers[0].interpolation = AnimationClip::Sampler::kLINEAR;
+        clip.samplers[0].inputs = {0.0f, 2.0f};
+        clip.samplers[0].outputsVec4 = std::move(outputs);
+        return clip;
+    };
+    AnimationClip walkX = makeClip(0, AnimationClip::Channel::kTRANSLATION, {Vector4(0.0f, 0.0f, 0.0f, 0.0f), Vector4(2.0f, 0.0f, 0.0f, 0.0f)});
+    AnimationClip walkY = makeClip(0, AnimationClip::Channel::kTRANSLATION, {Vector4(0.0f, 0.0f, 0.0f, 0.0f), Vector4(0.0f, 2.0f, 0.0f, 0.0f)});
+    const float s30 = std::sin(helper::toRadians(30.0f));
+    const float c30 = std::cos(helper::toRadians(30.0f));
+    // turns node 1 by 60 degrees around z
+    AnimationClip turn = makeClip(1, AnimationClip::Channel::kROTATION, {Vector4(0.0f, 0.0f, 0.0f, 1.0f), Vector4(0.0f, 0.0f, s30, c30)});
+
+    std::vector<Node> nodes(2);
+    nodes[1].position = Vector3(0.0f, 5.0f, 0.0f);
+
+    Pose a, b;
+    readPose(nodes, a);
+    readPose(nodes, b);
+    samplePose(walkX, 1.0f, a);
+    samplePose(walkY, 2.0f, b);
+    EXPECT_EQ(1.0f, a.positions[0].x);
+    EXPECT_EQ(5.0f, a.positions[1].y);
+    blendPose(a, b, 0.25f, a);
+    EXPECT_NEAR(0.75f, a.positions[0].x, 1e-6f);
+    EXPECT_NEAR(0.5f, a.positions[0].y, 1e-6f);
+    std::vector<float> mask = {0.0f, 1.0f};
+    blendPose(a, b, 1.0f, a, mask);
+    EXPECT_NEAR(0.75f, a.positions[0].x, 1e-6f);
+
+    // the additive turn stacks on whatever rotation the base has
+    Pose base, turned, reference;
+    readPose(nodes, base);
+    readPose(nodes, reference);
+    base.rotations[1] = Quaternion(0.0f, 0.0f, s30, c30);
+    turned = reference;
+    samplePose(turn, 2.0f, turned);
+    addPose(base, turned, reference, 0.5f, base);
+    EXPECT_NEAR(std::sin(helper::toRadians(45.0f)), base.rotations[1].z, 1e-5f);
+    EXPECT_NEAR(std::cos(helper::toRadians(45.0f)), base.rotations[1].w, 1e-5f);
+    EXPECT_EQ(5.0f, base.positions[1].y);
+
+    // crossfade, then an additive layer, written once to the nodes
+    Animator animator;
+    animator.init(nodes);
+    animator.play(walkX);
+    animator.update(0.5f);
+    animator.apply(nodes);
+    EXPECT_NEAR(0.5f, nodes[0].position.x, 1e-6f);
+
+    const void* buffers[] = {animator.pose.positions.data(), animator.basePose.rotations.data(), animator.fadePose.scales.data(), animator.layerPose.positions.data()};
+    animator.play(walkY, 1.0f);
+    animator.update(0.5f);
+    animator.apply(nodes);
+    EXPECT_NEAR(0.5f, nodes[0].position.x, 1e-6f);
+    EXPECT_NEAR(0.25f, nodes[0].position.y, 1e-6f);
+    animator.update(0.6f);
+    animator.apply(nodes);
+    EXPECT_EQ(0.0f, nodes[0].position.x);
+    EXPECT_NEAR(1.1f, nodes[0].position.y, 1e-6f);
+
+    animator.addLayer(turn, 1.0f, true);
+    animator.update(0.5f);
+    animator.apply(nodes);
+    EXPECT_NEAR(1.6f, nodes[0].position.y, 1e-6f);
+    EXPECT_NEAR(std::sin(helper::toRadians(7.5f)), nodes[1].rotation.z, 1e-5f);
+    EXPECT_EQ(5.0f, nodes[1].position.y);
+
+    animator.update(1.0f);
+    EXPECT_NEAR(0.6f, animator.pose.positions[0].y, 1e-5f);
+    const void* after[] = {animator.pose.positions.data(), animator.basePose.rotations.data(), animator.fadePose.scales.data(), animator.layerPose.positions.data()};
+    for (int i = 0; i < 4; ++i)
+    {
+        EXPECT_EQ(buffers[i], after[i]) << i;
+    }
+}
+
+TEST(Squirtle, TransformHierarchy)
+{
+    using namespace kame::squirtle;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    auto expectNear = [](const Matrix& a, const Matrix& b, int id) {
+        const float* pa = &a.m11;
+        const float* pb = &b.m11;
+        for (int k = 0; k < 16; ++k)
+        {
+            EXPECT_NEAR(pa[k], pb[k], 1e-4f) << id << " " << k;
+        }
+    };
+
+    // the general quaternion form matches Matrix for any length
+    Quaternion q(0.3f, -0.2f, 0.5f, 0.9f);
+    Vector3 t(1.0f, 2.0f, 3.0f);
+    Vector3 s(0.5f, 2.0f, -1.0f);
+    expectNear(Matrix::createScale(s) * Matrix::createFromQuaternion(q) * Matrix::createTranslation(t), Affine3x4::compose(t, q, s).toMatrix(), -1);
+
+    // a random forest, children listed after their parent in id order or not
+    std::vector<Node> nodes(200);
+    for (int i = 0; i < 200; ++i)
+    {
+        Node& n = nodes[i];
+        n.position = Vector3(dist(rng), dist(rng), dist(rng));
+        n.rotation = Quaternion::normalize(Quaternion(dist(rng), dist(rng), dist(rng), dist(rng)));
+        n.scale = Vector3(1.0f + 0.2f * dist(rng), 1.0f, 1.0f - 0.2f * dist(rng));
+        if (i % 37 != 0)
+        {
+            n.parent = int(std::uniform_int_distribution<int>(0, 199)(rng) % i);
+        }
+    }
+    // a parent after its child
+    nodes[150].parent = -1;
+    nodes[10].parent = 150;
+    for (int i = 0; i < 200; ++i)
+    {
+        if (nodes[i].parent >= 0)
+        {
+            nodes[nodes[i].parent].children.emplace_back(i);
+        }
+    }
+
+    auto reference = [&](int id) {
+        Matrix global = Matrix::identity();
+        for (int k = id; k >= 0; k = nodes[k].parent)
+        {
+            global = global * nodes[k].updateLocalXForm();
+        }
+        return global;
+    };
+
+    TransformHierarchy h;
+    h.build(nodes);
+    EXPECT_EQ(200u, h.update());
+    for (uint32_t i = 0; i < h.size(); ++i)
+    {
+        if (h.parents[i] >= 0)
+        {
+            EXPECT_LT(uint32_t(h.parents[i]), i);
+            EXPECT_LE(h.subtreeEnds[i], h.subtreeEnds[h.parents[i]]);
+        }
+    }
+    for (int id = 0; id < 200; ++id)
+    {
+        expectNear(reference(id), h.getWorld(id).toMatrix(), id);
+    }
+
+    // static frames touch nothing, a moved node recomputes exactly its subtree
+    EXPECT_EQ(0u, h.update());
+    int moved = nodes[10].parent;
+    nodes[moved].position = Vector3(5.0f, 0.0f, 0.0f);
+    h.setLocal(moved, nodes[moved].position, nodes[moved].rotation, nodes[moved].scale);
+    uint32_t index = h.indices[moved];
+    EXPECT_EQ(h.subtreeEnds[index] - index, h.update());
+    for (int id = 0; id < 200; ++id)
+    {
+        expectNear(reference(id), h.getWorld(id).toMatrix(), id);
+    }
+}
+
+TEST(Squirtle, IncrementalUpdate)
+{
+    using namespace kame::squirtle;
+
+    // a static building with a door, and a skinned arm whose joints hang off the root
+    Model model;
+    model._isSkinnedMesh = true;
+    model.meshes.resize(2);
+    Primitive pri;
+    pri.positions = {Vector3(0.0f, 0.0f, 0.0f), Vector3(1.0f, 0.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f)};
+    pri.indices = {0, 1, 2};
+    pri.joints.assign(3, u16Array4{0, 1, 0, 0});
+    pri.weights.assign(3, Vector4(0.5f, 0.5f, 0.0f, 0.0f));
+    pri.bounds = computeAABB(pri.positions);
+    pri.jointBounds = {pri.bounds, pri.bounds};
+    model.meshes[0].primitives.emplace_back(pri);
+    model.meshes[1].primitives.emplace_back(pri);
+
+    // 0 root, 1 wall, 2 door on the wall, 3 skinned arm, 4 and 5 its joints
+    model.nodes.resize(6);
+    for (int i : {1, 4})
+    {
+        model.nodes[i].parent = 0;
+        model.nodes[0].children.emplace_back(i);
+    }
+    model.nodes[2].parent = 1;
+    model.nodes[1].children.emplace_back(2);
+    model.nodes[5].parent = 4;
+    model.nodes[4].children.emplace_back(5);
+    model.nodes[2].meshID = 1;
+    model.nodes[3].meshID = 0;
+    model.nodes[3].skinID = 0;
+    model.skins.resize(1);
+    model.skins[0].joints = {4, 5};
+    model.skins[0].inverseBindMatrices = {Matrix::identity(), Matrix::identity()};
+    model.skins[0].matrices.resize(2);
+
+    std::vector<Vector3> positions;
+    auto update = [&] {
+        model.update(positions, [](const UpdateData&) {});
+        size_t numChanged = 0;
+        for (uint8_t c : model.transforms.changed)
+        {
+            numChanged += c;
+        }
+        return numChanged;
+    };
+    EXPECT_EQ(6u, update());
+    EXPECT_TRUE(model.skins[0]._changed);
+
+    // nothing moved, nothing is recomputed
+    EXPECT_EQ(0u, update());
+    EXPECT_FALSE(model.skins[0]._changed);
+
+    // opening the door only touches the door and its bounds
+    AABB closed = model.nodes[2].worldBounds;
+    model.setLocalTransform(2, Vector3(0.0f, 0.0f, 3.0f), Quaternion::identity(), Vector3::one());
+    EXPECT_EQ(1u, update());
+    EXPECT_FALSE(model.skins[0]._changed);
+    EXPECT_EQ(closed.min.z + 3.0f, model.nodes[2].worldBounds.min.z);
+    EXPECT_EQ(3.0f, model.nodes[2].globalXForm.m43);
+
+    // moving the wall carries the door along
+    model.setLocalTransform(1, Vector3(1.0f, 0.0f, 0.0f), Quaternion::identity(), Vector3::one());
+    EXPECT_EQ(2u, update());
+    EXPECT_EQ(1.0f, model.nodes[2].globalXForm.m41);
+
+    // a joint written directly rebuilds the skin too
+    model.nodes[5].position = Vector3(0.0f, 1.0f, 0.0f);
+    EXPECT_EQ(1u, update());
+    EXPECT_TRUE(model.skins[0]._changed);
+    EXPECT_EQ(1.0f, model.skins[0].matrices[1].m42);
+    EXPECT_EQ(1.0f, model.nodes[3].jointMatrices[1].m42);
+
+    // animation marks what it animates
+    AnimationClip clip;
+    clip.channels.push_back({4, AnimationClip::Channel::kTRANSLATION, 0});
+    clip.samplers.emplace_back();
+    clip.samplers[0].interpolation = AnimationClip::Sampler::kLINEAR;
+    clip.samplers[0].inputs = {0.0f, 1.0f};
+    clip.samplers[0].outputsVec4 = {Vector4(0.0f, 0.0f, 0.0f, 0.0f), Vector4(2.0f, 0.0f, 0.0f, 0.0f)};
+    clip.startTime = 0.0f;
+    clip.endTime = 1.0f;
+    animate(clip, model, 0.5f);
+    EXPECT_EQ(2u, update());
+    EXPECT_EQ(1.0f, model.skins[0].matrices[0].m41);
+
+    // so does animating the node vector, and a forced recompute without a change
+    animate(clip, model.nodes, 1.0f);
+    EXPECT_EQ(2u, update());
+    EXPECT_EQ(2.0f, model.skins[0].matrices[0].m41);
+    model.markDirty(1);
+    EXPECT_EQ(2u, update());
+}
+
+#include <kame/squirtle/render_queue.hpp>
+
+TEST(Squirtle, RenderQueue)
+{
+    using namespace kame::squirtle;
+
+    uint64_t key = makeSortKey(3, 700, 9000, 40000, 123456);
+    EXPECT_EQ(3u, getSortKeyPass(key));
+    EXPECT_EQ(700u, getSortKeyShader(key));
+    EXPECT_EQ(9000u, getSortKeyMaterial(key));
+    EXPECT_EQ(40000u, getSortKeyTexture(key));
+    EXPECT_EQ(123456u, getSortKeyDepth(key));
+    EXPECT_LT(quantizeSortDepth(1.0f, 0.1f, 100.0f), quantizeSortDepth(2.0f, 0.1f, 100.0f));
+    EXPECT_GT(quantizeSortDepth(1.0f, 0.1f, 100.0f, true), quantizeSortDepth(2.0f, 0.1f, 100.0f, true));
+
+    // same order as a stable sort, whatever bytes the keys differ in
+    RenderQueue queue;
+    uint32_t seed = 1;
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        queue.push(makeSortKey(seed % 2, (seed >> 4) % 3, (seed >> 8) % 5, (seed >> 12) % 4, seed >> 12), i);
+    }
+    std::vector<DrawPacket> expected = queue.packets;
+    std::stable_sort(expected.begin(), expected.end(), [](const DrawPacket& a, const DrawPacket& b) { return a.key < b.key; });
+    queue.sort();
+    ASSERT_EQ(expected.size(), queue.packets.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        EXPECT_EQ(expected[i].key, queue.packets[i].key);
+        EXPECT_EQ(expected[i].index, queue.packets[i].index);
+    }
+
+    // changes are reported per field, the first draw sets everything
+    queue.clear();
+    queue.push(makeSortKey(0, 1, 1, 2, 5), 0);
+    queue.push(makeSortKey(1, 0, 0, 0, 0), 1);
+    queue.push(makeSortKey(0, 1, 1, 1, 9), 2);
+    queue.push(makeSortKey(0, 1, 2, 1, 0), 3);
+    queue.push(makeSortKey(0, 1, 1, 1, 1), 4);
+    queue.sort();
+    std::vector<uint32_t> order;
+    std::vector<uint32_t> changes;
+    queue.submit([&](const DrawPacket& p, uint32_t c) {
+        order.push_back(p.index);
+        changes.push_back(c);
+    });
+    EXPECT_EQ((std::vector<uint32_t>{4, 2, 0, 3, 1}), order);
+    const uint32_t all = kRENDER_CHANGE_PASS | kRENDER_CHANGE_SHADER | kRENDER_CHANGE_MATERIAL | kRENDER_CHANGE_TEXTURE;
+    EXPECT_EQ((std::vector<uint32_t>{all, 0, kRENDER_CHANGE_TEXTURE, kRENDER_CHANGE_MATERIAL | kRENDER_CHANGE_TEXTURE, all}), changes);
+    EXPECT_EQ(5u, queue.stats.draws);
+    EXPECT_EQ(2u, queue.stats.passChanges);
+    EXPECT_EQ(2u, queue.stats.shaderChanges);
+    EXPECT_EQ(3u, queue.stats.materialChanges);
+    EXPECT_EQ(4u, queue.stats.textureChanges);
+}
+
+TEST(Squirtle, ScenePack)
+{
+    using namespace kame::squirtle;
+
+    Model model;
+    model.materials.resize(2);
+    model.materials[1].baseColorTextureIndex = 0;
+    model.materials[1].baseColorTexCoord = 1;
+    model.meshes.resize(2);
+    for (int material : {1, 0})
+    {
+        Primitive pri;
+        pri.positions = {Vector3(0.0f, 0.0f, 0.0f), Vector3(1.0f, 0.0f, 0.0f), Vector3(0.0f, 1.0f, 0.0f)};
+        pri.uvSets = {std::vector<Vector2>(3, Vector2(0.25f, 0.25f)), std::vector<Vector2>(3, Vector2(0.5f, 0.5f))};
+        pri.indices = {0, 1, 2};
+        pri.material = material;
+        model.meshes[0].primitives.emplace_back(pri);
+    }
+    Primitive lines;
+    lines.positions = {Vector3::zero(), Vector3::one()};
+    lines.indices = {0, 1};
+    lines.mode = GL_LINES;
+    model.meshes[1].primitives.emplace_back(lines);
+
+    // mesh 0 instanced by two nodes, mesh 1 has nothing to pack
+    model.nodes.resize(4);
+    model.nodes[0].meshID = 0;
+    model.nodes[2].meshID = 0;
+    model.nodes[3].meshID = 1;
+
+    ScenePack pack = packScene(model);
+    EXPECT_EQ(6u, pack.positions.size());
+    EXPECT_EQ(6u, pack.uvs.size());
+    EXPECT_EQ(6u, pack.indices.size());
+    EXPECT_EQ(1u, pack.numSkipped);
+    ASSERT_EQ(4u, pack.draws.size());
+
+    // ordered by material, the instances share their vertices
+    EXPECT_EQ(0, pack.draws[0].material);
+    EXPECT_EQ(0, pack.draws[1].material);
+    EXPECT_EQ(1, pack.draws[2].material);
+    EXPECT_EQ(1, pack.draws[3].material);
+    EXPECT_EQ(0, pack.draws[0].node);
+    EXPECT_EQ(2, pack.draws[1].node);
+    EXPECT_EQ(1, pack.draws[0].primitive);
+    EXPECT_EQ(pack.draws[0].baseVertex, pack.draws[1].baseVertex);
+    EXPECT_EQ(pack.draws[2].firstIndex, pack.draws[3].firstIndex);
+    EXPECT_EQ(3, pack.draws[0].baseVertex);
+    EXPECT_EQ(3u, pack.draws[0].firstIndex);
+    EXPECT_EQ(3u, pack.draws[0].indexCount);
+
+    // the textured material reads its own texcoord set, the other one set 0
+    EXPECT_EQ(0.5f, pack.uvs[0].x);
+    EXPECT_EQ(0.25f, pack.uvs[3].x);
+
+    // skinned nodes are left to the regular path
+    model.nodes[2].skinID = 0;
+    pack = packScene(model);
+    EXPECT_EQ(2u, pack.draws.size());
+    EXPECT_EQ(3u, pack.numSkipped);
+
+    // so is a textured primitive without its texcoord set, the untextured one packs with zero texcoords
+    for (Primitive& pri : model.meshes[0].primitives)
+    {
+        pri.uvSets.clear();
+    }
+    pack = packScene(model);
+    ASSERT_EQ(1u, pack.draws.size());
+    EXPECT_EQ(0, pack.draws[0].material);
+    EXPECT_EQ(4u, pack.numSkipped);
+    EXPECT_EQ(3u, pack.uvs.size());
+    EXPECT_EQ(0.0f, pack.uvs[0].x);
+}
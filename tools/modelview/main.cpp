@@ -96,6 +96,30 @@ void main() {
 }
 )";
 
+// kame::squirtle::kSKINNING_GPU, joints and weights come from PackedVertices
+const char* vertSkinGLSL = R"(#version 330
+in vec3 vPos;
+in vec2 vUV;
+in uvec4 vJoints;
+in vec4 vWeights;
+layout(std140) uniform Joints {
+    mat4 uJoints[256];
+};
+uniform mat4 uModel;
+uniform mat4 uView;
+uniform mat4 uProj;
+out vec2 pUV;
+void main() {
+    mat4 skin = uJoints[vJoints.x] * vWeights.x
+              + uJoints[vJoints.y] * vWeights.y
+              + uJoints[vJoints.z] * vWeights.z
+              + uJoints[vJoints.w] * vWeights.w;
+    mat4 MVP = uProj * uView * uModel;
+    gl_Position = MVP * skin * vec4(vPos, 1.0);
+    pUV = vUV;
+}
+)";
+
 const char* drawLinesGLSL = R"(#version 330
 out vec4 fragColor;
 void main() {
@@ -103,88 +127,427 @@ void main() {
 }
 )";
 
-kame::ogl::VertexBuffer* gVBO = nullptr;
-kame::ogl::VertexBuffer* gVBOTexCoord = nullptr;
-kame::ogl::IndexBuffer* gIBO = nullptr;
+// static models on GL 4.3, kame::squirtle::ScenePack buffers drawn with one indirect multi draw per texture.
+// vDrawID is the baseInstance of the draw and selects its world matrix and base color factor.
+const char* vertPackGLSL = R"(#version 430
+layout(location = 0) in vec3 vPos;
+layout(location = 1) in vec2 vUV;
+layout(location = 2) in float vDrawID;
+struct Draw {
+    mat4 world;
+    vec4 baseColorFactor;
+};
+layout(std430, binding = 0) readonly buffer Draws {
+    Draw uDraws[];
+};
+uniform mat4 uModel;
+uniform mat4 uView;
+uniform mat4 uProj;
+out vec2 pUV;
+flat out vec4 pBaseColorFactor;
+void main() {
+    Draw d = uDraws[int(vDrawID)];
+    mat4 MVP = uProj * uView * uModel;
+    gl_Position = MVP * d.world * vec4(vPos, 1.0);
+    pUV = vUV;
+    pBaseColorFactor = d.baseColorFactor;
+}
+)";
+
+const char* fragPackTexGLSL = R"(#version 430
+in vec2 pUV;
+flat in vec4 pBaseColorFactor;
+uniform sampler2D uTex;
+out vec4 fragColor;
+void main() {
+    fragColor = texture(uTex, pUV) * pBaseColorFactor;
+}
+)";
+
+// per frame positions, uvs and indices of every drawn primitive
+kame::ogl::StreamingBuffer* gStream = nullptr;
 std::vector<kame::math::Vector3> gPositions;
-std::vector<kame::math::Vector2> gUV;
-std::vector<unsigned int> gIndices;
 
 std::vector<kame::ogl::Texture2D*> gTextures;
 
 kame::ogl::Shader* gShaderFrontFace = nullptr;
 kame::ogl::Shader* gShaderTexture = nullptr;
 kame::ogl::Shader* gShaderDrawLines = nullptr;
-bool isEdgeLines = false;
+kame::ogl::Shader* gShaderSkin = nullptr;
+kame::ogl::Shader* gShaderSkinTexture = nullptr;
+kame::ogl::Shader* gShaderSkinDrawLines = nullptr;
+// static buffers of skinned primitives, indexed by Primitive::id
+struct SkinnedPrimitive {
+    kame::squirtle::PackedVertices packed;
+    kame::ogl::VertexBuffer* vbo = nullptr;
+    kame::ogl::IndexBuffer* ibo = nullptr;
+};
+std::vector<SkinnedPrimitive> gSkinnedPrimitives;
+kame::ogl::UniformBuffer* gUBOJoints = nullptr;
+
+// std430 element of the Draws block
+struct PackDraw {
+    kame::math::Matrix world;
+    kame::math::Vector4 baseColorFactor;
+};
+static_assert(sizeof(PackDraw) == 80);
+
+// the scene uploaded once, Model::update() and the stream are skipped while it is in use
+struct ScenePackGL {
+    // draws [first, first + count) of the commands sharing a texture, nullptr for the untextured ones
+    struct Group {
+        kame::ogl::Texture2D* texture;
+        GLsizei first;
+        GLsizei count;
+    };
+    kame::ogl::VertexBuffer* positions = nullptr;
+    kame::ogl::VertexBuffer* uvs = nullptr;
+    kame::ogl::VertexBuffer* drawIDs = nullptr;
+    kame::ogl::IndexBuffer* indices = nullptr;
+    kame::ogl::IndirectBuffer* commands = nullptr;
+    kame::ogl::ShaderStorageBuffer* draws = nullptr;
+    kame::ogl::VertexArrayObject vao;
+    std::vector<Group> groups;
+    GLsizei numDraws = 0;
+};
+ScenePackGL gPack;
+kame::ogl::Shader* gShaderPack = nullptr;
+kame::ogl::Shader* gShaderPackTexture = nullptr;
+kame::ogl::Shader* gShaderPackDrawLines = nullptr;
 
 using namespace kame::math;
 using namespace kame::math::helper;
 
-void drawModelWithTexture(const kame::squirtle::UpdateData& drawData)
+// the fill pass draws first, the edge lines go on top of it
+enum RenderPass {
+    kPASS_FILL,
+    kPASS_EDGE_LINES,
+};
+
+// sort key ids of the shaders
+enum ShaderSlot {
+    kSHADER_FRONT_FACE,
+    kSHADER_TEXTURE,
+    kSHADER_DRAW_LINES,
+    kSHADER_SKIN,
+    kSHADER_SKIN_TEXTURE,
+    kSHADER_SKIN_DRAW_LINES,
+};
+
+// a draw collected from Model::update(), submitted after the render queue sorted them
+struct DrawItem {
+    kame::ogl::Shader* shader = nullptr;
+    kame::ogl::Texture2D* texture = nullptr;
+    kame::math::Vector4 baseColorFactor;
+    kame::ogl::VertexArrayObject vao;
+    GLenum mode = GL_TRIANGLES;
+    GLsizei count = 0;
+    std::span<const kame::math::Matrix> jointMatrices; // Node::jointMatrices, valid until the next update
+};
+// reused across frames so the vertex array objects keep their attribute storage
+std::vector<DrawItem> gDrawItems;
+size_t gNumDrawItems = 0;
+kame::squirtle::RenderQueue gRenderQueue;
+kame::math::Matrix gModelView; // for the depth of the sort keys
+
+DrawItem& pushDrawItem(uint32_t pass, uint32_t shader, uint32_t material, uint32_t texture, uint32_t depth)
+{
+    if (gNumDrawItems == gDrawItems.size())
+    {
+        gDrawItems.emplace_back();
+    }
+    gRenderQueue.push(kame::squirtle::makeSortKey(pass, shader, material, texture, depth), uint32_t(gNumDrawItems));
+    DrawItem& item = gDrawItems[gNumDrawItems++];
+    item.texture = nullptr;
+    item.jointMatrices = {};
+    return item;
+}
+
+void collectSkinnedModel(const kame::squirtle::UpdateData& drawData, uint32_t depth)
 {
-    const std::vector<kame::math::Vector3>& positions = drawData.positions;
     const kame::squirtle::Model& model = drawData.model;
     const kame::squirtle::Primitive& pri = drawData.primitive;
+    const SkinnedPrimitive& sp = gSkinnedPrimitives[pri.id];
 
-    assert(pri.material < model.materials.size());
-    kame::squirtle::Material mat = model.materials[pri.material];
-    gShaderTexture->setVector4("uBaseColorFactor", mat.baseColorFactor);
-
-    assert(mat.baseColorTextureIndex >= 0 && mat.baseColorTextureIndex < gTextures.size());
-    assert(gTextures[mat.baseColorTextureIndex]);
-    kame::ogl::setTexture2D(0, gTextures[mat.baseColorTextureIndex]);
-
-    gVBO->setBuffer(positions);
-
-    assert(mat.baseColorTexCoord >= 0 && mat.baseColorTexCoord < pri.uvSets.size());
-    auto& uvSet = pri.getUvSets()[mat.baseColorTexCoord];
-    std::copy(uvSet.begin(), uvSet.end(), gUV.begin());
-    gVBOTexCoord->setBuffer(gUV);
+    // only the coarser levels of detail need their indices uploaded
+    kame::ogl::StreamingBuffer::Allocation lodIndices;
+    if (drawData.lod != 0)
+    {
+        lodIndices = gStream->upload(drawData.indices.data(), drawData.indices.size() * sizeof(unsigned int));
+        if (lodIndices.numBytes == 0)
+        {
+            return;
+        }
+    }
 
-    std::copy(pri.getIndices().begin(), pri.getIndices().end(), gIndices.begin());
-    gIBO->setBuffer(gIndices);
+    auto bind = [&](DrawItem& item) {
+        std::array<GLint, kame::squirtle::kVERTEX_ATTRIBUTE_COUNT> locations;
+        locations.fill(-1);
+        locations[kame::squirtle::kVERTEX_ATTRIBUTE_POSITION] = item.shader->getAttribLocation("vPos");
+        locations[kame::squirtle::kVERTEX_ATTRIBUTE_UV0] = item.shader->getAttribLocation("vUV");
+        locations[kame::squirtle::kVERTEX_ATTRIBUTE_JOINTS] = item.shader->getAttribLocation("vJoints");
+        locations[kame::squirtle::kVERTEX_ATTRIBUTE_WEIGHTS] = item.shader->getAttribLocation("vWeights");
+
+        item.vao.begin();
+        kame::squirtle::bindPackedVertices(item.vao, sp.vbo, sp.packed, locations);
+        if (drawData.lod != 0)
+        {
+            item.vao.bindIndexBuffer(gStream, lodIndices);
+        }
+        else
+        {
+            item.vao.bindIndexBuffer(sp.ibo);
+        }
+        item.vao.end();
+        item.mode = pri.mode;
+        item.count = GLsizei(drawData.indices.size());
+        item.jointMatrices = drawData.jointMatrices;
+    };
+
+    bool isTextured = pri.material >= 0 && model.materials[pri.material].baseColorTextureIndex >= 0 && sp.packed.hasAttribute(kame::squirtle::kVERTEX_ATTRIBUTE_UV0);
+    if (isTextured)
+    {
+        const kame::squirtle::Material& mat = model.materials[pri.material];
+        DrawItem& item = pushDrawItem(kPASS_FILL, kSHADER_SKIN_TEXTURE, pri.material + 1, mat.baseColorTextureIndex + 1, depth);
+        item.shader = gShaderSkinTexture;
+        item.texture = gTextures[mat.baseColorTextureIndex];
+        item.baseColorFactor = mat.baseColorFactor;
+        bind(item);
+    }
+    else
+    {
+        DrawItem& item = pushDrawItem(kPASS_FILL, kSHADER_SKIN, 0, 0, depth);
+        item.shader = gShaderSkin;
+        bind(item);
+    }
 
-    kame::ogl::VertexArrayObject vao;
-    vao.begin()
-        .bindAttribute(gVBO, gShaderTexture->getAttribLocation("vPos"), 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), 0)
-        .bindAttribute(gVBOTexCoord, gShaderTexture->getAttribLocation("vUV"), 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), 0)
-        .bindIndexBuffer(gIBO)
-        .end();
-    vao.drawElements(pri.mode, pri.getIndices().size(), GL_UNSIGNED_INT);
+    DrawItem& edge = pushDrawItem(kPASS_EDGE_LINES, kSHADER_SKIN_DRAW_LINES, 0, 0, depth);
+    edge.shader = gShaderSkinDrawLines;
+    bind(edge);
 }
 
-void drawModel(const kame::squirtle::UpdateData& drawData)
+// uploads the primitive once and queues its fill and edge line draws
+void collectModel(const kame::squirtle::UpdateData& drawData)
 {
+    uint32_t depth = kame::squirtle::quantizeSortDepth(-Vector3::transform(drawData.bounds.getCenter(), gModelView).z, 0.1f, 100.0f);
+    if (!drawData.jointMatrices.empty())
+    {
+        collectSkinnedModel(drawData, depth);
+        return;
+    }
+
     const std::vector<kame::math::Vector3>& positions = drawData.positions;
     const kame::squirtle::Model& model = drawData.model;
     const kame::squirtle::Primitive& pri = drawData.primitive;
 
-    if (!isEdgeLines && pri.material >= 0 && model.materials[pri.material].baseColorTextureIndex >= 0)
+    auto pos = gStream->upload(positions.data(), pri.getPositions().size() * sizeof(kame::math::Vector3));
+    auto indices = gStream->upload(drawData.indices.data(), drawData.indices.size() * sizeof(unsigned int));
+    if (pos.numBytes == 0 || indices.numBytes == 0)
     {
-        kame::ogl::setShader(gShaderTexture);
-        drawModelWithTexture(drawData);
+        // the stream is full this frame, the primitive is not drawn
         return;
     }
+    GLint posLocation = gShaderTexture->getAttribLocation("vPos");
 
-    if (isEdgeLines)
+    if (pri.material >= 0 && model.materials[pri.material].baseColorTextureIndex >= 0)
     {
-        kame::ogl::setShader(gShaderDrawLines);
+        const kame::squirtle::Material& mat = model.materials[pri.material];
+        assert(mat.baseColorTextureIndex < gTextures.size());
+        assert(gTextures[mat.baseColorTextureIndex]);
+        assert(mat.baseColorTexCoord >= 0 && mat.baseColorTexCoord < pri.uvSets.size());
+        auto& uvSet = pri.getUvSets()[mat.baseColorTexCoord];
+        auto uv = gStream->upload(uvSet.data(), uvSet.size() * sizeof(kame::math::Vector2));
+        if (uv.numBytes == 0)
+        {
+            return;
+        }
+
+        DrawItem& item = pushDrawItem(kPASS_FILL, kSHADER_TEXTURE, pri.material + 1, mat.baseColorTextureIndex + 1, depth);
+        item.shader = gShaderTexture;
+        item.texture = gTextures[mat.baseColorTextureIndex];
+        item.baseColorFactor = mat.baseColorFactor;
+        item.vao.begin()
+            .bindAttribute(gStream, posLocation, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), pos)
+            .bindAttribute(gStream, gShaderTexture->getAttribLocation("vUV"), 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), uv)
+            .bindIndexBuffer(gStream, indices)
+            .end();
+        item.mode = pri.mode;
+        item.count = GLsizei(drawData.indices.size());
     }
     else
     {
-        kame::ogl::setShader(gShaderFrontFace);
+        DrawItem& item = pushDrawItem(kPASS_FILL, kSHADER_FRONT_FACE, 0, 0, depth);
+        item.shader = gShaderFrontFace;
+        item.vao.begin()
+            .bindAttribute(gStream, posLocation, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), pos)
+            .bindIndexBuffer(gStream, indices)
+            .end();
+        item.mode = pri.mode;
+        item.count = GLsizei(drawData.indices.size());
     }
 
-    std::copy(pri.getIndices().begin(), pri.getIndices().end(), gIndices.begin());
+    DrawItem& edge = pushDrawItem(kPASS_EDGE_LINES, kSHADER_DRAW_LINES, 0, 0, depth);
+    edge.shader = gShaderDrawLines;
+    edge.vao.begin()
+        .bindAttribute(gStream, posLocation, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), pos)
+        .bindIndexBuffer(gStream, indices)
+        .end();
+    edge.mode = pri.mode;
+    edge.count = GLsizei(drawData.indices.size());
+}
 
-    gVBO->setBuffer(positions);
-    gIBO->setBuffer(gIndices);
-    kame::ogl::VertexArrayObject vao;
-    vao.begin()
-        .bindAttribute(gVBO, gShaderTexture->getAttribLocation("vPos"), 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), 0)
-        .bindIndexBuffer(gIBO)
+// wireframe on top of the filled triangles
+void beginEdgeLines()
+{
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    glDepthMask(GL_FALSE);
+    glEnable(GL_POLYGON_OFFSET_LINE);
+    glPolygonOffset(0.0f, -40.0f);
+    kame::ogl::setDepthStencilState(kame::ogl::DepthStencilStateBuilder().depthFunc(GL_LEQUAL).build());
+}
+
+// draws the queue in key order, binding only what changed between draws
+void submitDraws()
+{
+    gRenderQueue.sort();
+    gRenderQueue.submit([](const kame::squirtle::DrawPacket& packet, uint32_t changes) {
+        DrawItem& item = gDrawItems[packet.index];
+        if ((changes & kame::squirtle::kRENDER_CHANGE_PASS) && kame::squirtle::getSortKeyPass(packet.key) == kPASS_EDGE_LINES)
+        {
+            beginEdgeLines();
+        }
+        if (changes & kame::squirtle::kRENDER_CHANGE_SHADER)
+        {
+            kame::ogl::setShader(item.shader);
+        }
+        // uniforms belong to the program, a new shader needs the factor again
+        if (item.texture && (changes & (kame::squirtle::kRENDER_CHANGE_SHADER | kame::squirtle::kRENDER_CHANGE_MATERIAL)))
+        {
+            item.shader->setVector4("uBaseColorFactor", item.baseColorFactor);
+        }
+        if (item.texture && (changes & kame::squirtle::kRENDER_CHANGE_TEXTURE))
+        {
+            kame::ogl::setTexture2D(0, item.texture);
+        }
+        if (!item.jointMatrices.empty())
+        {
+            gUBOJoints->setBufferSubData(0, item.jointMatrices.size_bytes(), item.jointMatrices.data());
+            kame::ogl::setUniformBuffer(0, gUBOJoints);
+        }
+        item.vao.drawElements(item.mode, item.count, GL_UNSIGNED_INT);
+    });
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+}
+
+// needs shader storage for the per draw data. the world matrices are uploaded once, so animated models,
+// skinned ones and other modes than triangles stay on the queue
+bool createScenePack(kame::squirtle::Model* model, const std::unordered_map<std::string, kame::squirtle::AnimationClip>& clips)
+{
+    if (!kame::ogl::Context::getInstance().capability.arb_shader_storage_buffer_object || model->isSkinnedMesh() || !clips.empty())
+    {
+        return false;
+    }
+
+    // Node::globalXForm is only valid after an update
+    model->update(gPositions, [](const kame::squirtle::UpdateData&) {});
+    kame::squirtle::ScenePack pack = kame::squirtle::packScene(*model);
+    if (pack.draws.empty() || pack.numSkipped > 0)
+    {
+        return false;
+    }
+
+    std::vector<float> drawIDs(pack.draws.size());
+    std::vector<PackDraw> draws(pack.draws.size());
+    std::vector<kame::ogl::DrawElementsIndirectCommand> commands(pack.draws.size());
+    for (size_t i = 0; i < pack.draws.size(); ++i)
+    {
+        const kame::squirtle::ScenePack::Draw& d = pack.draws[i];
+        kame::ogl::Texture2D* texture = nullptr;
+        draws[i].world = model->nodes[d.node].globalXForm;
+        draws[i].baseColorFactor = Vector4(1.0f, 1.0f, 1.0f, 1.0f);
+        if (d.material >= 0)
+        {
+            const kame::squirtle::Material& mat = model->materials[d.material];
+            draws[i].baseColorFactor = mat.baseColorFactor;
+            if (mat.baseColorTextureIndex >= 0)
+            {
+                texture = gTextures[mat.baseColorTextureIndex];
+            }
+        }
+        drawIDs[i] = float(i);
+        commands[i] = {d.indexCount, 1, d.firstIndex, d.baseVertex, GLuint(i)};
+
+        // draws are ordered by material, a texture shared by several materials may start more than one group
+        if (gPack.groups.empty() || gPack.groups.back().texture != texture)
+        {
+            gPack.groups.push_back({texture, GLsizei(i), 0});
+        }
+        ++gPack.groups.back().count;
+    }
+    gPack.numDraws = GLsizei(pack.draws.size());
+
+    gPack.positions = kame::ogl::createVertexBuffer(pack.positions.size() * sizeof(Vector3), GL_STATIC_DRAW);
+    gPack.positions->setBuffer(pack.positions);
+    gPack.uvs = kame::ogl::createVertexBuffer(pack.uvs.size() * sizeof(Vector2), GL_STATIC_DRAW);
+    gPack.uvs->setBuffer(pack.uvs);
+    gPack.drawIDs = kame::ogl::createVertexBuffer(drawIDs.size() * sizeof(float), GL_STATIC_DRAW);
+    gPack.drawIDs->setBuffer(drawIDs.data());
+    gPack.indices = kame::ogl::createIndexBuffer(pack.indices.size() * sizeof(unsigned int), GL_STATIC_DRAW);
+    gPack.indices->setBuffer(pack.indices);
+    gPack.commands = kame::ogl::createIndirectBuffer(GL_STATIC_DRAW);
+    gPack.commands->setBuffer(commands);
+    gPack.draws = kame::ogl::createShaderStorageBuffer(draws.size() * sizeof(PackDraw), GL_STATIC_DRAW);
+    gPack.draws->setBuffer(draws.data());
+
+    gPack.vao.begin()
+        .bindAttribute(gPack.positions, 0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), 0)
+        .bindAttribute(gPack.uvs, 1, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), 0)
+        .bindAttribute(gPack.drawIDs, 2, 1, GL_FLOAT, GL_FALSE, sizeof(float), 0, 1)
+        .bindIndexBuffer(gPack.indices)
         .end();
-    vao.drawElements(pri.mode, pri.getIndices().size(), GL_UNSIGNED_INT);
+
+    gShaderPack = kame::ogl::createShader(vertPackGLSL, fragGLSL);
+    gShaderPackTexture = kame::ogl::createShader(vertPackGLSL, fragPackTexGLSL);
+    gShaderPackDrawLines = kame::ogl::createShader(vertPackGLSL, drawLinesGLSL);
+    return true;
+}
+
+// one indirect multi draw per texture group for the fill pass, one over all draws for the edge lines
+void drawScenePack()
+{
+    kame::ogl::setShaderStorageBuffer(0, gPack.draws);
+    for (const auto& group : gPack.groups)
+    {
+        if (group.texture)
+        {
+            kame::ogl::setShader(gShaderPackTexture);
+            kame::ogl::setTexture2D(0, group.texture);
+        }
+        else
+        {
+            kame::ogl::setShader(gShaderPack);
+        }
+        gPack.vao.multiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, gPack.commands, group.first, group.count);
+    }
+
+    beginEdgeLines();
+    kame::ogl::setShader(gShaderPackDrawLines);
+    gPack.vao.multiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, gPack.commands, 0, gPack.numDraws);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+}
+
+void deleteScenePack()
+{
+    kame::ogl::deleteVertexBuffer(gPack.positions);
+    kame::ogl::deleteVertexBuffer(gPack.uvs);
+    kame::ogl::deleteVertexBuffer(gPack.drawIDs);
+    kame::ogl::deleteIndexBuffer(gPack.indices);
+    kame::ogl::deleteIndirectBuffer(gPack.commands);
+    kame::ogl::deleteShaderStorageBuffer(gPack.draws);
+    for (auto* shader : {gShaderPack, gShaderPackTexture, gShaderPackDrawLines})
+    {
+        kame::ogl::deleteShader(shader);
+    }
 }
 
 void loadTextures(const kame::gltf::Gltf* gltf)
@@ -205,7 +568,7 @@ void loadTextures(const kame::gltf::Gltf* gltf)
             assert(img.hasBufferView);
             auto& bv = gltf->bufferViews[img.bufferView];
             auto& b = gltf->buffers[bv.buffer];
-            tex = kame::ogl::loadTexture2DFromMemory(b.data(), b.byteLength);
+            tex = kame::ogl::loadTexture2DFromMemory(b.data() + bv.byteOffset, bv.byteLength);
         }
 
         if (t.hasSampler)
@@ -256,7 +619,7 @@ int main(int argc, char** argv)
 {
     if (argc < 2)
     {
-        fprintf(stderr, "modelview: require *.gltf\n");
+        fprintf(stderr, "modelview: require *.gltf or *.glb\n");
         return 1;
     }
 
@@ -264,7 +627,7 @@ int main(int argc, char** argv)
 
     kame::sdl::WindowOGL win;
     win.setOglDebugMode(true);
-    win.setGLVersions({{3, 3, false}});
+    win.setGLVersions({{4, 3, false}, {3, 3, false}});
     win.setWindowFlags(SDL_WINDOW_RESIZABLE);
     win.openWindow("modelview", 1280, 720);
     win.setVsync(true);
@@ -288,9 +651,8 @@ int main(int argc, char** argv)
     clips = importAnimation(gltf);
     kame::gltf::deleteGLTF(gltf);
 
-    size_t numPos = 0;
-    size_t numUV = 0;
-    size_t numIndex = 0;
+    // everything one frame uploads, the fill and the edge pass share it
+    size_t numStreamBytes = 0;
     for (auto& n : model->nodes)
     {
         if (n.meshID < 0)
@@ -301,35 +663,63 @@ int main(int argc, char** argv)
         Mesh& srcMesh = model->meshes[n.meshID];
         for (Primitive& pri : srcMesh.primitives)
         {
-            numPos = std::max(numPos, pri.getBytesOfPositions());
+            size_t bytes = pri.getBytesOfPositions() + pri.getBytesOfIndices() + 3 * 16;
             if (!pri.uvSets.empty())
             {
-                numUV = std::max(numUV, pri.getBytesOfUV(0));
+                bytes += pri.getBytesOfUV(0);
             }
-            numIndex = std::max(numIndex, pri.getBytesOfIndices());
+            numStreamBytes += bytes;
             if (gPositions.size() < pri.getPositions().size())
             {
                 gPositions.resize(pri.getPositions().size());
             }
-            if (!pri.uvSets.empty() && gUV.size() < pri.getUvSets()[0].size())
-            {
-                gUV.resize(pri.getUvSets()[0].size());
-            }
-            if (gIndices.size() < pri.getIndices().size())
-            {
-                gIndices.resize(pri.getIndices().size());
-            }
         }
     }
 
-    gVBO = kame::ogl::createVertexBuffer(numPos, GL_STREAM_DRAW);
-    gVBOTexCoord = kame::ogl::createVertexBuffer(numUV, GL_STREAM_DRAW);
-    gIBO = kame::ogl::createIndexBuffer(numIndex, GL_STREAM_DRAW);
+    // a model without meshes never draws through it
+    if (numStreamBytes > 0)
+    {
+        gStream = kame::ogl::createStreamingBuffer(numStreamBytes);
+    }
 
     gShaderFrontFace = kame::ogl::createShader(vertGLSL, fragGLSL);
     gShaderTexture = kame::ogl::createShader(vertTexGLSL, fragTexGLSL);
     gShaderDrawLines = kame::ogl::createShader(vertGLSL, drawLinesGLSL);
 
+    // skinned meshes keep their vertices on the GPU and only upload joint matrices
+    if (model->isSkinnedMesh())
+    {
+        model->skinningMode = kSKINNING_GPU;
+        gShaderSkin = kame::ogl::createShader(vertSkinGLSL, fragGLSL);
+        gShaderSkinTexture = kame::ogl::createShader(vertSkinGLSL, fragTexGLSL);
+        gShaderSkinDrawLines = kame::ogl::createShader(vertSkinGLSL, drawLinesGLSL);
+        for (auto* shader : {gShaderSkin, gShaderSkinTexture, gShaderSkinDrawLines})
+        {
+            shader->setUniformBlockBinding("Joints", 0);
+        }
+        gUBOJoints = kame::ogl::createUniformBuffer(sizeof(Matrix) * kMAX_GPU_JOINTS, GL_STREAM_DRAW);
+
+        uint32_t attributes = vertexAttributeBit(kVERTEX_ATTRIBUTE_POSITION) | vertexAttributeBit(kVERTEX_ATTRIBUTE_UV0) | vertexAttributeBit(kVERTEX_ATTRIBUTE_JOINTS) | vertexAttributeBit(kVERTEX_ATTRIBUTE_WEIGHTS);
+        for (auto& mesh : model->meshes)
+        {
+            for (auto& pri : mesh.primitives)
+            {
+                if (gSkinnedPrimitives.size() <= size_t(pri.id))
+                {
+                    gSkinnedPrimitives.resize(pri.id + 1);
+                }
+                SkinnedPrimitive& sp = gSkinnedPrimitives[pri.id];
+                sp.packed = packVertices(pri, attributes);
+                sp.vbo = kame::ogl::createVertexBuffer(sp.packed.data.size(), GL_STATIC_DRAW);
+                sp.vbo->setBuffer(sp.packed.data.data());
+                sp.ibo = kame::ogl::createIndexBuffer(pri.getBytesOfIndices(), GL_STATIC_DRAW);
+                sp.ibo->setBuffer(pri.getIndices());
+            }
+        }
+    }
+
+    bool isScenePack = createScenePack(model, clips);
+
     // for turntable rotation
     kame::squirtle::CameraOrbit orbitCamera(kame::math::helper::toRadians(90.0f), 1280.0f, 720.0f);
 
@@ -361,6 +751,19 @@ int main(int argc, char** argv)
         // ImGui::ShowDemoWindow();
 
         ImGui::ListBox(fmt::format("{} clips", items.size()).data(), &itemSelect, items.data(), items.size(), 10);
+        auto& stateStats = kame::ogl::Context::getInstance().stateStats;
+        ImGui::Text("GL state calls %llu, skipped %llu", (unsigned long long)stateStats.issued, (unsigned long long)stateStats.skipped);
+        stateStats = {};
+        if (isScenePack)
+        {
+            ImGui::Text("scene pack: %d draws in %zu indirect calls", int(gPack.numDraws), gPack.groups.size() + 1);
+        }
+        else
+        {
+            auto& renderStats = gRenderQueue.stats;
+            ImGui::Text("draws %llu, shader %llu, material %llu, texture %llu changes", (unsigned long long)renderStats.draws, (unsigned long long)renderStats.shaderChanges, (unsigned long long)renderStats.materialChanges, (unsigned long long)renderStats.textureChanges);
+            renderStats = {};
+        }
         if (itemCurrent != itemSelect)
         {
             itemCurrent = itemSelect;
@@ -373,7 +776,7 @@ int main(int argc, char** argv)
         if (activeClip)
         {
             playTime += dt;
-            playTime = kame::squirtle::animate(*activeClip, model->nodes, playTime);
+            playTime = kame::squirtle::animate(*activeClip, *model, playTime);
         }
 
         bool isHover = ImGui::IsItemHovered() || ImGui::IsWindowHovered();
@@ -409,21 +812,34 @@ int main(int argc, char** argv)
         gShaderDrawLines->setMatrix("uView", orbitCamera.getViewMatrix());
         gShaderDrawLines->setMatrix("uProj", orbitCamera.getProjectionMatrix());
         gShaderDrawLines->setMatrix("uModel", orbitCamera.getModelMatrix());
+        for (auto* shader : {gShaderSkin, gShaderSkinTexture, gShaderSkinDrawLines, gShaderPack, gShaderPackTexture, gShaderPackDrawLines})
+        {
+            if (shader)
+            {
+                kame::ogl::setShader(shader);
+                shader->setMatrix("uView", orbitCamera.getViewMatrix());
+                shader->setMatrix("uProj", orbitCamera.getProjectionMatrix());
+                shader->setMatrix("uModel", orbitCamera.getModelMatrix());
+            }
+        }
 
-        isEdgeLines = false;
-        model->update(gPositions, drawModel);
-
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-        glDepthMask(GL_FALSE);
-        glEnable(GL_POLYGON_OFFSET_LINE);
-        glPolygonOffset(0.0f, -40.0f);
-        depthState = kame::ogl::DepthStencilStateBuilder()
-                         .depthFunc(GL_LEQUAL)
-                         .build();
-        kame::ogl::setDepthStencilState(depthState);
-        isEdgeLines = true;
-        model->update(gPositions, drawModel);
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        if (isScenePack)
+        {
+            drawScenePack();
+        }
+        else
+        {
+            model->frustum = orbitCamera.getFrustum();
+            gModelView = orbitCamera.getModelMatrix() * orbitCamera.getViewMatrix();
+            gRenderQueue.clear();
+            gNumDrawItems = 0;
+            model->update(gPositions, collectModel);
+            submitDraws();
+            if (gStream)
+            {
+                gStream->nextFrame();
+            }
+        }
 
         ImGui::Render();
         ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
@@ -436,10 +852,35 @@ int main(int argc, char** argv)
         kame::ogl::deleteTexture2D(tex);
     }
 
-    kame::ogl::deleteVertexBuffer(gVBO);
-    kame::ogl::deleteVertexBuffer(gVBOTexCoord);
-    kame::ogl::deleteIndexBuffer(gIBO);
+    for (auto& sp : gSkinnedPrimitives)
+    {
+        if (sp.vbo)
+        {
+            kame::ogl::deleteVertexBuffer(sp.vbo);
+            kame::ogl::deleteIndexBuffer(sp.ibo);
+        }
+    }
+    if (gUBOJoints)
+    {
+        kame::ogl::deleteUniformBuffer(gUBOJoints);
+    }
+
+    if (isScenePack)
+    {
+        deleteScenePack();
+    }
+    if (gStream)
+    {
+        kame::ogl::deleteStreamingBuffer(gStream);
+    }
 
+    for (auto* shader : {gShaderSkin, gShaderSkinTexture, gShaderSkinDrawLines})
+    {
+        if (shader)
+        {
+            kame::ogl::deleteShader(shader);
+        }
+    }
     kame::ogl::deleteShader(gShaderDrawLines);
     kame::ogl::deleteShader(gShaderTexture);
     kame::ogl::deleteShader(gShaderFrontFace);